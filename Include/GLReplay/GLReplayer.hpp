@@ -0,0 +1,149 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/GLCapture.hpp>
+#include <OpenGLTest/GLCaptureReader.hpp>
+
+#include <glad/glad.h>
+
+#include <array>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace OGLTest {
+    struct ReplaySettings {
+        // glFinish after each draw, so the time of a draw includes its rasterization instead of landing on a later
+        // call that waits for it. Slower, the GPU doesn't overlap with the CPU anymore.
+        bool SyncDraws = false;
+        // Also accumulates the calls of the loading in the per-command timings.
+        bool TimeLoading = false;
+    };
+
+    struct CommandTiming {
+        UInt64 Count = 0;
+        // Calls setting a state to the value it already had.
+        UInt64 Redundant = 0;
+        Float64 TotalMs = 0.0;
+        Float64 MaxMs = 0.0;
+    };
+
+    struct ReplayFrameStats {
+        GLCallStats Calls;
+        UInt32 RedundantCalls = 0;
+        // Time spent in the GL calls, and from the first call to the end of a glFinish after the last one.
+        Float64 CallMs = 0.0;
+        Float64 FrameMs = 0.0;
+    };
+
+    // Re-executes a capture on the current context, mapping the recorded object names, locations and syncs to the
+    // ones of this context. The default framebuffer of the capture is replaced with an offscreen one of the same
+    // size, so the replay runs without a window. Every call is timed, and the state changes that set a value the
+    // state already had are counted as redundant.
+    class GLReplayer {
+    public:
+        explicit GLReplayer(const ReplaySettings& settings = ReplaySettings{});
+        ~GLReplayer();
+
+        GLReplayer(const GLReplayer&) = delete;
+        GLReplayer(GLReplayer&&) = delete;
+
+        GLReplayer& operator=(const GLReplayer&) = delete;
+        GLReplayer& operator=(GLReplayer&&) = delete;
+
+        // The GL functions must be loaded and a 3.3 core context current.
+        bool Open(const std::filesystem::path& path);
+        // Returns false if the capture is truncated or invalid, the frames replayed until then are still reported.
+        bool Replay();
+
+        [[nodiscard]] inline const CaptureFileHeader& GetHeader() const;
+        // The loading first, then the frames.
+        [[nodiscard]] inline std::span<const ReplayFrameStats> GetFrames() const;
+        // Indexed by GLCommand, over the frames (and the loading with ReplaySettings::TimeLoading).
+        [[nodiscard]] inline std::span<const CommandTiming> GetCommandTimings() const;
+        // Calls using a name the capture never created, which usually means it was created before the recording.
+        [[nodiscard]] inline UInt64 GetUnknownNames() const;
+
+    private:
+        using NameMap = std::unordered_map<GLuint, GLuint>;
+
+        // A tracked state: the command setting it and what it applies to (a target, a unit, an object...).
+        struct StateKey {
+            GLCommand Command;
+            UInt64 Key;
+
+            bool operator==(const StateKey& other) const = default;
+        };
+
+        struct StateKeyHash {
+            UInt64 operator()(const StateKey& key) const;
+        };
+
+        ReplaySettings m_Settings;
+        GLCaptureReader m_Reader;
+        std::vector<ReplayFrameStats> m_Frames;
+        std::array<CommandTiming, static_cast<UInt64>(GLCommand::Count)> m_Timings{};
+        UInt64 m_UnknownNames = 0;
+
+        // Stands for the default framebuffer of the capture.
+        GLuint m_Framebuffer = 0;
+        GLuint m_ColorRenderbuffer = 0;
+        GLuint m_DepthRenderbuffer = 0;
+
+        // From the names of the capture to the ones of this context. Shaders and programs share their names.
+        NameMap m_Buffers;
+        NameMap m_Textures;
+        NameMap m_VertexArrays;
+        NameMap m_Framebuffers;
+        NameMap m_Renderbuffers;
+        NameMap m_Queries;
+        NameMap m_Programs;
+        std::unordered_map<UInt64, GLsync> m_Syncs;
+        // Keyed by the recorded program in the high bits and the recorded location or block index in the low ones.
+        std::unordered_map<UInt64, GLint> m_UniformLocations;
+        std::unordered_map<UInt64, GLuint> m_UniformBlocks;
+        // Replay pointer of the buffer mapped on each target.
+        std::unordered_map<GLenum, UInt8*> m_Mappings;
+
+        // The state as the capture set it, with recorded names.
+        std::unordered_map<StateKey, UInt64, StateKeyHash> m_State;
+        // Last values of the uniforms, per recorded program and location.
+        std::unordered_map<UInt64, std::vector<UInt8>> m_UniformValues;
+        GLuint m_Program = 0;
+        GLuint m_VertexArray = 0;
+        GLenum m_ActiveTexture = GL_TEXTURE0;
+        GLuint m_DrawFramebuffer = 0;
+        GLuint m_ReadFramebuffer = 0;
+
+        // The recorded floats, copied to be aligned.
+        std::vector<GLfloat> m_Floats;
+
+        [[nodiscard]] GLuint Remap(const NameMap& names, GLuint name);
+        [[nodiscard]] GLint RemapLocation(GLint location) const;
+        [[nodiscard]] GLenum RemapColorBuffer(GLenum buffer, GLuint framebuffer) const;
+        void GenNames(NameMap& names, void(APIENTRYP generate)(GLsizei, GLuint*));
+        void DeleteNames(NameMap& names, void(APIENTRYP release)(GLsizei, const GLuint*), GLCommand bindCommand);
+
+        // Returns true when the state already had this value, and stores it.
+        bool SetState(GLCommand command, UInt64 key, UInt64 value);
+        [[nodiscard]] std::optional<UInt64> GetInitialState(GLCommand command, UInt64 key) const;
+        // Bindings of a deleted object go back to 0 and the states kept on it are forgotten.
+        void ForgetObject(GLCommand bindCommand, GLuint name);
+        bool SetUniform(GLint location, const void* value, UInt64 size);
+        [[nodiscard]] inline UInt64 GetBoundTexture(GLenum target) const;
+        [[nodiscard]] const GLfloat* ReadFloats();
+
+        // Returns true when the call only set states to the values they already had.
+        bool Execute(GLCommand command, ReplayFrameStats& frame);
+        [[nodiscard]] const void* ReadImage(UInt64& size);
+    };
+}
+
+#include <GLReplay/GLReplayer.inl>
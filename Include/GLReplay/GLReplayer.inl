@@ -0,0 +1,29 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline const CaptureFileHeader& GLReplayer::GetHeader() const {
+        return m_Reader.GetHeader();
+    }
+
+    inline std::span<const ReplayFrameStats> GLReplayer::GetFrames() const {
+        return m_Frames;
+    }
+
+    inline std::span<const CommandTiming> GLReplayer::GetCommandTimings() const {
+        return m_Timings;
+    }
+
+    inline UInt64 GLReplayer::GetUnknownNames() const {
+        return m_UnknownNames;
+    }
+
+    inline UInt64 GLReplayer::GetBoundTexture(const GLenum target) const {
+        const auto binding = m_State.find({GLCommand::BindTexture,
+                                           target | static_cast<UInt64>(m_ActiveTexture - GL_TEXTURE0) << 32});
+        return binding != m_State.end() ? binding->second : 0;
+    }
+}
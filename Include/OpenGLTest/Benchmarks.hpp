@@ -0,0 +1,33 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/JobSystem.hpp>
+
+#include <string>
+
+// The modes of the command line that run instead of the scene, see main. Those using GL expect a current context.
+namespace OGLTest {
+    // Dynamic upload paths of StreamBuffer.
+    void BenchmarkStreamBuffers();
+    // Job system scaling over the worker counts. Returns false when a run computed a wrong result.
+    bool BenchmarkJobs();
+    // Dependencies, stealing, main thread affinity and contention of the job system. Returns false on failure.
+    bool TestJobs();
+    // Native and Assimp loading of a .glb file.
+    void BenchmarkGltf(const std::string& path, JobSystem& jobs);
+    // Build time and ray throughput of the BVH over the triangles of a model and of a synthetic 1M triangles mesh.
+    void BenchmarkBvh(const std::string& modelPath, JobSystem& jobs);
+    // Streams a synthetic chunk file along a camera path and checks the budgets and residency counts every frame.
+    // Returns false on failure.
+    bool TestStreaming(JobSystem& jobs);
+
+    // Splits the meshes of a model, in world space, into a chunk file of cellSize wide chunks.
+    bool ChunkModel(const std::string& modelPath, const std::string& chunkPath, Float32 cellSize, JobSystem& jobs);
+}
+
+#include <OpenGLTest/Benchmarks.inl>
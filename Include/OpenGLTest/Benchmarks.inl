@@ -4,10 +4,5 @@
 
 #pragma once
 
-#include <OpenGLTest/pch.hpp>
-
 namespace OGLTest {
-    inline UInt32 LoadTextureFromFile(const char* path, const std::string& directory, bool gamma = false);
 }
-
-#include <OpenGLTest/TextureUtils.inl>
@@ -0,0 +1,71 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <limits>
+
+namespace OGLTest {
+    constexpr Float32 g_Infinity = std::numeric_limits<Float32>::infinity();
+
+    // Axis aligned bounding box. A default constructed box is empty and grows with Extend.
+    struct BoundingBox {
+        glm::vec3 Min = glm::vec3(g_Infinity);
+        glm::vec3 Max = glm::vec3(-g_Infinity);
+
+        inline void Extend(const glm::vec3& point);
+        inline void Extend(const BoundingBox& box);
+
+        [[nodiscard]] inline bool IsEmpty() const;
+        [[nodiscard]] inline glm::vec3 GetCenter() const;
+        [[nodiscard]] inline glm::vec3 GetExtent() const;
+        [[nodiscard]] inline Float32 GetSurfaceArea() const;
+
+        // Returns the box enclosing this one once transformed by the given matrix.
+        [[nodiscard]] inline BoundingBox Transform(const glm::mat4& transform) const;
+    };
+
+    struct Ray {
+        glm::vec3 Origin;
+        // Not necessarily normalized, hit distances are expressed in multiples of it.
+        glm::vec3 Direction;
+
+        [[nodiscard]] inline glm::vec3 GetPoint(Float32 distance) const;
+        [[nodiscard]] inline Ray Transform(const glm::mat4& transform) const;
+    };
+
+    struct RayHit {
+        Float32 Distance = g_Infinity;
+        // Index of the mesh/primitive that was hit, set by the query that produced the hit.
+        UInt32 MeshIndex = std::numeric_limits<UInt32>::max();
+        UInt32 TriangleIndex = std::numeric_limits<UInt32>::max();
+
+        [[nodiscard]] inline bool HasHit() const;
+    };
+
+    // The six planes of a view frustum, pointing inwards, stored as (normal, distance).
+    struct Frustum {
+        std::array<glm::vec4, 6> Planes;
+
+        // Extracts the planes from a projection * view matrix.
+        [[nodiscard]] static inline Frustum FromMatrix(const glm::mat4& viewProjection);
+
+        [[nodiscard]] inline bool Intersects(const BoundingBox& box) const;
+    };
+
+    // Slab test. Returns the entry distance or g_Infinity when the ray misses the box before maxDistance.
+    [[nodiscard]] inline Float32 IntersectRayBox(const glm::vec3& origin, const glm::vec3& inverseDirection,
+                                                 const BoundingBox& box, Float32 maxDistance);
+
+    // Möller-Trumbore test. Returns the hit distance or g_Infinity when the ray misses the triangle.
+    [[nodiscard]] inline Float32 IntersectRayTriangle(const Ray& ray, const glm::vec3& v0, const glm::vec3& v1,
+                                                      const glm::vec3& v2);
+}
+
+#include <OpenGLTest/BoundingVolumes.inl>
@@ -0,0 +1,153 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace OGLTest {
+    inline void BoundingBox::Extend(const glm::vec3& point) {
+        Min = glm::min(Min, point);
+        Max = glm::max(Max, point);
+    }
+
+    inline void BoundingBox::Extend(const BoundingBox& box) {
+        Min = glm::min(Min, box.Min);
+        Max = glm::max(Max, box.Max);
+    }
+
+    inline bool BoundingBox::IsEmpty() const {
+        return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z;
+    }
+
+    inline glm::vec3 BoundingBox::GetCenter() const {
+        return (Min + Max) * 0.5f;
+    }
+
+    inline glm::vec3 BoundingBox::GetExtent() const {
+        return Max - Min;
+    }
+
+    inline Float32 BoundingBox::GetSurfaceArea() const {
+        if (IsEmpty()) {
+            return 0.0f;
+        }
+
+        const glm::vec3 extent = GetExtent();
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    inline BoundingBox BoundingBox::Transform(const glm::mat4& transform) const {
+        if (IsEmpty()) {
+            return *this;
+        }
+
+        // Arvo's method: each matrix element pushes the new bounds towards the min or the max of the old ones.
+        BoundingBox result;
+        result.Min = glm::vec3(transform[3]);
+        result.Max = glm::vec3(transform[3]);
+
+        for (Int32 column = 0; column < 3; column++) {
+            for (Int32 row = 0; row < 3; row++) {
+                const Float32 a = transform[column][row] * Min[column];
+                const Float32 b = transform[column][row] * Max[column];
+                result.Min[row] += std::min(a, b);
+                result.Max[row] += std::max(a, b);
+            }
+        }
+
+        return result;
+    }
+
+    inline glm::vec3 Ray::GetPoint(const Float32 distance) const {
+        return Origin + Direction * distance;
+    }
+
+    inline Ray Ray::Transform(const glm::mat4& transform) const {
+        return Ray{glm::vec3(transform * glm::vec4(Origin, 1.0f)), glm::vec3(transform * glm::vec4(Direction, 0.0f))};
+    }
+
+    inline bool RayHit::HasHit() const {
+        return Distance != g_Infinity;
+    }
+
+    inline Frustum Frustum::FromMatrix(const glm::mat4& viewProjection) {
+        // Gribb-Hartmann extraction, glm matrices are indexed [column][row].
+        glm::vec4 rows[4];
+        for (Int32 row = 0; row < 4; row++) {
+            rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row],
+                                  viewProjection[3][row]);
+        }
+
+        Frustum frustum;
+        frustum.Planes[0] = rows[3] + rows[0]; // Left
+        frustum.Planes[1] = rows[3] - rows[0]; // Right
+        frustum.Planes[2] = rows[3] + rows[1]; // Bottom
+        frustum.Planes[3] = rows[3] - rows[1]; // Top
+        frustum.Planes[4] = rows[3] + rows[2]; // Near
+        frustum.Planes[5] = rows[3] - rows[2]; // Far
+
+        for (auto& plane : frustum.Planes) {
+            plane = plane / glm::length(glm::vec3(plane));
+        }
+
+        return frustum;
+    }
+
+    inline bool Frustum::Intersects(const BoundingBox& box) const {
+        for (const auto& plane : Planes) {
+            // Only the corner furthest along the plane normal needs to be tested.
+            const glm::vec3 positive(plane.x >= 0.0f ? box.Max.x : box.Min.x,
+                                     plane.y >= 0.0f ? box.Max.y : box.Min.y,
+                                     plane.z >= 0.0f ? box.Max.z : box.Min.z);
+
+            if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    inline Float32 IntersectRayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const BoundingBox& box,
+                                   const Float32 maxDistance) {
+        const glm::vec3 t0 = (box.Min - origin) * inverseDirection;
+        const glm::vec3 t1 = (box.Max - origin) * inverseDirection;
+
+        const Float32 tNear = std::max({std::min(t0.x, t1.x), std::min(t0.y, t1.y), std::min(t0.z, t1.z), 0.0f});
+        const Float32 tFar = std::min({std::max(t0.x, t1.x), std::max(t0.y, t1.y), std::max(t0.z, t1.z), maxDistance});
+
+        return tNear <= tFar ? tNear : g_Infinity;
+    }
+
+    inline Float32 IntersectRayTriangle(const Ray& ray, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) {
+        constexpr Float32 epsilon = 1e-7f;
+
+        const glm::vec3 edge1 = v1 - v0;
+        const glm::vec3 edge2 = v2 - v0;
+        const glm::vec3 p = glm::cross(ray.Direction, edge2);
+        const Float32 determinant = glm::dot(edge1, p);
+
+        if (std::abs(determinant) < epsilon) {
+            return g_Infinity;
+        }
+
+        const Float32 inverseDeterminant = 1.0f / determinant;
+        const glm::vec3 s = ray.Origin - v0;
+        const Float32 u = glm::dot(s, p) * inverseDeterminant;
+        if (u < 0.0f || u > 1.0f) {
+            return g_Infinity;
+        }
+
+        const glm::vec3 q = glm::cross(s, edge1);
+        const Float32 v = glm::dot(ray.Direction, q) * inverseDeterminant;
+        if (v < 0.0f || u + v > 1.0f) {
+            return g_Infinity;
+        }
+
+        const Float32 distance = glm::dot(edge2, q) * inverseDeterminant;
+        return distance > epsilon ? distance : g_Infinity;
+    }
+}
@@ -0,0 +1,81 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/BoundingVolumes.hpp>
+#include <OpenGLTest/JobSystem.hpp>
+
+#include <span>
+#include <vector>
+
+namespace OGLTest {
+    constexpr UInt32 g_BvhBinCount = 16;
+    constexpr UInt32 g_BvhMaxLeafSize = 4;
+    // Keeps the fixed size traversal stacks from overflowing on degenerate inputs.
+    constexpr UInt32 g_BvhMaxDepth = 48;
+    // Above this primitive count, frustum queries given a job system traverse subtrees in parallel.
+    constexpr UInt32 g_BvhParallelQueryThreshold = 4096;
+
+    // 32 bytes node, two of them fit in a cache line.
+    struct BvhNode {
+        BoundingBox Bounds;
+        // Index of the left child for inner nodes (the right one follows it), of the first primitive for leaves.
+        UInt32 LeftFirst;
+        // Number of primitives, 0 for inner nodes.
+        UInt32 Count;
+
+        [[nodiscard]] inline bool IsLeaf() const;
+    };
+
+    // Bounding volume hierarchy over arbitrary primitives described by their bounding boxes.
+    // It is built with a binned surface area heuristic and stored as a flat node array, the root being node 0.
+    class Bvh {
+    public:
+        Bvh() = default;
+        ~Bvh() = default;
+
+        Bvh(const Bvh&) = delete;
+        Bvh(Bvh&&) = default;
+
+        Bvh& operator=(const Bvh&) = delete;
+        Bvh& operator=(Bvh&&) = default;
+
+        void Build(std::span<const BoundingBox> primitiveBounds);
+
+        // Recomputes the node bounds for moved primitives while keeping the topology.
+        // Cheaper than Build but the tree quality degrades if primitives move a lot.
+        void Refit(std::span<const BoundingBox> primitiveBounds);
+
+        [[nodiscard]] inline bool IsEmpty() const;
+        [[nodiscard]] inline const BoundingBox& GetBounds() const;
+        [[nodiscard]] inline std::span<const BvhNode> GetNodes() const;
+        [[nodiscard]] inline UInt64 GetMemoryUsage() const;
+
+        // Calls visitor(primitiveIndex) for every primitive whose bounding box intersects the frustum.
+        template<typename Visitor>
+        void QueryFrustum(const Frustum& frustum, Visitor&& visitor) const;
+        // Appends the primitives intersecting the frustum, splitting large trees between the jobs.
+        void QueryFrustum(const Frustum& frustum, JobSystem& jobs, std::vector<UInt32>& primitiveIndices) const;
+
+        // Visits the primitives the ray may hit, nearest nodes first. intersect(primitiveIndex, closestDistance) must
+        // return the hit distance (g_Infinity if none); it is used to shrink the search, the nearest one is returned.
+        template<typename Intersector>
+        Float32 Raycast(const Ray& ray, Intersector&& intersect, Float32 maxDistance = g_Infinity) const;
+
+    private:
+        std::vector<BvhNode> m_Nodes;
+        std::vector<UInt32> m_PrimitiveIndices;
+
+        void Subdivide(UInt32 nodeIndex, UInt32 depth, std::span<const BoundingBox> primitiveBounds,
+                       std::span<const glm::vec3> centroids);
+        void UpdateNodeBounds(UInt32 nodeIndex, std::span<const BoundingBox> primitiveBounds);
+        template<typename Visitor>
+        void QuerySubtree(UInt32 rootIndex, const Frustum& frustum, Visitor&& visitor) const;
+    };
+}
+
+#include <OpenGLTest/Bvh.inl>
@@ -0,0 +1,114 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <algorithm>
+#include <utility>
+
+namespace OGLTest {
+    inline bool BvhNode::IsLeaf() const {
+        return Count > 0;
+    }
+
+    inline bool Bvh::IsEmpty() const {
+        return m_Nodes.empty();
+    }
+
+    inline const BoundingBox& Bvh::GetBounds() const {
+        return m_Nodes.front().Bounds;
+    }
+
+    inline std::span<const BvhNode> Bvh::GetNodes() const {
+        return m_Nodes;
+    }
+
+    inline UInt64 Bvh::GetMemoryUsage() const {
+        return m_Nodes.capacity() * sizeof(BvhNode) + m_PrimitiveIndices.capacity() * sizeof(UInt32);
+    }
+
+    template<typename Visitor>
+    void Bvh::QueryFrustum(const Frustum& frustum, Visitor&& visitor) const {
+        if (IsEmpty()) {
+            return;
+        }
+
+        QuerySubtree(0, frustum, visitor);
+    }
+
+    template<typename Intersector>
+    Float32 Bvh::Raycast(const Ray& ray, Intersector&& intersect, const Float32 maxDistance) const {
+        Float32 closest = maxDistance;
+
+        if (IsEmpty()) {
+            return closest;
+        }
+
+        const glm::vec3 inverseDirection = glm::vec3(1.0f) / ray.Direction;
+
+        if (IntersectRayBox(ray.Origin, inverseDirection, m_Nodes[0].Bounds, closest) == g_Infinity) {
+            return closest;
+        }
+
+        UInt32 stack[64];
+        UInt32 stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0) {
+            const BvhNode& node = m_Nodes[stack[--stackSize]];
+
+            if (node.IsLeaf()) {
+                for (UInt32 i = 0; i < node.Count; i++) {
+                    closest = std::min(closest, intersect(m_PrimitiveIndices[node.LeftFirst + i], closest));
+                }
+                continue;
+            }
+
+            UInt32 nearChild = node.LeftFirst;
+            UInt32 farChild = node.LeftFirst + 1;
+            Float32 nearDistance = IntersectRayBox(ray.Origin, inverseDirection, m_Nodes[nearChild].Bounds, closest);
+            Float32 farDistance = IntersectRayBox(ray.Origin, inverseDirection, m_Nodes[farChild].Bounds, closest);
+
+            if (farDistance < nearDistance) {
+                std::swap(nearChild, farChild);
+                std::swap(nearDistance, farDistance);
+            }
+
+            // Push the far child first so the near one is visited first and shrinks `closest` early.
+            if (farDistance != g_Infinity) {
+                stack[stackSize++] = farChild;
+            }
+
+            if (nearDistance != g_Infinity) {
+                stack[stackSize++] = nearChild;
+            }
+        }
+
+        return closest;
+    }
+
+    template<typename Visitor>
+    void Bvh::QuerySubtree(const UInt32 rootIndex, const Frustum& frustum, Visitor&& visitor) const {
+        UInt32 stack[64];
+        UInt32 stackSize = 0;
+        stack[stackSize++] = rootIndex;
+
+        while (stackSize > 0) {
+            const BvhNode& node = m_Nodes[stack[--stackSize]];
+
+            if (!frustum.Intersects(node.Bounds)) {
+                continue;
+            }
+
+            if (node.IsLeaf()) {
+                for (UInt32 i = 0; i < node.Count; i++) {
+                    visitor(m_PrimitiveIndices[node.LeftFirst + i]);
+                }
+            } else {
+                stack[stackSize++] = node.LeftFirst;
+                stack[stackSize++] = node.LeftFirst + 1;
+            }
+        }
+    }
+}
@@ -6,6 +6,8 @@
 
 #include <OpenGLTest/pch.hpp>
 
+#include <OpenGLTest/BoundingVolumes.hpp>
+
 #include <glad/glad.h>
 
 #include <glm/glm.hpp>
@@ -63,6 +65,9 @@ namespace OGLTest {
         // returns the view matrix calculated using Euler Angles and the LookAt Matrix
         inline glm::mat4 GetViewMatrix() const;
 
+        // returns the world space ray going through a point of the viewport, in pixels from the top left corner. Used for picking
+        [[nodiscard]] Ray ScreenPointToRay(Float32 x, Float32 y, Float32 viewportWidth, Float32 viewportHeight) const;
+
         // processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
         void ProcessKeyboard(CameraMovement direction, Float32 deltaTime);
 
@@ -0,0 +1,60 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/BoundingVolumes.hpp>
+#include <OpenGLTest/Mesh.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
+
+namespace OGLTest {
+    // Packed chunk file layout (native endianness):
+    //   ChunkFileHeader
+    //   ChunkDesc[ChunkCount]
+    //   for each chunk: Vertex[VertexCount] followed by UInt32[IndexCount], starting at ChunkDesc::Offset
+    // Only the header and the table have to be read up front, chunks are then loaded independently.
+    constexpr UInt32 g_ChunkFileMagic = 0x434C474F; // "OGLC"
+    constexpr UInt32 g_ChunkFileVersion = 1;
+
+    struct ChunkFileHeader {
+        UInt32 Magic;
+        UInt32 Version;
+        UInt32 ChunkCount;
+        UInt32 Reserved;
+    };
+
+    struct ChunkDesc {
+        BoundingBox Bounds;
+        UInt32 VertexCount;
+        UInt32 IndexCount;
+        UInt64 Offset;
+
+        [[nodiscard]] inline UInt64 GetDataSize() const;
+    };
+
+    struct ChunkData {
+        std::vector<Vertex> Vertices;
+        std::vector<UInt32> Indices;
+    };
+
+    [[nodiscard]] bool ReadChunkTable(const std::filesystem::path& path, std::vector<ChunkDesc>& chunks);
+    [[nodiscard]] bool ReadChunkData(std::ifstream& file, const ChunkDesc& desc, ChunkData& data);
+
+    // Splits the triangles into chunks on a regular grid of cellSize, by triangle centroid.
+    bool WriteChunkFile(const std::filesystem::path& path, std::span<const Vertex> vertices,
+                        std::span<const UInt32> indices, Float32 cellSize);
+
+    // Writes a gridSize x gridSize terrain made of chunkResolution x chunkResolution quads per chunk.
+    // Chunks are generated and written one at a time, so the file can be much larger than the available memory.
+    bool WriteSyntheticChunkFile(const std::filesystem::path& path, UInt32 gridSize, UInt32 chunkResolution,
+                                 Float32 chunkSize = 16.0f);
+}
+
+#include <OpenGLTest/ChunkFile.inl>
@@ -0,0 +1,11 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline UInt64 ChunkDesc::GetDataSize() const {
+        return static_cast<UInt64>(VertexCount) * sizeof(Vertex) + static_cast<UInt64>(IndexCount) * sizeof(UInt32);
+    }
+}
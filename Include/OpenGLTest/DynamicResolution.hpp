@@ -0,0 +1,112 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/Shader.hpp>
+#include <OpenGLTest/ShadowRenderer.hpp>
+
+#include <glad/glad.h>
+
+#include <array>
+
+namespace OGLTest {
+    // The upscale pass samples the scene from the unit following the shadow maps.
+    constexpr UInt32 g_SceneColorUnit = g_PointShadowUnit + 1;
+    // GPU timer queries in flight, their results are read a few frames late so the CPU never waits on them.
+    constexpr UInt32 g_ResolutionQueryCount = 4;
+
+    enum class UpscaleFilter : UInt8 {
+        Bilinear,
+        // Bilinear followed by an unsharp mask clamped to the neighbourhood.
+        Sharpen
+    };
+
+    struct DynamicResolutionSettings {
+        // When disabled the scene is always rendered at MaxScale.
+        bool Enabled = true;
+        // GPU time budget of a frame, from the start of the scene to the upscale.
+        Float32 TargetFrameMs = 16.0f;
+        // Bounds of the render scale, relative to the window size on each axis.
+        Float32 MinScale = 0.5f;
+        Float32 MaxScale = 1.0f;
+        // Largest change of the scale at once.
+        Float32 MaxScaleStep = 0.1f;
+        // Hysteresis: the scale goes down after DownscaleFrames timings over DownscaleThreshold times the budget,
+        // and up after UpscaleFrames timings under UpscaleThreshold times the budget.
+        Float32 DownscaleThreshold = 0.95f;
+        Float32 UpscaleThreshold = 0.8f;
+        UInt32 DownscaleFrames = 3;
+        UInt32 UpscaleFrames = 30;
+        UpscaleFilter Filter = UpscaleFilter::Sharpen;
+        Float32 Sharpness = 0.4f;
+    };
+
+    struct ResolutionStats {
+        Float32 Scale = 1.0f;
+        Int32 RenderWidth = 0;
+        Int32 RenderHeight = 0;
+        // Smoothed GPU time of the frames rendered at the current scale, 0 until the first timing.
+        Float32 GpuFrameMs = 0.0f;
+    };
+
+    // Renders the scene into an offscreen target at a fraction of the window size and upscales it to the window.
+    // The fraction is adjusted from GPU timer queries to keep the frames within a time budget.
+    class DynamicResolution {
+    public:
+        explicit DynamicResolution(const DynamicResolutionSettings& settings = DynamicResolutionSettings{});
+        ~DynamicResolution();
+
+        DynamicResolution(const DynamicResolution&) = delete;
+        DynamicResolution(DynamicResolution&&) = delete;
+
+        DynamicResolution& operator=(const DynamicResolution&) = delete;
+        DynamicResolution& operator=(DynamicResolution&&) = delete;
+
+        // Starts timing the frame and binds the scene target, width and height being the size of the window.
+        void BeginFrame(Int32 width, Int32 height);
+        // Binds the scene target and its viewport again, after a pass that used another framebuffer.
+        void BindSceneTarget() const;
+        // Upscales the scene to the default framebuffer and stops timing the frame.
+        void Resolve();
+
+        [[nodiscard]] inline const DynamicResolutionSettings& GetSettings() const;
+        [[nodiscard]] inline ResolutionStats GetStats() const;
+
+    private:
+        struct TimerQuery {
+            GLuint Query = 0;
+            // Scale the timed frame was rendered at, timings of an older scale are dropped.
+            Float32 Scale = 0.0f;
+            bool Pending = false;
+        };
+
+        DynamicResolutionSettings m_Settings;
+        Shader m_UpscaleShader;
+        Float32 m_Scale;
+        Float32 m_GpuFrameMs = 0.0f;
+        UInt32 m_OverBudgetFrames = 0;
+        UInt32 m_UnderBudgetFrames = 0;
+
+        std::array<TimerQuery, g_ResolutionQueryCount> m_Queries;
+        UInt32 m_QueryIndex = 0;
+        bool m_Timing = false;
+
+        // The target is allocated at the window size, lower scales render into its bottom left corner.
+        GLuint m_Framebuffer = 0, m_ColorTexture = 0, m_DepthRenderbuffer = 0;
+        GLuint m_EmptyVAO = 0;
+        Int32 m_TargetWidth = 0, m_TargetHeight = 0;
+        Int32 m_OutputWidth = 0, m_OutputHeight = 0;
+        Int32 m_RenderWidth = 0, m_RenderHeight = 0;
+
+        void ResizeTarget(Int32 width, Int32 height);
+        void DestroyTarget();
+        void ReadQueries();
+        void UpdateScale(Float32 gpuFrameMs);
+    };
+}
+
+#include <OpenGLTest/DynamicResolution.inl>
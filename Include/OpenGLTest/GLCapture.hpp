@@ -0,0 +1,227 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <glad/glad.h>
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace OGLTest {
+    // Capture file layout (native endianness):
+    //   CaptureFileHeader
+    //   for each call: UInt16 GLCommand, then its arguments in order, then its result if it has one
+    // Scalars are stored with their own size, object names and locations as the application saw them.
+    // Pointers the GL only uses as values (buffer offsets, syncs) are stored as UInt64, the data behind the
+    // other ones as a UInt64 size followed by the bytes, g_CaptureNullData for a null pointer. Texture data is
+    // preceded by a UInt8, 1 when the pointer is an offset in the bound pixel unpack buffer.
+    // FrameEnd separates the frames, the calls before the first one are the loading.
+    constexpr UInt32 g_CaptureFileMagic = 0x50434C47; // "GLCP"
+    constexpr UInt32 g_CaptureFileVersion = 1;
+    constexpr UInt64 g_CaptureNullData = ~0ull;
+
+    struct CaptureFileHeader {
+        UInt32 Magic;
+        UInt32 Version;
+        // Size of the default framebuffer when the capture started.
+        UInt32 Width;
+        UInt32 Height;
+    };
+
+    // The GL functions going through the capture layer. The values are stored in the captures, only append to it.
+    enum class GLCommand : UInt16 {
+        FrameEnd,
+        ActiveTexture,
+        AttachShader,
+        BeginConditionalRender,
+        BeginQuery,
+        BindBuffer,
+        BindBufferBase,
+        BindBufferRange,
+        BindFramebuffer,
+        BindRenderbuffer,
+        BindTexture,
+        BindVertexArray,
+        BlitFramebuffer,
+        BufferData,
+        BufferStorage,
+        BufferSubData,
+        Clear,
+        ClearColor,
+        ClientWaitSync,
+        ColorMask,
+        CompileShader,
+        CreateProgram,
+        CreateShader,
+        DeleteBuffers,
+        DeleteFramebuffers,
+        DeleteProgram,
+        DeleteQueries,
+        DeleteRenderbuffers,
+        DeleteShader,
+        DeleteSync,
+        DeleteTextures,
+        DeleteVertexArrays,
+        DepthMask,
+        Disable,
+        DrawArrays,
+        DrawBuffer,
+        DrawElements,
+        Enable,
+        EnableVertexAttribArray,
+        EndConditionalRender,
+        EndQuery,
+        FenceSync,
+        Finish,
+        FramebufferRenderbuffer,
+        FramebufferTexture2D,
+        FramebufferTextureLayer,
+        GenBuffers,
+        GenFramebuffers,
+        GenQueries,
+        GenRenderbuffers,
+        GenTextures,
+        GenVertexArrays,
+        GenerateMipmap,
+        GetUniformBlockIndex,
+        GetUniformLocation,
+        LinkProgram,
+        MapBufferRange,
+        PixelStorei,
+        PolygonOffset,
+        ReadBuffer,
+        RenderbufferStorage,
+        ShaderSource,
+        TexImage2D,
+        TexImage3D,
+        TexParameterfv,
+        TexParameteri,
+        TexSubImage2D,
+        TexSubImage3D,
+        Uniform1f,
+        Uniform1i,
+        Uniform2f,
+        Uniform2fv,
+        Uniform3f,
+        Uniform3fv,
+        Uniform4f,
+        Uniform4fv,
+        UniformBlockBinding,
+        UniformMatrix2fv,
+        UniformMatrix3fv,
+        UniformMatrix4fv,
+        UnmapBuffer,
+        UseProgram,
+        VertexAttribPointer,
+        Viewport,
+
+        Count
+    };
+
+    enum class GLCommandKind : UInt8 {
+        Other,
+        // Draws, clears and blits.
+        Draw,
+        // Object and program bindings.
+        Bind,
+        // Calls sending data to a buffer or a texture.
+        Upload
+    };
+
+    struct GLCallStats {
+        UInt32 Calls = 0;
+        UInt32 DrawCalls = 0;
+        UInt32 Binds = 0;
+        UInt64 UploadedBytes = 0;
+    };
+
+    [[nodiscard]] std::string_view GetCommandName(GLCommand command);
+    [[nodiscard]] GLCommandKind GetCommandKind(GLCommand command);
+    // Size of the client memory read by a texture upload of this size, format and type, rows aligned to alignment.
+    [[nodiscard]] UInt64 GetImageSize(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type,
+                                      GLint alignment);
+
+    // Thin dispatch layer over the glad function pointers: while it's alive, the GL calls of the application go
+    // through it. It counts the calls of each frame and, while recording, writes them and the data they read to a
+    // capture file that can be replayed offline. The query functions (glGet*) aren't intercepted.
+    // Only one can exist at a time, and it must be destroyed on a thread without a current context or with the
+    // one it was created with.
+    class GLCapture {
+    public:
+        // The GL functions must be loaded.
+        GLCapture();
+        ~GLCapture();
+
+        GLCapture(const GLCapture&) = delete;
+        GLCapture(GLCapture&&) = delete;
+
+        GLCapture& operator=(const GLCapture&) = delete;
+        GLCapture& operator=(GLCapture&&) = delete;
+
+        // Records the calls until frameCount frames ended after the loading (0 until StopRecording).
+        // width and height are the size of the default framebuffer. Returns false if the file can't be created.
+        bool StartRecording(const std::filesystem::path& path, UInt32 width, UInt32 height, UInt32 frameCount);
+        void StopRecording();
+        // The bindless handles and the persistently mapped buffers are written behind the GL's back and can't be
+        // replayed, the renderer avoids them while recording.
+        [[nodiscard]] static bool IsRecording();
+
+        // Called by the thread owning the context once a frame (or the loading) was issued.
+        void EndFrame();
+
+        // Counters of the last ended frame, safe to call from any thread.
+        [[nodiscard]] GLCallStats GetFrameStats() const;
+
+    private:
+        template<GLCommand Command, typename Function>
+        struct Hook;
+
+        struct Mapping {
+            GLenum Target;
+            const UInt8* Data;
+            GLsizeiptr Length;
+            GLbitfield Access;
+        };
+
+        // Counters of the frame being issued, only touched by the thread owning the context.
+        GLCallStats m_Counters;
+        mutable std::mutex m_StatsMutex;
+        GLCallStats m_FrameStats;
+
+        std::ofstream m_File;
+        std::vector<UInt8> m_Buffer;
+        bool m_Recording = false;
+        UInt32 m_FramesLeft = 0;
+        bool m_StopAfterFrames = false;
+
+        // Tracked to know what the uploads read.
+        GLint m_UnpackAlignment = 4;
+        GLuint m_PixelUnpackBuffer = 0;
+        std::vector<Mapping> m_Mappings;
+
+        void InstallHooks(bool install);
+        template<GLCommand Command, typename Function>
+        static void SwapHook(Function& pointer, bool install);
+
+        inline void Count(GLCommand command);
+        inline void WriteBytes(const void* data, UInt64 size);
+        template<typename T>
+        void Write(T value);
+        void WriteData(const void* data, UInt64 size);
+        void WriteNames(GLCommand command, GLsizei n, const GLuint* names);
+        // Bytes a texture upload reads from client memory, 0 when they come from a pixel unpack buffer.
+        [[nodiscard]] UInt64 GetUploadSize(const void* pixels, GLsizei width, GLsizei height, GLsizei depth,
+                                           GLenum format, GLenum type) const;
+        void WriteImage(const void* pixels, UInt64 size);
+        void Flush();
+    };
+}
+
+#include <OpenGLTest/GLCapture.inl>
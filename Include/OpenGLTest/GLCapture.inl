@@ -0,0 +1,48 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+namespace OGLTest {
+    inline void GLCapture::Count(const GLCommand command) {
+        m_Counters.Calls++;
+
+        switch (GetCommandKind(command)) {
+            case GLCommandKind::Draw: {
+                m_Counters.DrawCalls++;
+                break;
+            }
+            case GLCommandKind::Bind: {
+                m_Counters.Binds++;
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+
+    inline void GLCapture::WriteBytes(const void* data, const UInt64 size) {
+        const UInt64 offset = m_Buffer.size();
+        m_Buffer.resize(offset + size);
+        std::memcpy(m_Buffer.data() + offset, data, size);
+    }
+
+    template<typename T>
+    void GLCapture::Write(const T value) {
+        if constexpr (std::is_pointer_v<T>) {
+            const UInt64 address = reinterpret_cast<UInt64>(value);
+            WriteBytes(&address, sizeof(address));
+        } else if constexpr (std::is_enum_v<T>) {
+            const auto underlying = static_cast<std::underlying_type_t<T>>(value);
+            WriteBytes(&underlying, sizeof(underlying));
+        } else {
+            static_assert(std::is_arithmetic_v<T>, "only scalars and opaque pointers are written as values");
+            WriteBytes(&value, sizeof(value));
+        }
+    }
+}
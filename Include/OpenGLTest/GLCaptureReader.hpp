@@ -0,0 +1,54 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/GLCapture.hpp>
+#include <OpenGLTest/MappedFile.hpp>
+
+#include <filesystem>
+#include <span>
+
+namespace OGLTest {
+    // Reads the calls of a capture written by GLCapture, in order, straight from a mapping of the file.
+    class GLCaptureReader {
+    public:
+        GLCaptureReader() = default;
+        ~GLCaptureReader() = default;
+
+        GLCaptureReader(const GLCaptureReader&) = delete;
+        GLCaptureReader(GLCaptureReader&&) = delete;
+
+        GLCaptureReader& operator=(const GLCaptureReader&) = delete;
+        GLCaptureReader& operator=(GLCaptureReader&&) = delete;
+
+        // Returns false if the file can't be opened or isn't a capture of a supported version.
+        bool Open(const std::filesystem::path& path);
+
+        // Returns false at the end of the capture, or when the capture is truncated or has an unknown command.
+        bool ReadCommand(GLCommand& command);
+        // Arguments of the command just read, in the order they were recorded. Read past the end, they are zero.
+        template<typename T>
+        [[nodiscard]] T Read();
+        // Data recorded behind a pointer, valid as long as the reader is open. Its data() is null for a null pointer.
+        [[nodiscard]] std::span<const UInt8> ReadData();
+
+        [[nodiscard]] inline const CaptureFileHeader& GetHeader() const;
+        // Set once a read went past the end of the file or met an unknown command.
+        [[nodiscard]] inline bool HasFailed() const;
+        [[nodiscard]] inline UInt64 GetSize() const;
+
+    private:
+        MappedFile m_File;
+        CaptureFileHeader m_Header{};
+        UInt64 m_Offset = 0;
+        bool m_Failed = false;
+
+        [[nodiscard]] const UInt8* Consume(UInt64 size);
+    };
+}
+
+#include <OpenGLTest/GLCaptureReader.inl>
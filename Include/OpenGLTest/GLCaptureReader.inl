@@ -0,0 +1,35 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+namespace OGLTest {
+    template<typename T>
+    T GLCaptureReader::Read() {
+        if constexpr (std::is_pointer_v<T>) {
+            return reinterpret_cast<T>(Read<UInt64>());
+        } else {
+            T value{};
+            if (const UInt8* data = Consume(sizeof(T))) {
+                std::memcpy(&value, data, sizeof(T));
+            }
+            return value;
+        }
+    }
+
+    inline const CaptureFileHeader& GLCaptureReader::GetHeader() const {
+        return m_Header;
+    }
+
+    inline bool GLCaptureReader::HasFailed() const {
+        return m_Failed;
+    }
+
+    inline UInt64 GLCaptureReader::GetSize() const {
+        return m_File.GetData().size();
+    }
+}
@@ -0,0 +1,50 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/MappedFile.hpp>
+
+#include <cgltf.h>
+
+#include <filesystem>
+#include <span>
+
+namespace OGLTest {
+    // A binary glTF file, mapped in memory. Only the JSON chunk is parsed, the buffer views are read in place from
+    // the mapped binary chunk.
+    class GlbFile {
+    public:
+        GlbFile() = default;
+        ~GlbFile();
+
+        GlbFile(const GlbFile&) = delete;
+        GlbFile(GlbFile&&) = delete;
+
+        GlbFile& operator=(const GlbFile&) = delete;
+        GlbFile& operator=(GlbFile&&) = delete;
+
+        // Returns false, with the reason on the error output, when the file isn't a valid GLB or uses features the
+        // native loader doesn't handle (external buffers, compressed or sparse geometry, non-triangle primitives).
+        // The caller can then fall back to a generic importer.
+        bool Open(const std::filesystem::path& path);
+
+        [[nodiscard]] inline const cgltf_data& GetData() const;
+        // The bytes of a buffer view inside the binary chunk.
+        [[nodiscard]] std::span<const UInt8> GetBufferView(const cgltf_buffer_view& view) const;
+        // Address of the first element of an accessor, its elements are accessor.stride bytes apart.
+        [[nodiscard]] const UInt8* GetAccessorData(const cgltf_accessor& accessor) const;
+
+    private:
+        MappedFile m_File;
+        cgltf_data* m_Data = nullptr;
+
+        [[nodiscard]] bool IsSupported(const std::filesystem::path& path) const;
+        [[nodiscard]] bool IsAccessorInBounds(const cgltf_accessor& accessor) const;
+    };
+}
+
+#include <OpenGLTest/GlbFile.inl>
@@ -0,0 +1,69 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <atomic>
+#include <memory_resource>
+
+namespace OGLTest {
+    struct AllocationStats {
+        UInt64 Allocations = 0;
+        // Highest number of bytes allocated at once.
+        UInt64 PeakBytes = 0;
+    };
+
+    // Forwards to another resource while counting the allocations and the bytes in use, from any thread.
+    class TrackingMemoryResource final : public std::pmr::memory_resource {
+    public:
+        explicit TrackingMemoryResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+        ~TrackingMemoryResource() override = default;
+
+        TrackingMemoryResource(const TrackingMemoryResource&) = delete;
+        TrackingMemoryResource(TrackingMemoryResource&&) = delete;
+
+        TrackingMemoryResource& operator=(const TrackingMemoryResource&) = delete;
+        TrackingMemoryResource& operator=(TrackingMemoryResource&&) = delete;
+
+        [[nodiscard]] inline AllocationStats GetStats() const;
+
+    private:
+        std::pmr::memory_resource* m_Upstream;
+        std::atomic<UInt64> m_Allocations = 0;
+        std::atomic<UInt64> m_Bytes = 0;
+        std::atomic<UInt64> m_PeakBytes = 0;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    // Linear allocator for the temporaries of an import task. Its block is sized up front so a task usually makes a
+    // single upstream allocation, the overflow goes to upstream in further blocks.
+    class ImportArena {
+    public:
+        ImportArena(UInt64 initialSize, std::pmr::memory_resource* upstream);
+        ~ImportArena();
+
+        ImportArena(const ImportArena&) = delete;
+        ImportArena(ImportArena&&) = delete;
+
+        ImportArena& operator=(const ImportArena&) = delete;
+        ImportArena& operator=(ImportArena&&) = delete;
+
+        [[nodiscard]] inline std::pmr::memory_resource* GetResource();
+        // Frees everything allocated from the arena at once, the initial block is kept for the next allocations.
+        inline void Reset();
+
+    private:
+        std::pmr::memory_resource* m_Upstream;
+        UInt64 m_BlockSize;
+        void* m_Block;
+        std::pmr::monotonic_buffer_resource m_Monotonic;
+    };
+}
+
+#include <OpenGLTest/ImportArena.inl>
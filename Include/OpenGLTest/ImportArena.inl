@@ -0,0 +1,19 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline AllocationStats TrackingMemoryResource::GetStats() const {
+        return AllocationStats{m_Allocations.load(std::memory_order_relaxed), m_PeakBytes.load(std::memory_order_relaxed)};
+    }
+
+    inline std::pmr::memory_resource* ImportArena::GetResource() {
+        return &m_Monotonic;
+    }
+
+    inline void ImportArena::Reset() {
+        m_Monotonic.release();
+    }
+}
@@ -0,0 +1,162 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OGLTest {
+    // Jobs a thread can have in its own queue, further ones go through the shared queue.
+    constexpr UInt32 g_JobQueueCapacity = 4096;
+
+    enum class JobAffinity : UInt8 {
+        // Any worker, or a thread waiting on a counter.
+        Any,
+        // Only the thread that created the job system, for GL calls while it owns the context (e.g. loading).
+        MainThread
+    };
+
+    class JobCounter;
+
+    // A scheduled function, owned by the job system until it ran.
+    struct Job {
+        std::function<void()> Function;
+        JobCounter* Counter = nullptr;
+        JobAffinity Affinity = JobAffinity::Any;
+    };
+
+    // Counts the unfinished jobs of a group. The jobs depending on it are scheduled once it reaches zero.
+    class JobCounter {
+    public:
+        JobCounter() = default;
+        ~JobCounter() = default;
+
+        JobCounter(const JobCounter&) = delete;
+        JobCounter(JobCounter&&) = delete;
+
+        JobCounter& operator=(const JobCounter&) = delete;
+        JobCounter& operator=(JobCounter&&) = delete;
+
+        [[nodiscard]] inline bool IsDone() const;
+
+    private:
+        friend class JobSystem;
+
+        std::atomic<UInt32> m_Pending = 0;
+        // Guards the decrements and the continuations, so a counter can be destroyed as soon as Wait returns.
+        std::mutex m_Mutex;
+        std::vector<Job*> m_Continuations;
+    };
+
+    // Chase-Lev deque: the owner pushes and pops at the bottom without locking, other threads steal from the top.
+    class WorkStealingQueue {
+    public:
+        WorkStealingQueue() = default;
+        ~WorkStealingQueue() = default;
+
+        WorkStealingQueue(const WorkStealingQueue&) = delete;
+        WorkStealingQueue(WorkStealingQueue&&) = delete;
+
+        WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+        WorkStealingQueue& operator=(WorkStealingQueue&&) = delete;
+
+        // Owner only. Returns false when the queue is full.
+        bool Push(Job* job);
+        // Owner only, most recently pushed first.
+        [[nodiscard]] Job* Pop();
+        // Any thread, oldest first. Returns nullptr when empty or when another thread won the race.
+        [[nodiscard]] Job* Steal();
+
+    private:
+        alignas(64) std::atomic<Int64> m_Top = 0;
+        alignas(64) std::atomic<Int64> m_Bottom = 0;
+        alignas(64) std::array<std::atomic<Job*>, g_JobQueueCapacity> m_Jobs{};
+    };
+
+    struct JobStats {
+        UInt64 Executed = 0;
+        // Jobs taken from the queue of another thread.
+        UInt64 Stolen = 0;
+    };
+
+    // Work-stealing scheduler. Each worker, and the thread that created the system, owns a queue; idle workers steal
+    // from the others. Other threads (render, I/O) can schedule and wait too, their jobs go through a shared queue.
+    class JobSystem {
+    public:
+        explicit JobSystem(UInt32 workerCount = GetDefaultWorkerCount());
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem(JobSystem&&) = delete;
+
+        JobSystem& operator=(const JobSystem&) = delete;
+        JobSystem& operator=(JobSystem&&) = delete;
+
+        // One worker per core besides the main thread.
+        [[nodiscard]] static UInt32 GetDefaultWorkerCount();
+
+        // counter, when given, is incremented now and decremented once the job ran.
+        // With a dependency, the job only starts once the dependency counter reached zero.
+        void Schedule(std::function<void()> function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr,
+                      JobAffinity affinity = JobAffinity::Any);
+        // Runs other jobs until the counter reaches zero. Only the main thread runs the main thread jobs, so waiting on
+        // one from another thread needs the main thread to call RunMainThreadJobs.
+        void Wait(JobCounter& counter);
+        // Calls function(first, last) over batches of [begin, end) of at least grainSize items and returns once they
+        // are all done. The calling thread runs the first batch.
+        template<typename Function>
+        void ParallelFor(UInt64 begin, UInt64 end, UInt64 grainSize, Function&& function);
+
+        // Runs the main thread jobs scheduled so far, from the main thread only.
+        void RunMainThreadJobs();
+
+        [[nodiscard]] inline UInt32 GetWorkerCount() const;
+        [[nodiscard]] inline bool IsMainThread() const;
+        [[nodiscard]] JobStats GetStats() const;
+
+    private:
+        static constexpr UInt32 g_NoQueue = ~0u;
+
+        // Queue 0 is the main thread's, queue i + 1 is the one of worker i.
+        std::vector<std::unique_ptr<WorkStealingQueue>> m_Queues;
+        std::vector<std::thread> m_Workers;
+        std::thread::id m_MainThread;
+
+        // Jobs scheduled by threads without a queue.
+        std::mutex m_SharedMutex;
+        std::deque<Job*> m_SharedJobs;
+
+        std::mutex m_MainThreadMutex;
+        std::deque<Job*> m_MainThreadJobs;
+
+        // Idle workers sleep until a job is queued.
+        std::mutex m_WakeMutex;
+        std::condition_variable m_WakeCondition;
+        std::atomic<Int64> m_QueuedJobs = 0;
+        std::atomic<UInt32> m_SleepingWorkers = 0;
+        std::atomic<bool> m_Stop = false;
+
+        std::atomic<UInt64> m_ExecutedJobs = 0;
+        std::atomic<UInt64> m_StolenJobs = 0;
+
+        void WorkerMain(UInt32 queueIndex);
+        [[nodiscard]] UInt32 GetQueueIndex() const;
+        void Enqueue(Job* job);
+        [[nodiscard]] Job* FindJob(UInt32 queueIndex);
+        [[nodiscard]] Job* PopMainThreadJob();
+        void Execute(Job* job);
+    };
+}
+
+#include <OpenGLTest/JobSystem.inl>
@@ -0,0 +1,47 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <algorithm>
+
+namespace OGLTest {
+    inline bool JobCounter::IsDone() const {
+        return m_Pending.load(std::memory_order_acquire) == 0;
+    }
+
+    template<typename Function>
+    void JobSystem::ParallelFor(const UInt64 begin, const UInt64 end, const UInt64 grainSize, Function&& function) {
+        if (begin >= end) {
+            return;
+        }
+
+        // A few batches per thread, so stealing can even out batches that take longer than others.
+        const UInt64 count = end - begin;
+        const UInt64 batchSize = std::max({grainSize, UInt64{1}, count / ((GetWorkerCount() + 1) * 4)});
+        if (count <= batchSize) {
+            function(begin, end);
+            return;
+        }
+
+        JobCounter counter;
+        for (UInt64 first = begin + batchSize; first < end; first += batchSize) {
+            const UInt64 last = std::min(first + batchSize, end);
+            Schedule([&function, first, last]() {
+                function(first, last);
+            }, &counter);
+        }
+
+        function(begin, begin + batchSize);
+        Wait(counter);
+    }
+
+    inline UInt32 JobSystem::GetWorkerCount() const {
+        return static_cast<UInt32>(m_Workers.size());
+    }
+
+    inline bool JobSystem::IsMainThread() const {
+        return std::this_thread::get_id() == m_MainThread;
+    }
+}
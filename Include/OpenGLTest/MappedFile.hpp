@@ -0,0 +1,42 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <filesystem>
+#include <span>
+
+namespace OGLTest {
+    // Read-only view of a whole file mapped in memory, the pages are loaded by the OS as they are touched.
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile(MappedFile&&) = delete;
+
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile& operator=(MappedFile&&) = delete;
+
+        // Unmaps the previous file, if any. Returns false if the file can't be opened or is empty.
+        bool Open(const std::filesystem::path& path);
+        void Close();
+
+        [[nodiscard]] inline bool IsOpen() const;
+        [[nodiscard]] inline std::span<const UInt8> GetData() const;
+
+    private:
+        const UInt8* m_Data = nullptr;
+        UInt64 m_Size = 0;
+#ifdef _WIN32
+        void* m_File = nullptr;
+        void* m_Mapping = nullptr;
+#endif
+    };
+}
+
+#include <OpenGLTest/MappedFile.inl>
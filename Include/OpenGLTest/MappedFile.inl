@@ -0,0 +1,15 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline bool MappedFile::IsOpen() const {
+        return m_Data != nullptr;
+    }
+
+    inline std::span<const UInt8> MappedFile::GetData() const {
+        return {m_Data, m_Size};
+    }
+}
@@ -0,0 +1,137 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/JobSystem.hpp>
+#include <OpenGLTest/Shader.hpp>
+
+#include <glad/glad.h>
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OGLTest {
+    // Texture units used by the arrays when bindless textures aren't available, see pointlight.frag.
+    constexpr UInt32 g_MaxTextureArrays = 8;
+    constexpr UInt32 g_TextureArrayFirstUnit = 0;
+    // Fills the 16 KiB a uniform block is guaranteed to hold.
+    constexpr UInt32 g_MaxMaterials = 512;
+    // Meshes without a material are drawn untextured.
+    constexpr UInt32 g_InvalidMaterial = ~0u;
+
+    constexpr UInt32 g_MaterialsBinding = 1;
+    constexpr UInt32 g_TextureHandlesBinding = 2;
+
+    // A layer of one of the texture arrays, negative when there is no texture.
+    struct TextureRef {
+        Int32 Array = -1;
+        Int32 Layer = -1;
+
+        [[nodiscard]] inline bool IsValid() const;
+    };
+
+    // Matches the std140 Material struct of the shaders.
+    struct MaterialData {
+        TextureRef Diffuse;
+        TextureRef Specular;
+        TextureRef Shininess;
+        TextureRef Padding;
+    };
+
+    // Packs the textures sharing a size and a format into GL_TEXTURE_2D_ARRAYs and keeps the materials in a uniform
+    // block, so drawing a mesh only means setting its material index.
+    // With ARB_bindless_texture the arrays are reached through 64-bit handles stored in a shader storage buffer and
+    // their count isn't limited by the texture units, the shader must then be pointlight_bindless.frag.
+    class MaterialLibrary {
+    public:
+        explicit MaterialLibrary(bool useBindless = IsBindlessSupported());
+        ~MaterialLibrary();
+
+        MaterialLibrary(const MaterialLibrary&) = delete;
+        MaterialLibrary(MaterialLibrary&&) = delete;
+
+        MaterialLibrary& operator=(const MaterialLibrary&) = delete;
+        MaterialLibrary& operator=(MaterialLibrary&&) = delete;
+
+        [[nodiscard]] static bool IsBindlessSupported();
+
+        // Decodes the images on the job system ahead of AddTexture, which then only has to reserve their layers.
+        void DecodeTextures(std::span<const std::filesystem::path> paths, JobSystem& jobs);
+        // Decodes the image (unless DecodeTextures did) and reserves its layer, the same path always gives the same
+        // layer.
+        // Returns an invalid reference if the image can't be loaded or there is no room left for it.
+        TextureRef AddTexture(const std::filesystem::path& path);
+        // Same for an encoded image in memory, e.g. embedded in a glTF file, name standing for its path.
+        // The file textures are flipped on load to match UVs with a bottom-left origin, flipRows puts the rows back
+        // in file order for UVs with a top-left origin like the glTF ones.
+        TextureRef AddEmbeddedTexture(const std::string& name, std::span<const UInt8> encoded, bool flipRows);
+        // Returns g_InvalidMaterial if the library is full.
+        UInt32 AddMaterial(TextureRef diffuse, TextureRef specular, TextureRef shininess);
+
+        // Uploads the decoded images to their arrays and the materials to their buffer, then frees the images.
+        // Textures and materials can't be added afterward.
+        void Build();
+
+        // Binds the sampler uniforms and the material block of the shader, once after it's linked.
+        void ConfigureShader(const Shader& shader) const;
+        // Binds the arrays or handles and the materials for the following draws.
+        void Bind() const;
+
+        [[nodiscard]] inline bool IsBindless() const;
+        [[nodiscard]] inline UInt32 GetArrayCount() const;
+        [[nodiscard]] inline UInt32 GetMaterialCount() const;
+        [[nodiscard]] inline UInt64 GetGpuBytes() const;
+
+    private:
+        struct TextureArray {
+            GLuint Id = 0;
+            Int32 Width;
+            Int32 Height;
+            Int32 Channels;
+            Int32 LayerCount = 0;
+            UInt64 Handle = 0;
+        };
+
+        struct PendingImage {
+            UInt8* Pixels;
+            TextureRef Ref;
+        };
+
+        struct DecodedImage {
+            UInt8* Pixels = nullptr;
+            Int32 Width = 0;
+            Int32 Height = 0;
+            Int32 Channels = 0;
+        };
+
+        bool m_Bindless;
+        bool m_Built = false;
+        Int32 m_MaxLayers = 256;
+
+        std::vector<TextureArray> m_Arrays;
+        std::vector<PendingImage> m_PendingImages;
+        // Decoded by DecodeTextures and not added yet, by normalized path.
+        std::unordered_map<std::string, DecodedImage> m_DecodedImages;
+        std::unordered_map<std::string, TextureRef> m_TextureRefs;
+        std::vector<MaterialData> m_Materials;
+
+        GLuint m_MaterialBuffer = 0;
+        GLuint m_HandleBuffer = 0;
+        UInt64 m_GpuBytes = 0;
+
+        [[nodiscard]] static DecodedImage DecodeImage(const std::string& path);
+        [[nodiscard]] static DecodedImage DecodeImage(std::span<const UInt8> encoded);
+        // Takes the ownership of the pixels.
+        TextureRef AddDecodedImage(const std::string& key, const DecodedImage& image);
+        TextureRef AllocateLayer(Int32 width, Int32 height, Int32 channels);
+    };
+}
+
+#include <OpenGLTest/MaterialLibrary.inl>
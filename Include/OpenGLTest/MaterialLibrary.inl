@@ -0,0 +1,27 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline bool TextureRef::IsValid() const {
+        return Array >= 0;
+    }
+
+    inline bool MaterialLibrary::IsBindless() const {
+        return m_Bindless;
+    }
+
+    inline UInt32 MaterialLibrary::GetArrayCount() const {
+        return static_cast<UInt32>(m_Arrays.size());
+    }
+
+    inline UInt32 MaterialLibrary::GetMaterialCount() const {
+        return static_cast<UInt32>(m_Materials.size());
+    }
+
+    inline UInt64 MaterialLibrary::GetGpuBytes() const {
+        return m_GpuBytes;
+    }
+}
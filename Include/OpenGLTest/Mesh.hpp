@@ -7,9 +7,14 @@
 #include <OpenGLTest/pch.hpp>
 
 #include <OpenGLTest/Shader.hpp>
+#include <OpenGLTest/Bvh.hpp>
+#include <OpenGLTest/MaterialLibrary.hpp>
+#include <OpenGLTest/SoftwareOcclusionBuffer.hpp>
 
 #include <glm/glm.hpp>
 
+#include <array>
+#include <span>
 #include <vector>
 
 namespace OGLTest {
@@ -19,38 +24,122 @@ namespace OGLTest {
         glm::vec2 UVs;
     };
 
-    enum class TextureType : UInt8 {
-        Diffuse,
-        Specular,
-        Shininess
+    // Meshes with at most this many vertices get 16-bit indices on the GPU. 0xFFFF itself is left unused, it's the
+    // primitive restart index of GL_UNSIGNED_SHORT.
+    constexpr UInt32 g_MaxShortIndexVertices = 65535;
+
+    // What a mesh keeps in system memory once its buffers are uploaded.
+    enum class MeshCpuData : UInt8 {
+        // Nothing, ray queries and CPU occlusion culling are unavailable.
+        None,
+        // Positions and indices only, enough for picking, physics and CPU occlusion culling.
+        Positions,
+        // Full vertices, positions and indices.
+        All
+    };
+
+    // Where an attribute of common.vert is read from in a GL buffer, in glVertexAttribPointer terms.
+    struct VertexAttributeLayout {
+        // 0 when the mesh doesn't have the attribute, the shader then reads (0, 0, 0, 1).
+        GLuint Buffer = 0;
+        GLint Components = 0;
+        GLenum Type = GL_FLOAT;
+        bool Normalized = false;
+        // 0 for tightly packed elements.
+        GLsizei Stride = 0;
+        UInt64 Offset = 0;
     };
 
-    struct Texture {
-        UInt32 Id;
-        TextureType Type;
-        std::string Path;
+    // Geometry already uploaded by the caller, e.g. the buffer views of a glTF file.
+    struct MeshBufferLayout {
+        // Position, normal and UVs, at their locations in common.vert.
+        std::array<VertexAttributeLayout, 3> Attributes;
+        GLuint IndexBuffer = 0;
+        // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+        GLenum IndexType = GL_UNSIGNED_INT;
+        UInt64 IndexOffset = 0;
+        UInt32 VertexCount = 0;
+        UInt32 IndexCount = 0;
+        // Bytes of the buffers used by this mesh, for the memory statistics.
+        UInt64 GpuBytes = 0;
+    };
+
+    struct MemoryUsage {
+        UInt64 CpuBytes = 0;
+        UInt64 GpuBytes = 0;
+
+        inline MemoryUsage& operator+=(const MemoryUsage& other);
     };
 
     class Mesh {
     public:
-        Mesh(const std::vector<Vertex>& vertices, const std::vector<UInt32>& indices,
-             const std::vector<Texture>& textures);
-        ~Mesh() = default;
+        // The geometry is moved in, no copy of the vertices or indices is made.
+        // materialIndex refers to the MaterialLibrary of the owner, see Model.
+        Mesh(std::vector<Vertex>&& vertices, std::vector<UInt32>&& indices, UInt32 materialIndex = g_InvalidMaterial,
+             MeshCpuData cpuData = MeshCpuData::Positions);
+        // Only sets up a vertex array over the caller's buffers, which must outlive the mesh. positions and indices
+        // are the copies used by the CPU queries and can be empty with MeshCpuData::None, bounds is then used as is.
+        // The full vertices aren't available from such a mesh, whatever cpuData is.
+        Mesh(const MeshBufferLayout& layout, std::vector<glm::vec3>&& positions, std::vector<UInt32>&& indices,
+             const BoundingBox& bounds, UInt32 materialIndex = g_InvalidMaterial,
+             MeshCpuData cpuData = MeshCpuData::Positions);
+        ~Mesh();
+
+        Mesh(const Mesh&) = delete;
+        // The moved-from mesh no longer owns any GL object.
+        Mesh(Mesh&& other) noexcept;
 
-        [[nodiscard]] inline std::vector<Vertex> GetVertices() const;
-        [[nodiscard]] inline std::vector<UInt32> GetIndices() const;
-        [[nodiscard]] inline std::vector<Texture> GetTextures() const;
+        Mesh& operator=(const Mesh&) = delete;
+        Mesh& operator=(Mesh&& other) noexcept;
+
+        // These views are empty when the matching data was released, see MeshCpuData.
+        [[nodiscard]] inline std::span<const Vertex> GetVertices() const;
+        [[nodiscard]] inline std::span<const glm::vec3> GetPositions() const;
+        [[nodiscard]] inline std::span<const UInt32> GetIndices() const;
+
+        [[nodiscard]] inline UInt32 GetVertexCount() const;
+        [[nodiscard]] inline UInt32 GetIndexCount() const;
+        // The type of the GPU indices, the CPU copy of the indices is always 32-bit.
+        [[nodiscard]] inline GLenum GetIndexType() const;
+        [[nodiscard]] inline UInt32 GetIndexSize() const;
+        [[nodiscard]] inline UInt32 GetMaterialIndex() const;
+        [[nodiscard]] inline const BoundingBox& GetBounds() const;
+        // Texture memory isn't included, textures are shared between meshes and accounted by the MaterialLibrary.
+        [[nodiscard]] MemoryUsage GetMemoryUsage() const;
+
+        // Frees the system memory copies not needed by the given level. Released data can't be brought back.
+        void ReleaseCpuData(MeshCpuData keep);
+
+        // Returns the distance to the nearest triangle hit by the ray (in mesh space) or maxDistance if there is none.
+        Float32 Raycast(const Ray& ray, UInt32& triangleIndex, Float32 maxDistance = g_Infinity) const;
+
+        // Renders the mesh's depth into the CPU occlusion buffer.
+        void RasterizeOccluder(SoftwareOcclusionBuffer& buffer, const glm::mat4& modelViewProjection) const;
 
         void Draw(Shader& shader);
 
     private:
         std::vector<Vertex> m_Vertices;
+        // Compact copy of the vertex positions for CPU queries.
+        std::vector<glm::vec3> m_Positions;
         std::vector<UInt32> m_Indices;
-        std::vector<Texture> m_Textures;
 
-        GLuint m_VAO, m_VBO, m_EBO;
+        UInt32 m_MaterialIndex;
+        UInt32 m_VertexCount;
+        UInt32 m_IndexCount;
+        GLenum m_IndexType;
+        UInt64 m_IndexOffset = 0;
+        UInt64 m_GpuBytes = 0;
+        // m_VBO and m_EBO are 0 when the buffers belong to the caller.
+        GLuint m_VAO = 0, m_VBO = 0, m_EBO = 0;
+
+        BoundingBox m_Bounds;
+        // Per-triangle hierarchy used by ray queries.
+        Bvh m_Bvh;
 
         void SetupMesh();
+        void DeleteBuffers();
+        void BuildBvh();
     };
 }
 
@@ -5,15 +5,58 @@
 #pragma once
 
 namespace OGLTest {
-    inline std::vector<Vertex> Mesh::GetVertices() const {
+    inline MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other) {
+        CpuBytes += other.CpuBytes;
+        GpuBytes += other.GpuBytes;
+        return *this;
+    }
+
+    inline std::span<const Vertex> Mesh::GetVertices() const {
         return m_Vertices;
     }
 
-    inline std::vector<UInt32> Mesh::GetIndices() const {
+    inline std::span<const glm::vec3> Mesh::GetPositions() const {
+        return m_Positions;
+    }
+
+    inline std::span<const UInt32> Mesh::GetIndices() const {
         return m_Indices;
     }
 
-    inline std::vector<Texture> Mesh::GetTextures() const {
-        return m_Textures;
+    inline UInt32 Mesh::GetVertexCount() const {
+        return m_VertexCount;
+    }
+
+    inline UInt32 Mesh::GetIndexCount() const {
+        return m_IndexCount;
+    }
+
+    inline GLenum Mesh::GetIndexType() const {
+        return m_IndexType;
+    }
+
+    inline UInt32 Mesh::GetIndexSize() const {
+        switch (m_IndexType) {
+        case GL_UNSIGNED_BYTE:
+            {
+                return sizeof(UInt8);
+            }
+        case GL_UNSIGNED_SHORT:
+            {
+                return sizeof(UInt16);
+            }
+        default:
+            {
+                return sizeof(UInt32);
+            }
+        }
+    }
+
+    inline UInt32 Mesh::GetMaterialIndex() const {
+        return m_MaterialIndex;
+    }
+
+    inline const BoundingBox& Mesh::GetBounds() const {
+        return m_Bounds;
     }
 }
@@ -7,30 +7,164 @@
 
 #include <OpenGLTest/pch.hpp>
 
+#include <OpenGLTest/JobSystem.hpp>
 #include <OpenGLTest/Shader.hpp>
 #include <OpenGLTest/Mesh.hpp>
+#include <OpenGLTest/SceneGraph.hpp>
+#include <OpenGLTest/Bvh.hpp>
+#include <OpenGLTest/GlbFile.hpp>
+#include <OpenGLTest/ImportArena.hpp>
+#include <OpenGLTest/MaterialLibrary.hpp>
 
 #include <assimp/scene.h>
 
 #include <filesystem>
+#include <span>
 
 namespace OGLTest {
+    // How the vertices of an imported mesh are merged, the files often store one vertex per face corner.
+    enum class VertexWelding : UInt8 {
+        Disabled,
+        // Merges vertices whose position, normal and UVs are bitwise equal (-0 and +0 being the same).
+        Bitwise,
+        // Merges vertices whose attributes fall in the same g_WeldEpsilon sized cell.
+        Epsilon
+    };
+
+    constexpr Float32 g_WeldEpsilon = 1e-5f;
+
+    // Size of an imported mesh before and after welding, index bytes are the GPU ones.
+    struct MeshImportStats {
+        UInt32 VerticesBefore = 0;
+        UInt32 VerticesAfter = 0;
+        UInt32 IndexCount = 0;
+        UInt64 BytesBefore = 0;
+        UInt64 BytesAfter = 0;
+    };
+
+    struct ModelImportSettings {
+        // Geometry each mesh keeps in system memory after upload.
+        MeshCpuData CpuData = MeshCpuData::Positions;
+        VertexWelding Welding = VertexWelding::Bitwise;
+        // Allocates the mesh conversion temporaries from an arena instead of the heap, for comparison.
+        bool UseImportArena = true;
+        // Loads .glb files without Assimp, uploading their buffer views as they are. The vertices aren't welded,
+        // and Assimp is still used for the files the native loader doesn't handle.
+        bool UseNativeGltf = true;
+    };
+
     class Model {
     public:
-        inline explicit Model(const std::filesystem::path& path);
-        ~Model() = default;
+        // The textures and meshes are decoded on the job system. The GL uploads run as main thread jobs, so the model
+        // must be created from the main thread of the job system.
+        inline Model(const std::filesystem::path& path, JobSystem& jobs,
+                     const ModelImportSettings& settings = ModelImportSettings{});
+        ~Model();
+
+        // Sets the placement of the whole model, applied on top of the transforms stored in the file.
+        inline void SetTransform(const glm::mat4& transform);
 
+        [[nodiscard]] inline SceneGraph& GetSceneGraph();
+        [[nodiscard]] inline const MaterialLibrary& GetMaterials() const;
+        [[nodiscard]] inline NodeId GetRootNode() const;
+        [[nodiscard]] inline UInt32 GetMeshCount() const;
+        [[nodiscard]] inline const Mesh& GetMesh(UInt32 meshIndex) const;
+        [[nodiscard]] inline const glm::mat4& GetMeshTransform(UInt32 meshIndex) const;
+        [[nodiscard]] inline const BoundingBox& GetMeshWorldBounds(UInt32 meshIndex) const;
+        // Meshes, textures and the acceleration structures.
+        [[nodiscard]] MemoryUsage GetMemoryUsage() const;
+        // One entry per mesh of the imported file, a mesh instanced by several nodes is only counted once.
+        [[nodiscard]] inline std::span<const MeshImportStats> GetImportStats() const;
+        // Upstream allocations of the mesh conversion temporaries, with or without the arena.
+        [[nodiscard]] inline const AllocationStats& GetImportScratchAllocations() const;
+
+        // Returns the nearest mesh triangle hit by the (world space) ray.
+        [[nodiscard]] RayHit Raycast(const Ray& ray) const;
+        // Fills meshIndices with the meshes whose world bounds intersect the frustum.
+        void QueryFrustum(const Frustum& frustum, std::vector<UInt32>& meshIndices) const;
+
+        // Dynamic meshes are expected to move every frame, they are kept out of the cached shadow maps.
+        inline void SetMeshDynamic(UInt32 meshIndex, bool dynamic);
+        [[nodiscard]] inline bool IsMeshDynamic(UInt32 meshIndex) const;
+        [[nodiscard]] bool HasDynamicMeshesIn(const Frustum& frustum) const;
+
+        // Returns true when a static mesh moved, which invalidates the cached shadow maps.
+        bool Update();
+        // Binds the texture arrays and materials, once before drawing any of the meshes.
+        inline void BindMaterials() const;
         void Draw(Shader& shader);
+        // Only draws the meshes inside the frustum.
+        void Draw(Shader& shader, const Frustum& frustum);
+        void DrawMesh(Shader& shader, UInt32 meshIndex);
+        // Draws either the static or the dynamic meshes inside the frustum, see ShadowRenderer.
+        void DrawShadowCasters(Shader& shader, const Frustum& frustum, bool dynamic);
 
     private:
+        // Geometry of an imported mesh, converted on a worker before the upload.
+        struct MeshGeometry {
+            std::vector<Vertex> Vertices;
+            std::vector<UInt32> Indices;
+            UInt32 SceneMaterial = 0;
+            MeshImportStats Stats;
+            // Set once moved into a Mesh, a mesh instanced by several nodes is copied for the next ones.
+            bool Used = false;
+        };
+
+        // A primitive of a glTF mesh, its CPU copies are read on a worker before the vertex array is set up.
+        struct GltfPrimitive {
+            const cgltf_primitive* Primitive = nullptr;
+            std::vector<glm::vec3> Positions;
+            std::vector<UInt32> Indices;
+            BoundingBox Bounds;
+            MeshImportStats Stats;
+            bool Used = false;
+        };
+
+        JobSystem& m_Jobs;
         std::vector<Mesh> m_Meshes;
+        // Scene graph node of each mesh, m_MeshNodes[i] places m_Meshes[i].
+        std::vector<NodeId> m_MeshNodes;
+        SceneGraph m_SceneGraph;
+        NodeId m_RootNode;
+
+        // Mesh-level hierarchy in world space, refitted when the scene graph moves.
+        std::vector<BoundingBox> m_MeshWorldBounds;
+        // Last world transform of each mesh, to tell whether a static one moved.
+        std::vector<glm::mat4> m_MeshWorldTransforms;
+        std::vector<UInt8> m_DynamicMeshes;
+        UInt32 m_DynamicMeshCount = 0;
+        Bvh m_Bvh;
+        std::vector<UInt32> m_VisibleMeshes;
+
+        ModelImportSettings m_Settings;
+        std::vector<MeshImportStats> m_ImportStats;
+        AllocationStats m_ScratchAllocations;
         std::string m_Directory;
-        std::vector<Texture> m_LoadedTextures;
+        MaterialLibrary m_Materials;
+        // Material library index of each material of the imported scene.
+        std::vector<UInt32> m_MaterialIndices;
+        // GL buffer of each buffer view of a glTF file, 0 for the views without vertices or indices.
+        std::vector<GLuint> m_GltfBuffers;
 
         void LoadModel(const std::filesystem::path& path);
-        void ProcessNode(const aiNode* node, const aiScene* scene);
-        Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene);
-        std::vector<Texture> LoadMaterialTextures(aiMaterial* mat, aiTextureType type, TextureType textureType);
+        bool LoadWithAssimp(const std::filesystem::path& path);
+        void ProcessNode(const aiNode* node, NodeId parent, std::vector<MeshGeometry>& geometries);
+        // scratch holds the temporaries, the returned vectors are sized exactly and allocated from the heap.
+        [[nodiscard]] static MeshGeometry ProcessMesh(const aiMesh* mesh, VertexWelding welding,
+                                                      std::pmr::memory_resource* scratch);
+        void LoadMaterials(const aiScene* scene);
+        TextureRef LoadMaterialTexture(const aiMaterial* material, aiTextureType type);
+        // Returns false, without changing the model, when the file can't be loaded natively.
+        bool LoadGlb(const std::filesystem::path& path);
+        void LoadGltfMaterials(const GlbFile& file, const std::filesystem::path& path);
+        TextureRef LoadGltfTexture(const GlbFile& file, const cgltf_image& image, const std::filesystem::path& path);
+        void UploadGltfBuffers(const GlbFile& file);
+        [[nodiscard]] MeshBufferLayout GetGltfLayout(const cgltf_data& data, const cgltf_primitive& primitive) const;
+        void ProcessGltfNode(const cgltf_data& data, const cgltf_node& node, NodeId parent,
+                             std::vector<GltfPrimitive>& primitives, std::span<const UInt32> firstPrimitives);
+        static void ReadGltfPrimitive(const GlbFile& file, GltfPrimitive& primitive, MeshCpuData cpuData);
+        // Returns true when the world transform of a static mesh changed.
+        bool UpdateMeshWorldBounds();
     };
 }
 
@@ -5,7 +5,71 @@
 #pragma once
 
 namespace OGLTest {
-    inline Model::Model(const std::filesystem::path& path) {
+    inline Model::Model(const std::filesystem::path& path, JobSystem& jobs, const ModelImportSettings& settings)
+        : m_Jobs(jobs), m_Settings(settings) {
+        // Large hierarchies are updated level by level on the jobs.
+        m_SceneGraph.SetParallelFor([this](const UInt64 begin, const UInt64 end, const UInt64 grainSize,
+                                           const std::function<void(UInt64, UInt64)>& function) {
+            m_Jobs.ParallelFor(begin, end, grainSize, function);
+        });
+        m_RootNode = m_SceneGraph.AddNode(g_InvalidNode);
         LoadModel(path);
     }
+
+    inline void Model::SetTransform(const glm::mat4& transform) {
+        m_SceneGraph.SetLocalTransform(m_RootNode, transform);
+    }
+
+    inline SceneGraph& Model::GetSceneGraph() {
+        return m_SceneGraph;
+    }
+
+    inline const MaterialLibrary& Model::GetMaterials() const {
+        return m_Materials;
+    }
+
+    inline std::span<const MeshImportStats> Model::GetImportStats() const {
+        return m_ImportStats;
+    }
+
+    inline const AllocationStats& Model::GetImportScratchAllocations() const {
+        return m_ScratchAllocations;
+    }
+
+    inline void Model::BindMaterials() const {
+        m_Materials.Bind();
+    }
+
+    inline NodeId Model::GetRootNode() const {
+        return m_RootNode;
+    }
+
+    inline UInt32 Model::GetMeshCount() const {
+        return static_cast<UInt32>(m_Meshes.size());
+    }
+
+    inline const Mesh& Model::GetMesh(const UInt32 meshIndex) const {
+        return m_Meshes[meshIndex];
+    }
+
+    inline const glm::mat4& Model::GetMeshTransform(const UInt32 meshIndex) const {
+        return m_SceneGraph.GetWorldTransform(m_MeshNodes[meshIndex]);
+    }
+
+    inline void Model::SetMeshDynamic(const UInt32 meshIndex, const bool dynamic) {
+        if (IsMeshDynamic(meshIndex) == dynamic) {
+            return;
+        }
+
+        m_DynamicMeshes[meshIndex] = dynamic ? 1 : 0;
+        m_DynamicMeshCount += dynamic ? 1 : -1;
+    }
+
+    inline bool Model::IsMeshDynamic(const UInt32 meshIndex) const {
+        return m_DynamicMeshes[meshIndex] != 0;
+    }
+
+    inline const BoundingBox& Model::GetMeshWorldBounds(const UInt32 meshIndex) const {
+        return m_MeshWorldBounds[meshIndex];
+    }
 }
@@ -0,0 +1,85 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/Model.hpp>
+#include <OpenGLTest/Shader.hpp>
+#include <OpenGLTest/SoftwareOcclusionBuffer.hpp>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace OGLTest {
+    enum class OcclusionMode : UInt8 {
+        // Frustum culling only.
+        Disabled,
+        // GPU occlusion queries on the mesh bounding boxes, results are read one frame later.
+        Hardware,
+        // CPU rasterized depth buffer, front to back.
+        Software
+    };
+
+    struct OcclusionStats {
+        // Meshes inside the frustum.
+        UInt32 Candidates = 0;
+        // Bounding boxes tested this frame (queries issued or boxes rasterized).
+        UInt32 Tested = 0;
+        // Meshes skipped, or only drawn under conditional rendering, because they were found hidden.
+        UInt32 Occluded = 0;
+    };
+
+    // Draws a model while skipping the meshes hidden behind others.
+    // It keeps per-mesh state between frames, so one culler must be used for a single model.
+    class OcclusionCuller {
+    public:
+        explicit OcclusionCuller(OcclusionMode mode = OcclusionMode::Hardware);
+        ~OcclusionCuller();
+
+        OcclusionCuller(const OcclusionCuller&) = delete;
+        OcclusionCuller(OcclusionCuller&&) = delete;
+
+        OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+        OcclusionCuller& operator=(OcclusionCuller&&) = delete;
+
+        void Draw(Model& model, Shader& shader, const glm::mat4& projection, const glm::mat4& view,
+                  const glm::vec3& cameraPosition);
+
+        inline void SetMode(OcclusionMode mode);
+        inline void SetConditionalRenderEnabled(bool enabled);
+
+        [[nodiscard]] inline OcclusionMode GetMode() const;
+        [[nodiscard]] inline const OcclusionStats& GetStats() const;
+
+    private:
+        struct MeshState {
+            GLuint Query = 0;
+            bool Pending = false;
+            bool Visible = true;
+        };
+
+        OcclusionMode m_Mode;
+        OcclusionStats m_Stats;
+        bool m_UseConditionalRender = true;
+        GLenum m_QueryTarget;
+
+        Shader m_BoxShader;
+        GLuint m_BoxVAO, m_BoxVBO, m_BoxEBO;
+
+        std::vector<MeshState> m_MeshStates;
+        std::vector<UInt32> m_Candidates;
+        SoftwareOcclusionBuffer m_SoftwareBuffer;
+
+        void DrawHardware(Model& model, Shader& shader, const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+        void DrawSoftware(Model& model, Shader& shader, const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+        void SetupBox();
+    };
+}
+
+#include <OpenGLTest/OcclusionCuller.inl>
@@ -0,0 +1,23 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline void OcclusionCuller::SetMode(const OcclusionMode mode) {
+        m_Mode = mode;
+    }
+
+    inline void OcclusionCuller::SetConditionalRenderEnabled(const bool enabled) {
+        m_UseConditionalRender = enabled;
+    }
+
+    inline OcclusionMode OcclusionCuller::GetMode() const {
+        return m_Mode;
+    }
+
+    inline const OcclusionStats& OcclusionCuller::GetStats() const {
+        return m_Stats;
+    }
+}
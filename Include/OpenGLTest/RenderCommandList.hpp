@@ -0,0 +1,118 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/BoundingVolumes.hpp>
+#include <OpenGLTest/OcclusionCuller.hpp>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <chrono>
+#include <span>
+#include <variant>
+
+namespace OGLTest {
+    constexpr UInt32 g_MaxRenderCommands = 64;
+
+    using FrameClock = std::chrono::steady_clock;
+
+    // Size of the window, starts the scene of a frame.
+    struct ViewportCommand {
+        Int32 Width;
+        Int32 Height;
+    };
+
+    struct ClearCommand {
+        glm::vec4 Color;
+    };
+
+    // Binds the scene shader and sets the matrices used by the following draws.
+    struct CameraCommand {
+        glm::mat4 Projection;
+        glm::mat4 View;
+        glm::vec3 Position;
+    };
+
+    struct PointLightCommand {
+        glm::vec3 Position;
+        glm::vec3 Ambient;
+        glm::vec3 Diffuse;
+        glm::vec3 Specular;
+        Float32 Constant;
+        Float32 Linear;
+        Float32 Quadratic;
+    };
+
+    struct DirectionalLightCommand {
+        // The direction the light travels in.
+        glm::vec3 Direction;
+        glm::vec3 Color;
+    };
+
+    // Updates the shadow maps of the lights set so far, before drawing the scene.
+    struct RenderShadowsCommand {
+        // Whether the streamed chunks cast shadows.
+        bool IncludeStreaming;
+    };
+
+    struct DrawModelCommand {
+        OcclusionMode Occlusion;
+    };
+
+    // Reports the model triangle hit by a world space ray, after DrawModelCommand so the mesh transforms are current.
+    struct PickCommand {
+        Ray WorldRay;
+    };
+
+    // Updates the streamed chunks around the camera and draws the resident ones.
+    struct DrawStreamingCommand {
+    };
+
+    // Upscales the scene to the window, after the last scene draw of a frame.
+    struct ResolveSceneCommand {
+    };
+
+    using RenderCommand = std::variant<ViewportCommand, ClearCommand, CameraCommand, PointLightCommand,
+                                       DirectionalLightCommand, RenderShadowsCommand, DrawModelCommand,
+                                       PickCommand, DrawStreamingCommand, ResolveSceneCommand>;
+
+    // Plain values only, recording a frame never allocates.
+    class RenderCommandList {
+    public:
+        RenderCommandList() = default;
+        ~RenderCommandList() = default;
+
+        RenderCommandList(const RenderCommandList&) = delete;
+        RenderCommandList(RenderCommandList&&) = delete;
+
+        RenderCommandList& operator=(const RenderCommandList&) = delete;
+        RenderCommandList& operator=(RenderCommandList&&) = delete;
+
+        inline void Clear();
+        // Returns false if the list is full, the command is then dropped.
+        inline bool Push(const RenderCommand& command);
+
+        [[nodiscard]] inline std::span<const RenderCommand> GetCommands() const;
+
+    private:
+        std::array<RenderCommand, g_MaxRenderCommands> m_Commands;
+        UInt32 m_Size = 0;
+    };
+
+    // Everything needed to draw a frame, recorded by the main thread and executed by the render thread.
+    struct FrameSnapshot {
+        UInt64 FrameIndex = 0;
+        // When the main thread started the frame, and when it was done sampling the input.
+        FrameClock::time_point FrameStart;
+        FrameClock::time_point InputTime;
+        Float32 DeltaTime = 0.0f;
+        RenderCommandList Commands;
+    };
+}
+
+#include <OpenGLTest/RenderCommandList.inl>
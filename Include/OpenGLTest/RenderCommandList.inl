@@ -0,0 +1,24 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline void RenderCommandList::Clear() {
+        m_Size = 0;
+    }
+
+    inline bool RenderCommandList::Push(const RenderCommand& command) {
+        if (m_Size == m_Commands.size()) {
+            return false;
+        }
+
+        m_Commands[m_Size++] = command;
+        return true;
+    }
+
+    inline std::span<const RenderCommand> RenderCommandList::GetCommands() const {
+        return {m_Commands.data(), m_Size};
+    }
+}
@@ -0,0 +1,94 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/RenderCommandList.hpp>
+
+#include <GLFW/glfw3.h>
+
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace OGLTest {
+    // Averages over the frames since the previous call to RenderThread::ConsumeTimings.
+    struct FrameTimings {
+        // Main thread work for a frame, not counting the time spent waiting for a free snapshot.
+        Float32 MainCpuMs = 0.0f;
+        // Execution of the command list, not counting SwapBuffers.
+        Float32 RenderCpuMs = 0.0f;
+        // From the end of input sampling to SwapBuffers returning.
+        Float32 InputLatencyMs = 0.0f;
+        UInt32 FrameCount = 0;
+    };
+
+    // Runs the frames recorded by the main thread. When threaded, the GL context of the window belongs to a
+    // dedicated thread executing frame N while the main thread records frame N + 1 in the other snapshot.
+    // Otherwise each frame is executed and presented as soon as it's submitted, which is useful for comparison.
+    class RenderThread {
+    public:
+        using ExecuteFunction = std::function<void(const FrameSnapshot&)>;
+
+        // The context must be current on the calling thread, it is moved to the render thread when threaded.
+        RenderThread(GLFWwindow* window, ExecuteFunction execute, bool threaded = true);
+        ~RenderThread();
+
+        RenderThread(const RenderThread&) = delete;
+        RenderThread(RenderThread&&) = delete;
+
+        RenderThread& operator=(const RenderThread&) = delete;
+        RenderThread& operator=(RenderThread&&) = delete;
+
+        // Returns the snapshot to record the next frame in, once the render thread is done with it.
+        [[nodiscard]] FrameSnapshot& BeginFrame();
+        void Submit();
+        // Waits for the render thread and makes the context current on the calling thread again.
+        void Stop();
+
+        [[nodiscard]] inline bool IsThreaded() const;
+        FrameTimings ConsumeTimings();
+
+    private:
+        enum class SlotState : UInt8 {
+            Free,
+            Recording,
+            Submitted,
+            Executing
+        };
+
+        GLFWwindow* m_Window;
+        ExecuteFunction m_Execute;
+        bool m_Threaded;
+
+        std::array<FrameSnapshot, 2> m_Snapshots;
+        // Only touched by the main thread.
+        UInt32 m_WriteIndex = 0;
+        FrameClock::duration m_WaitTime{};
+        // Only touched by the render thread.
+        UInt32 m_ReadIndex = 0;
+
+        // Guarded by m_Mutex: the slot states, m_Stop and the timing sums.
+        std::mutex m_Mutex;
+        std::condition_variable m_SlotChanged;
+        std::array<SlotState, 2> m_SlotStates{SlotState::Free, SlotState::Free};
+        bool m_Stop = false;
+        Float64 m_MainCpuMs = 0.0;
+        Float64 m_RenderCpuMs = 0.0;
+        Float64 m_InputLatencyMs = 0.0;
+        UInt32 m_SubmittedFrames = 0;
+        UInt32 m_PresentedFrames = 0;
+
+        std::thread m_Thread;
+
+        void ThreadMain();
+        void Present(const FrameSnapshot& snapshot);
+    };
+}
+
+#include <OpenGLTest/RenderThread.inl>
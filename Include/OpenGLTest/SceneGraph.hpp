@@ -0,0 +1,80 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace OGLTest {
+    using NodeId = UInt32;
+
+    constexpr NodeId g_InvalidNode = std::numeric_limits<NodeId>::max();
+
+    // Above this node count, world transforms are updated level by level through the parallel for, when one is set.
+    constexpr UInt32 g_ParallelUpdateThreshold = 16384;
+    constexpr UInt32 g_ParallelUpdateGrainSize = 1024;
+
+    // Calls function(first, last) over batches of [begin, end) of at least grainSize items, possibly concurrently, and
+    // returns once they are all done.
+    using ParallelForFunction = std::function<void(UInt64 begin, UInt64 end, UInt64 grainSize,
+                                                   const std::function<void(UInt64, UInt64)>& function)>;
+
+    // A transform hierarchy stored as flat arrays (structure of arrays). Nodes are kept in topological order:
+    // a parent always has a lower index than its children, so a single forward pass updates every world matrix.
+    class SceneGraph {
+    public:
+        SceneGraph() = default;
+        ~SceneGraph() = default;
+
+        SceneGraph(const SceneGraph&) = delete;
+        SceneGraph(SceneGraph&&) = default;
+
+        SceneGraph& operator=(const SceneGraph&) = delete;
+        SceneGraph& operator=(SceneGraph&&) = default;
+
+        // Appends a node. The parent must already exist (or be g_InvalidNode for a root).
+        NodeId AddNode(NodeId parent, const glm::mat4& localTransform = glm::mat4(1.0f));
+        void Clear();
+
+        inline void SetLocalTransform(NodeId node, const glm::mat4& transform);
+        // Lets large graphs be updated in parallel, e.g. on a thread pool. Without it every update is serial.
+        inline void SetParallelFor(ParallelForFunction parallelFor);
+
+        [[nodiscard]] inline const glm::mat4& GetLocalTransform(NodeId node) const;
+        [[nodiscard]] inline const glm::mat4& GetWorldTransform(NodeId node) const;
+        [[nodiscard]] inline NodeId GetParent(NodeId node) const;
+        [[nodiscard]] inline UInt32 GetNodeCount() const;
+
+        // Recomputes the world matrices of every node whose local transform (or an ancestor's) changed.
+        // Large graphs are split level by level through the parallel for. Returns false when nothing had to be updated.
+        bool UpdateWorldTransforms();
+
+    private:
+        std::vector<NodeId> m_Parents;
+        std::vector<UInt32> m_Depths;
+        std::vector<glm::mat4> m_LocalTransforms;
+        std::vector<glm::mat4> m_WorldTransforms;
+        // UInt8 instead of std::vector<bool> so that jobs can write neighbouring flags safely.
+        std::vector<UInt8> m_Dirty;
+
+        // Node indices grouped by depth, only built for the parallel path.
+        std::vector<NodeId> m_LevelNodes;
+        std::vector<UInt32> m_LevelOffsets;
+        bool m_LevelsValid = false;
+        bool m_AnyDirty = false;
+        ParallelForFunction m_ParallelFor;
+
+        inline void UpdateNode(NodeId node);
+        void UpdateParallel();
+        void BuildLevels();
+    };
+}
+
+#include <OpenGLTest/SceneGraph.inl>
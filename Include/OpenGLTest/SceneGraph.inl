@@ -0,0 +1,50 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline void SceneGraph::SetLocalTransform(const NodeId node, const glm::mat4& transform) {
+        m_LocalTransforms[node] = transform;
+        m_Dirty[node] = 1;
+        m_AnyDirty = true;
+    }
+
+    inline void SceneGraph::SetParallelFor(ParallelForFunction parallelFor) {
+        m_ParallelFor = std::move(parallelFor);
+    }
+
+    inline const glm::mat4& SceneGraph::GetLocalTransform(const NodeId node) const {
+        return m_LocalTransforms[node];
+    }
+
+    inline const glm::mat4& SceneGraph::GetWorldTransform(const NodeId node) const {
+        return m_WorldTransforms[node];
+    }
+
+    inline NodeId SceneGraph::GetParent(const NodeId node) const {
+        return m_Parents[node];
+    }
+
+    inline UInt32 SceneGraph::GetNodeCount() const {
+        return static_cast<UInt32>(m_Parents.size());
+    }
+
+    inline void SceneGraph::UpdateNode(const NodeId node) {
+        const NodeId parent = m_Parents[node];
+
+        if (parent == g_InvalidNode) {
+            if (m_Dirty[node]) {
+                m_WorldTransforms[node] = m_LocalTransforms[node];
+            }
+            return;
+        }
+
+        // The parent has already been processed, so its flag tells whether its world matrix changed this update.
+        if (m_Dirty[node] || m_Dirty[parent]) {
+            m_WorldTransforms[node] = m_WorldTransforms[parent] * m_LocalTransforms[node];
+            m_Dirty[node] = 1;
+        }
+    }
+}
@@ -0,0 +1,107 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/DynamicResolution.hpp>
+#include <OpenGLTest/Model.hpp>
+#include <OpenGLTest/OcclusionCuller.hpp>
+#include <OpenGLTest/RenderCommandList.hpp>
+#include <OpenGLTest/Shader.hpp>
+#include <OpenGLTest/ShadowRenderer.hpp>
+#include <OpenGLTest/StreamBuffer.hpp>
+#include <OpenGLTest/StreamingManager.hpp>
+
+#include <mutex>
+
+namespace OGLTest {
+    constexpr UInt32 g_FrameDataBinding = 0;
+    // Room for a few hundred FrameData uploads per frame.
+    constexpr UInt64 g_FrameDataRegionSize = 64 * 1024;
+
+    // Matches the std140 FrameData uniform block of common.vert.
+    struct FrameData {
+        glm::mat4 Projection;
+        glm::mat4 View;
+        glm::vec4 ViewPosition;
+        glm::vec4 LightPosition;
+        glm::vec4 LightAmbient;
+        glm::vec4 LightDiffuse;
+        glm::vec4 LightSpecular;
+        // Constant, linear and quadratic terms.
+        glm::vec4 LightAttenuation;
+        // w is the number of shadow cascades.
+        glm::vec4 SunDirection;
+        glm::vec4 SunColor;
+        ShadowUniforms Shadows;
+    };
+
+    struct SceneStats {
+        OcclusionStats Occlusion;
+        ResidencyStats Residency;
+        ShadowStats Shadows;
+        ResolutionStats Resolution;
+        // The result of the latest PickCommand, PickCount tells whether one ran yet.
+        RayHit LastPick;
+        UInt64 PickCount = 0;
+    };
+
+    // Executes the recorded frames on the thread owning the GL context.
+    // While a render thread runs, the resources given here must only be used through it.
+    class SceneRenderer {
+    public:
+        SceneRenderer(Shader& shader, Model& model, OcclusionCuller& occlusionCuller, StreamingManager& streaming,
+                      ShadowRenderer& shadows, DynamicResolution& resolution);
+        ~SceneRenderer() = default;
+
+        SceneRenderer(const SceneRenderer&) = delete;
+        SceneRenderer(SceneRenderer&&) = delete;
+
+        SceneRenderer& operator=(const SceneRenderer&) = delete;
+        SceneRenderer& operator=(SceneRenderer&&) = delete;
+
+        void Execute(const FrameSnapshot& snapshot);
+
+        // Stats of the last executed frame, safe to call from any thread.
+        [[nodiscard]] SceneStats GetStats() const;
+
+    private:
+        Shader& m_Shader;
+        Model& m_Model;
+        OcclusionCuller& m_OcclusionCuller;
+        StreamingManager& m_Streaming;
+        ShadowRenderer& m_Shadows;
+        DynamicResolution& m_Resolution;
+        CameraCommand m_Camera{};
+
+        // The per-frame uniforms, uploaded before the next draw when a command changed them.
+        StreamBuffer m_FrameDataBuffer;
+        FrameData m_FrameData{};
+        bool m_FrameDataDirty = true;
+        UInt64 m_UniformAlignment = 256;
+
+        RayHit m_LastPick;
+        UInt64 m_PickCount = 0;
+
+        mutable std::mutex m_StatsMutex;
+        SceneStats m_Stats;
+
+        void Execute(const ViewportCommand& command);
+        void Execute(const ClearCommand& command);
+        void Execute(const CameraCommand& command);
+        void Execute(const PointLightCommand& command);
+        void Execute(const DirectionalLightCommand& command);
+        void Execute(const RenderShadowsCommand& command);
+        void Execute(const DrawModelCommand& command);
+        void Execute(const PickCommand& command);
+        void Execute(const DrawStreamingCommand& command);
+        void Execute(const ResolveSceneCommand& command);
+
+        void UploadFrameData();
+    };
+}
+
+#include <OpenGLTest/SceneRenderer.inl>
@@ -8,6 +8,8 @@
 
 #include <filesystem>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 #include <glm/glm.hpp>
 
@@ -17,30 +19,44 @@ namespace OGLTest {
         UInt32 ID;
 
         Shader(const std::filesystem::path& vertexPath, const std::filesystem::path& fragmentPath);
-        ~Shader() = default;
+        ~Shader();
         
         Shader(const Shader&) = delete;
-        Shader(Shader&&) = delete;
+        Shader(Shader&& other) noexcept;
         
         Shader& operator=(const Shader&) = delete;
-        Shader& operator=(Shader&&) = delete;
+        Shader& operator=(Shader&& other) noexcept;
 
         void Use() const;
 
-        inline void Set(const std::string& name, const bool& value) const;
-        inline void Set(const std::string& name, const Int32& value) const;
-        inline void Set(const std::string& name, const Float32& value) const;
-        inline void Set(const std::string& name, const glm::mat2& value) const;
-        inline void Set(const std::string& name, const glm::mat3& value) const;
-        inline void Set(const std::string& name, const glm::mat4& value) const;
-        inline void Set(const std::string& name, const glm::vec2& value) const;
-        inline void Set(const std::string& name, Float32 x, Float32 y) const;
-        inline void Set(const std::string& name, const glm::vec3& value) const;
-        inline void Set(const std::string& name, Float32 x, Float32 y, Float32 z) const;
-        inline void Set(const std::string& name, const glm::vec4& value) const;
-        inline void Set(const std::string& name, Float32 x, Float32 y, Float32 z, Float32 w) const;
+        // The active uniforms are looked up once after linking. -1 if the program doesn't use the uniform.
+        [[nodiscard]] inline Int32 GetUniformLocation(std::string_view name) const;
+
+        // Sources the named uniform block from the buffer range bound at the given binding point.
+        inline void BindUniformBlock(const std::string& name, UInt32 binding) const;
+
+        inline void Set(std::string_view name, const bool& value) const;
+        inline void Set(std::string_view name, const Int32& value) const;
+        inline void Set(std::string_view name, const Float32& value) const;
+        inline void Set(std::string_view name, const glm::mat2& value) const;
+        inline void Set(std::string_view name, const glm::mat3& value) const;
+        inline void Set(std::string_view name, const glm::mat4& value) const;
+        inline void Set(std::string_view name, const glm::vec2& value) const;
+        inline void Set(std::string_view name, Float32 x, Float32 y) const;
+        inline void Set(std::string_view name, const glm::vec3& value) const;
+        inline void Set(std::string_view name, Float32 x, Float32 y, Float32 z) const;
+        inline void Set(std::string_view name, const glm::vec4& value) const;
+        inline void Set(std::string_view name, Float32 x, Float32 y, Float32 z, Float32 w) const;
         
     private:
+        // Hashes std::string_view too, so a lookup doesn't build a std::string.
+        struct UniformNameHash {
+            using is_transparent = void;
+
+            [[nodiscard]] inline std::size_t operator()(std::string_view name) const;
+        };
+
+        std::unordered_map<std::string, Int32, UniformNameHash, std::equal_to<>> m_UniformLocations;
     };
 }
 
@@ -11,53 +11,72 @@
 #include <glm/gtc/type_ptr.hpp>
 
 namespace OGLTest {
-    inline void Shader::Set(const std::string& name, const bool& value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), static_cast<Int32>(value));
+    inline Int32 Shader::GetUniformLocation(const std::string_view name) const {
+        const auto it = m_UniformLocations.find(name);
+        return it != m_UniformLocations.end() ? it->second : -1;
     }
 
-    inline void Shader::Set(const std::string& name, const Int32& value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    inline void Shader::BindUniformBlock(const std::string& name, const UInt32 binding) const {
+        const GLuint index = glGetUniformBlockIndex(ID, name.c_str());
+        if (index == GL_INVALID_INDEX) {
+            std::cerr << "Uniform block " << name << " not found." << '\n';
+            return;
+        }
+
+        glUniformBlockBinding(ID, index, binding);
+    }
+
+    inline void Shader::Set(const std::string_view name, const bool& value) const {
+        glUniform1i(GetUniformLocation(name), static_cast<Int32>(value));
     }
 
-    inline void Shader::Set(const std::string& name, const Float32& value) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    inline void Shader::Set(const std::string_view name, const Int32& value) const {
+        glUniform1i(GetUniformLocation(name), value);
     }
 
-    inline void Shader::Set(const std::string& name, const glm::mat2& value) const {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    inline void Shader::Set(const std::string_view name, const Float32& value) const {
+        glUniform1f(GetUniformLocation(name), value);
     }
 
-    inline void Shader::Set(const std::string& name, const glm::mat3& value) const {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    inline void Shader::Set(const std::string_view name, const glm::mat2& value) const {
+        glUniformMatrix2fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+    inline void Shader::Set(const std::string_view name, const glm::mat3& value) const {
+        glUniformMatrix3fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
     } 
 
-    inline void Shader::Set(const std::string& name, const glm::mat4& value) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    inline void Shader::Set(const std::string_view name, const glm::mat4& value) const {
+        glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
     } 
 
-    inline void Shader::Set(const std::string& name, const glm::vec2& value) const {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+    inline void Shader::Set(const std::string_view name, const glm::vec2& value) const {
+        glUniform2fv(GetUniformLocation(name), 1, glm::value_ptr(value));
     }
 
-    inline void Shader::Set(const std::string& name, const Float32 x, const Float32 y) const {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    inline void Shader::Set(const std::string_view name, const Float32 x, const Float32 y) const {
+        glUniform2f(GetUniformLocation(name), x, y);
     }
 
-    inline void Shader::Set(const std::string& name, const glm::vec3& value) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+    inline void Shader::Set(const std::string_view name, const glm::vec3& value) const {
+        glUniform3fv(GetUniformLocation(name), 1, glm::value_ptr(value));
     }
 
-    inline void Shader::Set(const std::string& name, const Float32 x, const Float32 y, const Float32 z) const {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    inline void Shader::Set(const std::string_view name, const Float32 x, const Float32 y, const Float32 z) const {
+        glUniform3f(GetUniformLocation(name), x, y, z);
     }
 
-    inline void Shader::Set(const std::string& name, const glm::vec4& value) const {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+    inline void Shader::Set(const std::string_view name, const glm::vec4& value) const {
+        glUniform4fv(GetUniformLocation(name), 1, glm::value_ptr(value));
     }
 
-    inline void Shader::Set(const std::string& name, const Float32 x, const Float32 y, const Float32 z, const Float32 w) const {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    inline void Shader::Set(const std::string_view name, const Float32 x, const Float32 y, const Float32 z, const Float32 w) const {
+        glUniform4f(GetUniformLocation(name), x, y, z, w);
         
     }
 
+    inline std::size_t Shader::UniformNameHash::operator()(const std::string_view name) const {
+        return std::hash<std::string_view>{}(name);
+    }
+
 }
@@ -0,0 +1,151 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/MaterialLibrary.hpp>
+#include <OpenGLTest/Model.hpp>
+#include <OpenGLTest/Shader.hpp>
+#include <OpenGLTest/StreamingManager.hpp>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace OGLTest {
+    constexpr UInt32 g_MaxCascades = 4;
+    // The shadow maps use the texture units following the material texture arrays.
+    constexpr UInt32 g_CascadeShadowUnit = g_TextureArrayFirstUnit + g_MaxTextureArrays;
+    constexpr UInt32 g_PointShadowUnit = g_CascadeShadowUnit + 1;
+
+    struct ShadowSettings {
+        UInt32 CascadeCount = 4;
+        UInt32 CascadeResolution = 1024;
+        UInt32 CubeResolution = 512;
+        // The cascades cover the view up to this distance.
+        Float32 ShadowDistance = 100.0f;
+        // Blend between uniform (0) and logarithmic (1) cascade splits.
+        Float32 CascadeSplitLambda = 0.75f;
+        // Casters up to this distance behind a cascade, towards the light, are still rendered into it.
+        Float32 CasterDistance = 50.0f;
+        // A cascade only moves by steps of this fraction of its width, so small camera moves keep it cached.
+        Float32 CascadeSnapFraction = 0.125f;
+        // Number of cached maps re-rendered from the static casters per frame, the others wait for a later frame.
+        UInt32 MaxRefreshesPerFrame = 2;
+    };
+
+    struct ShadowStats {
+        // Cached maps re-rendered from the static casters this frame.
+        UInt32 StaticRefreshes = 0;
+        // Maps whose dynamic casters were drawn over a copy of the cache this frame.
+        UInt32 DynamicComposites = 0;
+        // Out of date maps left for the next frames because of the refresh budget.
+        UInt32 PendingRefreshes = 0;
+    };
+
+    // Matches the std140 shadow members of the FrameData uniform block.
+    struct ShadowUniforms {
+        std::array<glm::mat4, g_MaxCascades> CascadeMatrices;
+        // View space distance where each cascade ends.
+        glm::vec4 CascadeSplits;
+        // Position of the shadowed point light, w is 0 when it doesn't cast shadows.
+        glm::vec4 PointShadowPosition;
+        // Near and far planes of the cube map faces.
+        glm::vec4 PointShadowRange;
+    };
+
+    // Renders cascaded shadow maps for the directional light and a cube map for the point light.
+    // The static casters are rendered into cached maps, only re-rendered when the light or the covered area
+    // changes, and the dynamic meshes are drawn every frame over a copy of the cache.
+    class ShadowRenderer {
+    public:
+        explicit ShadowRenderer(const ShadowSettings& settings = ShadowSettings{});
+        ~ShadowRenderer();
+
+        ShadowRenderer(const ShadowRenderer&) = delete;
+        ShadowRenderer(ShadowRenderer&&) = delete;
+
+        ShadowRenderer& operator=(const ShadowRenderer&) = delete;
+        ShadowRenderer& operator=(ShadowRenderer&&) = delete;
+
+        // Points the shadow samplers of the scene shader at the shadow map units.
+        void ConfigureShader(const Shader& shader) const;
+
+        // direction is the one the light travels in.
+        inline void SetDirectionalLight(const glm::vec3& direction);
+        inline void DisableDirectionalLight();
+        // A range of 0 disables the point light shadows.
+        inline void SetPointLight(const glm::vec3& position, Float32 range);
+        // Marks every cached map as out of date, to call when the static casters changed.
+        inline void InvalidateStatic();
+
+        // Refreshes the out of date maps within the budget and composites the dynamic casters.
+        // Changes the framebuffer, viewport and program, the caller restores its own.
+        void Render(Model& model, StreamingManager* streaming, const glm::mat4& projection, const glm::mat4& view);
+        void Bind() const;
+
+        [[nodiscard]] inline UInt32 GetActiveCascadeCount() const;
+        [[nodiscard]] inline const ShadowSettings& GetSettings() const;
+        [[nodiscard]] inline const ShadowStats& GetStats() const;
+        [[nodiscard]] inline const ShadowUniforms& GetUniforms() const;
+
+    private:
+        struct ShadowMap {
+            // Matrices wanted for this frame, and the ones the cached depth was rendered with, which are the ones
+            // used for shading. A cascade has one, the cube one per face.
+            std::array<glm::mat4, 6> WantedMatrices{};
+            std::array<glm::mat4, 6> CachedMatrices{};
+            UInt32 FaceCount = 1;
+            // Layer of the cascade array, unused by the cube.
+            UInt32 Layer = 0;
+            bool IsCube = false;
+            bool Enabled = false;
+            // Set when the static casters changed since the cache was rendered.
+            bool Invalidated = true;
+            bool HadDynamicCasters = false;
+            UInt64 LastRefreshFrame = 0;
+
+            [[nodiscard]] inline bool NeedsRefresh() const;
+        };
+
+        ShadowSettings m_Settings;
+        Shader m_DepthShader;
+        ShadowStats m_Stats;
+        ShadowUniforms m_Uniforms{};
+        UInt64 m_Frame = 0;
+
+        bool m_HasDirectionalLight = false;
+        glm::vec3 m_LightDirection{0.0f, -1.0f, 0.0f};
+        glm::vec3 m_PointLightPosition{0.0f};
+        Float32 m_PointLightRange = 0.0f;
+        // Point light parameters the cube was rendered with.
+        glm::vec4 m_CachedPointLight{0.0f};
+
+        // Cascades first, the cube last.
+        std::array<ShadowMap, g_MaxCascades + 1> m_Maps;
+        std::vector<UInt32> m_Refreshes;
+
+        // The cached static depth and the depth used for shading, with the cache and the dynamic casters.
+        GLuint m_CascadeCache = 0, m_CascadeTexture = 0;
+        GLuint m_CubeCache = 0, m_CubeTexture = 0;
+        GLuint m_ReadFramebuffer = 0, m_DrawFramebuffer = 0;
+
+        [[nodiscard]] inline ShadowMap& GetCubeMap();
+        [[nodiscard]] inline UInt32 GetResolution(const ShadowMap& map) const;
+
+        void UpdateCascades(const glm::mat4& projection, const glm::mat4& view);
+        void UpdatePointLight();
+        void AttachFace(GLenum target, const ShadowMap& map, UInt32 face, bool cache) const;
+        void DrawCasters(Model& model, StreamingManager* streaming, const glm::mat4& viewProjection, bool dynamic);
+    };
+
+    // Distance where a point light with these attenuation terms falls under 1/256 of its intensity.
+    [[nodiscard]] Float32 ComputeLightRange(Float32 constant, Float32 linear, Float32 quadratic);
+}
+
+#include <OpenGLTest/ShadowRenderer.inl>
@@ -0,0 +1,69 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline void ShadowRenderer::SetDirectionalLight(const glm::vec3& direction) {
+        m_HasDirectionalLight = true;
+        m_LightDirection = glm::normalize(direction);
+    }
+
+    inline void ShadowRenderer::DisableDirectionalLight() {
+        m_HasDirectionalLight = false;
+    }
+
+    inline void ShadowRenderer::SetPointLight(const glm::vec3& position, const Float32 range) {
+        m_PointLightPosition = position;
+        m_PointLightRange = range;
+    }
+
+    inline void ShadowRenderer::InvalidateStatic() {
+        for (auto& map : m_Maps) {
+            map.Invalidated = true;
+        }
+    }
+
+    inline UInt32 ShadowRenderer::GetActiveCascadeCount() const {
+        return m_HasDirectionalLight ? m_Settings.CascadeCount : 0;
+    }
+
+    inline const ShadowSettings& ShadowRenderer::GetSettings() const {
+        return m_Settings;
+    }
+
+    inline const ShadowStats& ShadowRenderer::GetStats() const {
+        return m_Stats;
+    }
+
+    inline const ShadowUniforms& ShadowRenderer::GetUniforms() const {
+        return m_Uniforms;
+    }
+
+    inline bool ShadowRenderer::ShadowMap::NeedsRefresh() const {
+        if (!Enabled) {
+            return false;
+        }
+
+        if (Invalidated) {
+            return true;
+        }
+
+        for (UInt32 face = 0; face < FaceCount; face++) {
+            if (WantedMatrices[face] != CachedMatrices[face]) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    inline ShadowRenderer::ShadowMap& ShadowRenderer::GetCubeMap() {
+        return m_Maps[g_MaxCascades];
+    }
+
+    inline UInt32 ShadowRenderer::GetResolution(const ShadowMap& map) const {
+        return map.IsCube ? m_Settings.CubeResolution : m_Settings.CascadeResolution;
+    }
+}
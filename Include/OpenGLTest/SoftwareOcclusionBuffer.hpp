@@ -0,0 +1,57 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/BoundingVolumes.hpp>
+
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+namespace OGLTest {
+    // Low resolution depth buffer rasterized on the CPU, 4 pixels at a time with SSE when available.
+    // Occluders are rasterized into it and bounding boxes are tested against it, no GPU is involved.
+    class SoftwareOcclusionBuffer {
+    public:
+        // The width is rounded up to a multiple of 4.
+        SoftwareOcclusionBuffer(UInt32 width = 256, UInt32 height = 128);
+        ~SoftwareOcclusionBuffer() = default;
+
+        SoftwareOcclusionBuffer(const SoftwareOcclusionBuffer&) = delete;
+        SoftwareOcclusionBuffer(SoftwareOcclusionBuffer&&) = delete;
+
+        SoftwareOcclusionBuffer& operator=(const SoftwareOcclusionBuffer&) = delete;
+        SoftwareOcclusionBuffer& operator=(SoftwareOcclusionBuffer&&) = delete;
+
+        void Clear();
+
+        // Rasterizes indexed triangles. positions points to the first vertex position, stride is in bytes.
+        void RasterizeIndexed(const glm::mat4& modelViewProjection, const glm::vec3* positions, UInt32 stride,
+                              UInt32 vertexCount, std::span<const UInt32> indices);
+
+        // Returns false if the box is entirely behind what has been rasterized so far.
+        [[nodiscard]] bool IsVisible(const BoundingBox& box, const glm::mat4& viewProjection) const;
+
+        [[nodiscard]] inline UInt32 GetWidth() const;
+        [[nodiscard]] inline UInt32 GetHeight() const;
+        [[nodiscard]] inline std::span<const Float32> GetDepth() const;
+
+    private:
+        UInt32 m_Width;
+        UInt32 m_Height;
+        // Nearest depth in [0, 1] per pixel, rows bottom to top.
+        std::vector<Float32> m_Depth;
+        std::vector<glm::vec4> m_TransformedVertices;
+
+        // Clips the triangle against the near plane and rasterizes what remains.
+        void RasterizeTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2);
+        void RasterizeClippedTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2);
+    };
+}
+
+#include <OpenGLTest/SoftwareOcclusionBuffer.inl>
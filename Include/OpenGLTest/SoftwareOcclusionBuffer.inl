@@ -0,0 +1,19 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline UInt32 SoftwareOcclusionBuffer::GetWidth() const {
+        return m_Width;
+    }
+
+    inline UInt32 SoftwareOcclusionBuffer::GetHeight() const {
+        return m_Height;
+    }
+
+    inline std::span<const Float32> SoftwareOcclusionBuffer::GetDepth() const {
+        return m_Depth;
+    }
+}
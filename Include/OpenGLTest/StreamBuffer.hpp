@@ -0,0 +1,88 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <glad/glad.h>
+
+#include <array>
+#include <vector>
+
+namespace OGLTest {
+    // One region is written by the CPU while the GPU may still read the two previous ones.
+    constexpr UInt32 g_StreamBufferRegionCount = 3;
+
+    struct StreamAllocation {
+        // Where to write the data. Only valid until the next Flush or EndFrame.
+        void* Data = nullptr;
+        // Offset in the GL buffer, for glBindBufferRange or vertex attribute pointers.
+        UInt64 Offset = 0;
+        UInt64 Size = 0;
+
+        [[nodiscard]] inline bool IsValid() const;
+    };
+
+    struct StreamBufferStats {
+        UInt64 AllocatedBytes = 0;
+        UInt32 FailedAllocations = 0;
+        // Frames that had to wait for the GPU to release their region.
+        UInt32 FenceWaits = 0;
+        Float64 FenceWaitMs = 0.0;
+    };
+
+    // Ring of per-frame regions for dynamic data (uniform blocks, instance transforms, lights...) sub-allocated with a
+    // bump pointer. Each region is fenced when its frame ends and only reused once the GPU is done with it, so the
+    // driver never has to orphan or synchronize anything.
+    // With GL 4.4 the buffer is persistently and coherently mapped and the allocations are written in place.
+    // Otherwise they are written to a staging copy uploaded by Flush with glBufferSubData.
+    class StreamBuffer {
+    public:
+        StreamBuffer(GLenum target, UInt64 regionSize, bool allowPersistentMapping = true);
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer(StreamBuffer&&) = delete;
+
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(StreamBuffer&&) = delete;
+
+        // Moves to the next region, waiting for the GPU if it still uses it.
+        void BeginFrame();
+        // Fences the commands issued this frame, flushing pending writes first.
+        void EndFrame();
+
+        // Returns an invalid allocation if the region is full.
+        [[nodiscard]] StreamAllocation Allocate(UInt64 size, UInt64 alignment = 16);
+        // Makes the allocations written so far visible to the GL commands issued afterward.
+        void Flush();
+
+        [[nodiscard]] inline GLuint GetBuffer() const;
+        [[nodiscard]] inline GLenum GetTarget() const;
+        [[nodiscard]] inline UInt64 GetRegionSize() const;
+        [[nodiscard]] inline bool IsPersistent() const;
+        [[nodiscard]] inline const StreamBufferStats& GetStats() const;
+
+    private:
+        GLenum m_Target;
+        GLuint m_Buffer = 0;
+        UInt64 m_RegionSize;
+        bool m_Persistent = false;
+
+        UInt8* m_Mapped = nullptr;
+        std::vector<UInt8> m_Staging;
+
+        std::array<GLsync, g_StreamBufferRegionCount> m_Fences{};
+        UInt32 m_Region = 0;
+        UInt64 m_Head = 0;
+        UInt64 m_FlushedHead = 0;
+
+        StreamBufferStats m_Stats;
+
+        [[nodiscard]] inline UInt64 GetRegionStart() const;
+    };
+}
+
+#include <OpenGLTest/StreamBuffer.inl>
@@ -0,0 +1,35 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline bool StreamAllocation::IsValid() const {
+        return Data != nullptr;
+    }
+
+    inline GLuint StreamBuffer::GetBuffer() const {
+        return m_Buffer;
+    }
+
+    inline GLenum StreamBuffer::GetTarget() const {
+        return m_Target;
+    }
+
+    inline UInt64 StreamBuffer::GetRegionSize() const {
+        return m_RegionSize;
+    }
+
+    inline bool StreamBuffer::IsPersistent() const {
+        return m_Persistent;
+    }
+
+    inline const StreamBufferStats& StreamBuffer::GetStats() const {
+        return m_Stats;
+    }
+
+    inline UInt64 StreamBuffer::GetRegionStart() const {
+        return static_cast<UInt64>(m_Region) * m_RegionSize;
+    }
+}
@@ -0,0 +1,120 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <OpenGLTest/pch.hpp>
+
+#include <OpenGLTest/ChunkFile.hpp>
+#include <OpenGLTest/JobSystem.hpp>
+#include <OpenGLTest/Shader.hpp>
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OGLTest {
+    struct StreamingSettings {
+        // Chunks closer than this to the camera are requested.
+        Float32 LoadRadius = 96.0f;
+        // Memory used by chunks read from disk and not uploaded yet.
+        UInt64 CpuBudget = 64ull * 1024 * 1024;
+        // Memory used by the vertex/index buffers of resident chunks.
+        UInt64 GpuBudget = 256ull * 1024 * 1024;
+        // Uploads are spread over several frames to avoid hitches.
+        UInt32 MaxUploadsPerFrame = 8;
+        UInt32 IoThreadCount = 2;
+    };
+
+    struct ResidencyStats {
+        UInt32 TotalChunks = 0;
+        UInt32 RequestedChunks = 0;
+        UInt32 QueuedChunks = 0;
+        UInt32 LoadingChunks = 0;
+        UInt32 ResidentChunks = 0;
+        UInt32 UploadsThisFrame = 0;
+        UInt32 EvictionsThisFrame = 0;
+        UInt64 CpuBytes = 0;
+        UInt64 GpuBytes = 0;
+    };
+
+    // Pages the chunks of a packed chunk file in and out around the camera.
+    // Reads happen on background I/O threads, GL uploads and evictions on the thread calling Update.
+    class StreamingManager {
+    public:
+        explicit StreamingManager(JobSystem& jobs, const StreamingSettings& settings = StreamingSettings{});
+        ~StreamingManager();
+
+        StreamingManager(const StreamingManager&) = delete;
+        StreamingManager(StreamingManager&&) = delete;
+
+        StreamingManager& operator=(const StreamingManager&) = delete;
+        StreamingManager& operator=(StreamingManager&&) = delete;
+
+        bool Open(const std::filesystem::path& path);
+        void Close();
+
+        // Reprioritizes the requests, uploads finished reads and evicts least recently used chunks over budget.
+        void Update(const glm::vec3& cameraPosition);
+        void Draw(Shader& shader, const Frustum& frustum);
+
+        [[nodiscard]] inline const StreamingSettings& GetSettings() const;
+        [[nodiscard]] inline const ResidencyStats& GetStats() const;
+
+    private:
+        enum class ChunkState : UInt8 {
+            Unloaded,
+            Queued,
+            Loading,
+            Loaded,
+            Resident
+        };
+
+        struct Chunk {
+            ChunkDesc Desc;
+            ChunkState State = ChunkState::Unloaded;
+            Float32 Priority = 0.0f;
+            UInt64 LastUsedFrame = 0;
+            std::unique_ptr<ChunkData> Data;
+            GLuint VAO = 0, VBO = 0, EBO = 0;
+        };
+
+        JobSystem& m_Jobs;
+        StreamingSettings m_Settings;
+        std::filesystem::path m_Path;
+        std::vector<Chunk> m_Chunks;
+        UInt64 m_Frame = 0;
+        UInt64 m_GpuBytes = 0;
+        ResidencyStats m_Stats;
+        // Only touched by the thread calling Update: chunks read by the I/O threads waiting for a GL upload,
+        // and chunks whose buffers are on the GPU.
+        std::vector<UInt32> m_PendingUploads;
+        std::vector<UInt32> m_ResidentChunks;
+        // Frustum test result of each resident chunk, UInt8 so jobs can write neighbouring flags.
+        std::vector<UInt8> m_VisibleChunks;
+
+        // Shared with the I/O threads, guarded by m_Mutex: the chunk states, Data, m_Requests and m_Completed.
+        mutable std::mutex m_Mutex;
+        std::condition_variable m_RequestAvailable;
+        std::vector<UInt32> m_Requests;
+        std::vector<UInt32> m_Completed;
+        UInt64 m_CpuBytes = 0;
+        std::atomic<bool> m_Stop = false;
+        std::vector<std::thread> m_IoThreads;
+
+        void IoThreadMain();
+        void Upload(UInt32 chunkIndex);
+        void Evict(UInt32 chunkIndex);
+        // Evicts chunks not used this frame, least recently used first, until size more bytes fit in the budget.
+        bool MakeGpuRoom(UInt64 size);
+    };
+}
+
+#include <OpenGLTest/StreamingManager.inl>
@@ -0,0 +1,15 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+namespace OGLTest {
+    inline const StreamingSettings& StreamingManager::GetSettings() const {
+        return m_Settings;
+    }
+
+    inline const ResidencyStats& StreamingManager::GetStats() const {
+        return m_Stats;
+    }
+}
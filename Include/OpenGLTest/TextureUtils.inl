@@ -1,53 +0,0 @@
-// Copyright (C) 2024 Jean "Pixfri" Letessier 
-// This file is part of OpenGL Test.
-// For conditions of distribution and use, see copyright notice in LICENSE
-
-#pragma once
-
-#include <glad/glad.h>
-
-#include <stb/stb_image.h>
-
-namespace OGLTest {
-    inline UInt32 LoadTextureFromFile(const char* path, const std::string& directory, bool gamma) {
-        OGLTEST_UNUSED(gamma);
-        std::string filename = std::string(path);
-        filename = directory + '/' + filename;
-
-        UInt32 textureId;
-        glGenTextures(1, &textureId);
-
-        Int32 width, height, nrComponents;
-        unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-        if (data) {
-            GLenum format;
-            if (nrComponents == 1) {
-                format = GL_RED;
-            }
-
-            if (nrComponents == 3) {
-                format = GL_RGB;
-            }
-
-            if (nrComponents == 4) {
-                format = GL_RGBA;
-            }
-
-            glBindTexture(GL_TEXTURE_2D, textureId);
-            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-            stbi_image_free(data);
-        } else {
-            std::cerr << "Failed to load texture at path: " << path << '\n';
-            stbi_image_free(data);
-        }
-
-        return textureId;
-    }
-}
@@ -9,11 +9,32 @@ out vec3 Normal;
 out vec2 UV;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+
+// Written once per frame through a stream buffer, see SceneRenderer.
+layout (std140) uniform FrameData {
+    mat4 proj;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPosition;
+    vec4 lightAmbient;
+    vec4 lightDiffuse;
+    vec4 lightSpecular;
+    // constant, linear, quadratic
+    vec4 lightAttenuation;
+    // xyz is the direction the light travels in, w the number of shadow cascades
+    vec4 sunDirection;
+    vec4 sunColor;
+    mat4 cascadeMatrices[4];
+    // view space distance where each cascade ends
+    vec4 cascadeSplits;
+    // w is 0 when the point light doesn't cast shadows
+    vec4 pointShadowPosition;
+    // near, far
+    vec4 pointShadowRange;
+} frame;
 
 void main() {
-    gl_Position = proj * view * model * vec4(aPos, 1.0);
+    gl_Position = frame.proj * frame.view * model * vec4(aPos, 1.0);
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     UV = aUV;
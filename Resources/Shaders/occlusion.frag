@@ -0,0 +1,5 @@
+#version 330 core
+
+void main() {
+    // Only the depth test matters for occlusion queries, color writes are masked.
+}
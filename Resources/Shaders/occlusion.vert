@@ -0,0 +1,12 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 viewProj;
+uniform vec3 boxMin;
+uniform vec3 boxMax;
+
+void main() {
+    // aPos is a corner of the unit cube, stretch it over the tested bounding box
+    gl_Position = viewProj * vec4(mix(boxMin, boxMax, aPos), 1.0);
+}
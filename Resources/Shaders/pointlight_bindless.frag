@@ -0,0 +1,148 @@
+#version 430 core
+#extension GL_ARB_bindless_texture : require
+
+struct Light {
+    vec3 position;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+// Written once per frame through a stream buffer, see SceneRenderer.
+layout (std140) uniform FrameData {
+    mat4 proj;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPosition;
+    vec4 lightAmbient;
+    vec4 lightDiffuse;
+    vec4 lightSpecular;
+    // constant, linear, quadratic
+    vec4 lightAttenuation;
+    // xyz is the direction the light travels in, w the number of shadow cascades
+    vec4 sunDirection;
+    vec4 sunColor;
+    mat4 cascadeMatrices[4];
+    // view space distance where each cascade ends
+    vec4 cascadeSplits;
+    // w is 0 when the point light doesn't cast shadows
+    vec4 pointShadowPosition;
+    // near, far
+    vec4 pointShadowRange;
+} frame;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 UV;
+
+out vec4 FragColor;
+
+// Texture array and layer of each texture, negative when the material doesn't have it. See MaterialLibrary.
+struct Material {
+    ivec2 diffuse;
+    ivec2 specular;
+    ivec2 shininess;
+    ivec2 padding;
+};
+
+layout (std140) uniform Materials {
+    Material materials[512];
+};
+
+uniform int materialIndex;
+
+layout (std430, binding = 2) readonly buffer TextureHandles {
+    uvec2 textureHandles[];
+};
+
+vec4 SampleTexture(ivec2 ref, vec2 uv) {
+    if (ref.x < 0) {
+        return vec4(1.0);
+    }
+
+    return texture(sampler2DArray(textureHandles[ref.x]), vec3(uv, float(ref.y)));
+}
+
+// Shadow maps, see ShadowRenderer.
+uniform sampler2DArrayShadow cascadeShadowMap;
+uniform samplerCubeShadow pointShadowMap;
+
+float CascadeShadow() {
+    float viewDepth = -(frame.view * vec4(FragPos, 1.0)).z;
+
+    for (int i = 0; i < int(frame.sunDirection.w); i++) {
+        if (viewDepth <= frame.cascadeSplits[i]) {
+            vec4 lightSpace = frame.cascadeMatrices[i] * vec4(FragPos, 1.0);
+            vec3 coords = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+            return texture(cascadeShadowMap, vec4(coords.xy, float(i), min(coords.z, 1.0)));
+        }
+    }
+
+    return 1.0;
+}
+
+float PointShadow() {
+    if (frame.pointShadowPosition.w == 0.0) {
+        return 1.0;
+    }
+
+    // The cube faces store the perspective depth along their major axis.
+    vec3 toFragment = FragPos - frame.pointShadowPosition.xyz;
+    vec3 axes = abs(toFragment);
+    float majorAxis = max(axes.x, max(axes.y, axes.z));
+    float near = frame.pointShadowRange.x;
+    float far = frame.pointShadowRange.y;
+    if (majorAxis >= far) {
+        return 1.0;
+    }
+
+    float depth = (far + near) / (far - near) - 2.0 * far * near / ((far - near) * majorAxis);
+    return texture(pointShadowMap, vec4(toFragment, depth * 0.5 + 0.5));
+}
+
+void main() {
+    Light light = Light(frame.lightPosition.xyz, frame.lightAmbient.xyz, frame.lightDiffuse.xyz,
+                        frame.lightSpecular.xyz, frame.lightAttenuation.x, frame.lightAttenuation.y,
+                        frame.lightAttenuation.z);
+    vec3 viewPos = frame.viewPos.xyz;
+
+    Material material = materialIndex >= 0 ? materials[materialIndex]
+                                           : Material(ivec2(-1), ivec2(-1), ivec2(-1), ivec2(-1));
+    vec4 diffuseColor = SampleTexture(material.diffuse, UV);
+    vec4 specularColor = SampleTexture(material.specular, UV);
+    vec4 shininess = SampleTexture(material.shininess, UV);
+
+    // Ambient lighting
+    vec3 ambient = light.ambient * diffuseColor.rgb;
+    // Diffuse lighting
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(light.position - FragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = light.diffuse * diff * diffuseColor.rgb;
+    // Specular lighting    
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess.r);
+    vec3 specular = light.specular * spec * specularColor.rgb;
+
+    // Attenuation
+    float distance = length(light.position - FragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    ambient *= attenuation;
+    diffuse *= attenuation;
+    specular *= attenuation;
+
+    float pointShadow = PointShadow();
+    diffuse *= pointShadow;
+    specular *= pointShadow;
+
+    // Directional light, diffuse only
+    vec3 sun = frame.sunColor.rgb * max(dot(norm, -frame.sunDirection.xyz), 0.0) * diffuseColor.rgb * CascadeShadow();
+
+    FragColor = vec4(ambient + diffuse + specular + sun, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,5 @@
+#version 330 core
+
+void main() {
+    // Depth only, the shadow framebuffers have no color attachment.
+}
@@ -0,0 +1,10 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 lightViewProj;
+uniform mat4 model;
+
+void main() {
+    gl_Position = lightViewProj * model * vec4(aPos, 1.0);
+}
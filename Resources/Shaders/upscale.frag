@@ -0,0 +1,37 @@
+#version 330 core
+
+in vec2 UV;
+
+out vec4 FragColor;
+
+uniform sampler2D sceneColor;
+// Part of the scene texture that was rendered this frame, in texture coordinates.
+uniform vec2 renderScale;
+uniform vec2 texelSize;
+// 0 for a plain bilinear upscale.
+uniform float sharpness;
+
+vec3 SampleScene(vec2 uv) {
+    // Stay half a texel inside the rendered part, the rest of the texture holds older frames.
+    return texture(sceneColor, clamp(uv, 0.5 * texelSize, renderScale - 0.5 * texelSize)).rgb;
+}
+
+void main() {
+    vec2 uv = UV * renderScale;
+    vec3 color = SampleScene(uv);
+
+    if (sharpness > 0.0) {
+        vec3 left = SampleScene(uv - vec2(texelSize.x, 0.0));
+        vec3 right = SampleScene(uv + vec2(texelSize.x, 0.0));
+        vec3 down = SampleScene(uv - vec2(0.0, texelSize.y));
+        vec3 up = SampleScene(uv + vec2(0.0, texelSize.y));
+
+        // Unsharp mask, clamped to the neighbourhood so edges don't get halos.
+        vec3 sharpened = color + (color - 0.25 * (left + right + down + up)) * sharpness;
+        vec3 low = min(color, min(min(left, right), min(down, up)));
+        vec3 high = max(color, max(max(left, right), max(down, up)));
+        color = clamp(sharpened, low, high);
+    }
+
+    FragColor = vec4(color, 1.0);
+}
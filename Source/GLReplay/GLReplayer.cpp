@@ -0,0 +1,970 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <GLReplay/GLReplayer.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+namespace OGLTest {
+    namespace {
+        using ReplayClock = std::chrono::steady_clock;
+
+        Float64 ToMilliseconds(const ReplayClock::duration duration) {
+            return std::chrono::duration<Float64, std::milli>(duration).count();
+        }
+
+        // Indexed bindings: the target, the index and which of the buffer, offset and size.
+        constexpr UInt64 GetIndexedBindingKey(const GLenum target, const GLuint index, const UInt64 field) {
+            return field << 48 | static_cast<UInt64>(index) << 16 | target;
+        }
+
+        constexpr UInt64 Pack(const UInt32 low, const UInt32 high) {
+            return static_cast<UInt64>(high) << 32 | low;
+        }
+    }
+
+    UInt64 GLReplayer::StateKeyHash::operator()(const StateKey& key) const {
+        return std::hash<UInt64>{}(key.Key * 0x9E3779B97F4A7C15ull ^ static_cast<UInt64>(key.Command));
+    }
+
+    GLReplayer::GLReplayer(const ReplaySettings& settings) : m_Settings(settings) {}
+
+    GLReplayer::~GLReplayer() {
+        if (m_Framebuffer != 0) {
+            glDeleteFramebuffers(1, &m_Framebuffer);
+            glDeleteRenderbuffers(1, &m_ColorRenderbuffer);
+            glDeleteRenderbuffers(1, &m_DepthRenderbuffer);
+        }
+    }
+
+    bool GLReplayer::Open(const std::filesystem::path& path) {
+        if (!m_Reader.Open(path)) {
+            return false;
+        }
+
+        const CaptureFileHeader& header = m_Reader.GetHeader();
+        const auto width = static_cast<GLsizei>(std::max(header.Width, 1u));
+        const auto height = static_cast<GLsizei>(std::max(header.Height, 1u));
+
+        glGenRenderbuffers(1, &m_ColorRenderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, m_ColorRenderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+        glGenRenderbuffers(1, &m_DepthRenderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, m_DepthRenderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &m_Framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_ColorRenderbuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthRenderbuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Couldn't create the replay framebuffer." << '\n';
+            return false;
+        }
+
+        glViewport(0, 0, width, height);
+        return true;
+    }
+
+    bool GLReplayer::Replay() {
+        m_Frames.assign(1, ReplayFrameStats{});
+        ReplayClock::time_point frameStart = ReplayClock::now();
+
+        GLCommand command;
+        while (m_Reader.ReadCommand(command)) {
+            if (command == GLCommand::FrameEnd) {
+                glFinish();
+
+                const ReplayClock::time_point frameEnd = ReplayClock::now();
+                m_Frames.back().FrameMs = ToMilliseconds(frameEnd - frameStart);
+                m_Frames.emplace_back();
+                frameStart = frameEnd;
+                continue;
+            }
+
+            ReplayFrameStats& frame = m_Frames.back();
+            const GLCommandKind kind = GetCommandKind(command);
+
+            const ReplayClock::time_point start = ReplayClock::now();
+            const bool redundant = Execute(command, frame);
+            if (m_Settings.SyncDraws && kind == GLCommandKind::Draw) {
+                glFinish();
+            }
+            const Float64 ms = ToMilliseconds(ReplayClock::now() - start);
+
+            frame.CallMs += ms;
+            frame.Calls.Calls++;
+            frame.Calls.DrawCalls += kind == GLCommandKind::Draw ? 1 : 0;
+            frame.Calls.Binds += kind == GLCommandKind::Bind ? 1 : 0;
+            frame.RedundantCalls += redundant ? 1 : 0;
+
+            if (m_Frames.size() > 1 || m_Settings.TimeLoading) {
+                CommandTiming& timing = m_Timings[static_cast<UInt64>(command)];
+                timing.Count++;
+                timing.Redundant += redundant ? 1 : 0;
+                timing.TotalMs += ms;
+                timing.MaxMs = std::max(timing.MaxMs, ms);
+            }
+        }
+
+        // Calls recorded after the last frame ended, if the capture stopped with the application.
+        if (m_Frames.size() > 1 && m_Frames.back().Calls.Calls == 0) {
+            m_Frames.pop_back();
+        } else if (m_Frames.back().FrameMs == 0.0) {
+            glFinish();
+            m_Frames.back().FrameMs = ToMilliseconds(ReplayClock::now() - frameStart);
+        }
+
+        return !m_Reader.HasFailed();
+    }
+
+    GLuint GLReplayer::Remap(const NameMap& names, const GLuint name) {
+        if (name == 0) {
+            return 0;
+        }
+
+        const auto mapped = names.find(name);
+        if (mapped == names.end()) {
+            m_UnknownNames++;
+            return name;
+        }
+
+        return mapped->second;
+    }
+
+    GLint GLReplayer::RemapLocation(const GLint location) const {
+        if (location < 0) {
+            return location;
+        }
+
+        const auto mapped = m_UniformLocations.find(Pack(static_cast<UInt32>(location), m_Program));
+        return mapped != m_UniformLocations.end() ? mapped->second : location;
+    }
+
+    GLenum GLReplayer::RemapColorBuffer(const GLenum buffer, const GLuint framebuffer) const {
+        // The offscreen stand-in of the default framebuffer only has a color attachment.
+        if (framebuffer == 0 && buffer != GL_NONE) {
+            return GL_COLOR_ATTACHMENT0;
+        }
+
+        return buffer;
+    }
+
+    void GLReplayer::GenNames(NameMap& names, void(APIENTRYP generate)(GLsizei, GLuint*)) {
+        const auto n = m_Reader.Read<GLsizei>();
+        for (GLsizei i = 0; i < n; i++) {
+            GLuint name = 0;
+            generate(1, &name);
+            names[m_Reader.Read<GLuint>()] = name;
+        }
+    }
+
+    void GLReplayer::DeleteNames(NameMap& names, void(APIENTRYP release)(GLsizei, const GLuint*),
+                                 const GLCommand bindCommand) {
+        const auto n = m_Reader.Read<GLsizei>();
+        for (GLsizei i = 0; i < n; i++) {
+            const auto recorded = m_Reader.Read<GLuint>();
+            ForgetObject(bindCommand, recorded);
+
+            const auto mapped = names.find(recorded);
+            if (mapped != names.end()) {
+                release(1, &mapped->second);
+                names.erase(mapped);
+            }
+        }
+    }
+
+    bool GLReplayer::SetState(const GLCommand command, const UInt64 key, const UInt64 value) {
+        const auto [state, inserted] = m_State.try_emplace(StateKey{command, key}, value);
+        if (inserted) {
+            const std::optional<UInt64> initial = GetInitialState(command, key);
+            return initial && *initial == value;
+        }
+
+        const bool redundant = state->second == value;
+        state->second = value;
+        return redundant;
+    }
+
+    std::optional<UInt64> GLReplayer::GetInitialState(const GLCommand command, const UInt64 key) const {
+        switch (command) {
+            case GLCommand::ActiveTexture: {
+                return GL_TEXTURE0;
+            }
+            case GLCommand::ColorMask: {
+                return 0x01010101;
+            }
+            case GLCommand::DepthMask: {
+                return GL_TRUE;
+            }
+            case GLCommand::Enable: {
+                return key == GL_DITHER || key == GL_MULTISAMPLE ? 1 : 0;
+            }
+            case GLCommand::PixelStorei: {
+                return key == GL_UNPACK_ALIGNMENT || key == GL_PACK_ALIGNMENT ? 4 : 0;
+            }
+            case GLCommand::Viewport: {
+                const CaptureFileHeader& header = m_Reader.GetHeader();
+                return key == 0 ? 0 : Pack(header.Width, header.Height);
+            }
+            // Depend on the object or on the parameter.
+            case GLCommand::DrawBuffer:
+            case GLCommand::ReadBuffer:
+            case GLCommand::TexParameteri: {
+                return std::nullopt;
+            }
+            // Bindings, clear color, polygon offset, block bindings and enabled attributes all start at 0.
+            default: {
+                return 0;
+            }
+        }
+    }
+
+    void GLReplayer::ForgetObject(const GLCommand bindCommand, const GLuint name) {
+        for (auto it = m_State.begin(); it != m_State.end();) {
+            const StateKey& key = it->first;
+            const auto owner = static_cast<GLuint>(key.Key >> 32);
+
+            bool erase = false;
+            switch (bindCommand) {
+                case GLCommand::BindBuffer: {
+                    const bool bufferField = key.Command == GLCommand::BindBufferBase && key.Key >> 48 == 0;
+                    if ((key.Command == GLCommand::BindBuffer || bufferField) && it->second == name) {
+                        it->second = 0;
+                    }
+                    break;
+                }
+                case GLCommand::BindTexture: {
+                    if (key.Command == GLCommand::BindTexture && it->second == name) {
+                        it->second = 0;
+                    }
+                    erase = key.Command == GLCommand::TexParameteri && owner == name;
+                    break;
+                }
+                case GLCommand::BindVertexArray: {
+                    if (key.Command == GLCommand::BindVertexArray && it->second == name) {
+                        it->second = 0;
+                    }
+                    // The element buffer binding and the enabled attributes belong to the vertex array.
+                    erase = (key.Command == GLCommand::EnableVertexAttribArray ||
+                             (key.Command == GLCommand::BindBuffer && (key.Key & 0xFFFFFFFF) == GL_ELEMENT_ARRAY_BUFFER))
+                            && owner == name;
+                    break;
+                }
+                case GLCommand::BindFramebuffer: {
+                    if (key.Command == GLCommand::BindFramebuffer && it->second == name) {
+                        it->second = 0;
+                    }
+                    erase = (key.Command == GLCommand::DrawBuffer || key.Command == GLCommand::ReadBuffer) &&
+                            key.Key == name;
+                    break;
+                }
+                case GLCommand::BindRenderbuffer: {
+                    if (key.Command == GLCommand::BindRenderbuffer && it->second == name) {
+                        it->second = 0;
+                    }
+                    break;
+                }
+                // A deleted program stays in use until another one is, only its own states go.
+                case GLCommand::UseProgram: {
+                    erase = key.Command == GLCommand::UniformBlockBinding && owner == name;
+                    break;
+                }
+                default: {
+                    break;
+                }
+            }
+
+            it = erase ? m_State.erase(it) : std::next(it);
+        }
+
+        if (bindCommand == GLCommand::BindFramebuffer) {
+            m_DrawFramebuffer = m_DrawFramebuffer == name ? 0 : m_DrawFramebuffer;
+            m_ReadFramebuffer = m_ReadFramebuffer == name ? 0 : m_ReadFramebuffer;
+        } else if (bindCommand == GLCommand::BindVertexArray && m_VertexArray == name) {
+            m_VertexArray = 0;
+        } else if (bindCommand == GLCommand::UseProgram) {
+            std::erase_if(m_UniformValues, [name](const auto& uniform) {
+                return static_cast<GLuint>(uniform.first >> 32) == name;
+            });
+        }
+    }
+
+    bool GLReplayer::SetUniform(const GLint location, const void* value, const UInt64 size) {
+        // Setting a uniform the program doesn't have does nothing.
+        if (location < 0) {
+            return true;
+        }
+
+        std::vector<UInt8>& current = m_UniformValues[Pack(static_cast<UInt32>(location), m_Program)];
+        const auto* bytes = static_cast<const UInt8*>(value);
+        const bool redundant = current.size() == size && std::equal(bytes, bytes + size, current.begin());
+        current.assign(bytes, bytes + size);
+        return redundant;
+    }
+
+    const GLfloat* GLReplayer::ReadFloats() {
+        const std::span<const UInt8> data = m_Reader.ReadData();
+        if (!data.data()) {
+            return nullptr;
+        }
+
+        m_Floats.resize(data.size() / sizeof(GLfloat));
+        std::memcpy(m_Floats.data(), data.data(), m_Floats.size() * sizeof(GLfloat));
+        return m_Floats.data();
+    }
+
+    const void* GLReplayer::ReadImage(UInt64& size) {
+        // 1 when the pixels come from the bound pixel unpack buffer, at an offset.
+        if (m_Reader.Read<UInt8>() != 0) {
+            size = 0;
+            return m_Reader.Read<const void*>();
+        }
+
+        const std::span<const UInt8> data = m_Reader.ReadData();
+        size = data.size();
+        return data.data();
+    }
+
+    bool GLReplayer::Execute(const GLCommand command, ReplayFrameStats& frame) {
+        GLCaptureReader& reader = m_Reader;
+
+        switch (command) {
+            case GLCommand::ActiveTexture: {
+                const auto texture = reader.Read<GLenum>();
+                m_ActiveTexture = texture;
+                const bool redundant = SetState(command, 0, texture);
+                glActiveTexture(texture);
+                return redundant;
+            }
+            case GLCommand::AttachShader: {
+                const auto program = reader.Read<GLuint>();
+                const auto shader = reader.Read<GLuint>();
+                glAttachShader(Remap(m_Programs, program), Remap(m_Programs, shader));
+                return false;
+            }
+            case GLCommand::BeginConditionalRender: {
+                const auto id = reader.Read<GLuint>();
+                const auto mode = reader.Read<GLenum>();
+                glBeginConditionalRender(Remap(m_Queries, id), mode);
+                return false;
+            }
+            case GLCommand::BeginQuery: {
+                const auto target = reader.Read<GLenum>();
+                const auto id = reader.Read<GLuint>();
+                glBeginQuery(target, Remap(m_Queries, id));
+                return false;
+            }
+            case GLCommand::BindBuffer: {
+                const auto target = reader.Read<GLenum>();
+                const auto buffer = reader.Read<GLuint>();
+                // The element buffer binding is part of the vertex array state.
+                const UInt64 key = target == GL_ELEMENT_ARRAY_BUFFER ? Pack(target, m_VertexArray) : target;
+                const bool redundant = SetState(command, key, buffer);
+                glBindBuffer(target, Remap(m_Buffers, buffer));
+                return redundant;
+            }
+            case GLCommand::BindBufferBase:
+            case GLCommand::BindBufferRange: {
+                const auto target = reader.Read<GLenum>();
+                const auto index = reader.Read<GLuint>();
+                const auto buffer = reader.Read<GLuint>();
+                GLintptr offset = 0;
+                GLsizeiptr size = -1;
+                if (command == GLCommand::BindBufferRange) {
+                    offset = reader.Read<GLintptr>();
+                    size = reader.Read<GLsizeiptr>();
+                }
+
+                const bool sameBuffer = SetState(GLCommand::BindBufferBase, GetIndexedBindingKey(target, index, 0),
+                                                 buffer);
+                const bool sameOffset = SetState(GLCommand::BindBufferBase, GetIndexedBindingKey(target, index, 1),
+                                                 static_cast<UInt64>(offset));
+                const bool sameSize = SetState(GLCommand::BindBufferBase, GetIndexedBindingKey(target, index, 2),
+                                               static_cast<UInt64>(size));
+                // Also binds the generic binding point of the target.
+                SetState(GLCommand::BindBuffer, target, buffer);
+
+                if (command == GLCommand::BindBufferRange) {
+                    glBindBufferRange(target, index, Remap(m_Buffers, buffer), offset, size);
+                } else {
+                    glBindBufferBase(target, index, Remap(m_Buffers, buffer));
+                }
+                return sameBuffer && sameOffset && sameSize;
+            }
+            case GLCommand::BindFramebuffer: {
+                const auto target = reader.Read<GLenum>();
+                const auto framebuffer = reader.Read<GLuint>();
+
+                bool redundant = true;
+                if (target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER) {
+                    redundant = SetState(command, GL_DRAW_FRAMEBUFFER, framebuffer) && redundant;
+                    m_DrawFramebuffer = framebuffer;
+                }
+                if (target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER) {
+                    redundant = SetState(command, GL_READ_FRAMEBUFFER, framebuffer) && redundant;
+                    m_ReadFramebuffer = framebuffer;
+                }
+
+                glBindFramebuffer(target, framebuffer == 0 ? m_Framebuffer : Remap(m_Framebuffers, framebuffer));
+                return redundant;
+            }
+            case GLCommand::BindRenderbuffer: {
+                const auto target = reader.Read<GLenum>();
+                const auto renderbuffer = reader.Read<GLuint>();
+                const bool redundant = SetState(command, 0, renderbuffer);
+                glBindRenderbuffer(target, Remap(m_Renderbuffers, renderbuffer));
+                return redundant;
+            }
+            case GLCommand::BindTexture: {
+                const auto target = reader.Read<GLenum>();
+                const auto texture = reader.Read<GLuint>();
+                const bool redundant = SetState(command, Pack(target, m_ActiveTexture - GL_TEXTURE0), texture);
+                glBindTexture(target, Remap(m_Textures, texture));
+                return redundant;
+            }
+            case GLCommand::BindVertexArray: {
+                const auto array = reader.Read<GLuint>();
+                m_VertexArray = array;
+                const bool redundant = SetState(command, 0, array);
+                glBindVertexArray(Remap(m_VertexArrays, array));
+                return redundant;
+            }
+            case GLCommand::BlitFramebuffer: {
+                std::array<GLint, 8> rectangles{};
+                for (GLint& coordinate : rectangles) {
+                    coordinate = reader.Read<GLint>();
+                }
+                const auto mask = reader.Read<GLbitfield>();
+                const auto filter = reader.Read<GLenum>();
+                glBlitFramebuffer(rectangles[0], rectangles[1], rectangles[2], rectangles[3], rectangles[4],
+                                  rectangles[5], rectangles[6], rectangles[7], mask, filter);
+                return false;
+            }
+            case GLCommand::BufferData:
+            case GLCommand::BufferStorage: {
+                const auto target = reader.Read<GLenum>();
+                const auto size = reader.Read<GLsizeiptr>();
+                const std::span<const UInt8> data = reader.ReadData();
+                const auto usage = reader.Read<GLenum>();
+                frame.Calls.UploadedBytes += data.size();
+
+#ifdef GL_MAP_PERSISTENT_BIT
+                if (command == GLCommand::BufferStorage) {
+                    glBufferStorage(target, size, data.data(), usage);
+                    return false;
+                }
+#endif
+                glBufferData(target, size, data.data(), command == GLCommand::BufferData ? usage : GL_STREAM_DRAW);
+                return false;
+            }
+            case GLCommand::BufferSubData: {
+                const auto target = reader.Read<GLenum>();
+                const auto offset = reader.Read<GLintptr>();
+                const auto size = reader.Read<GLsizeiptr>();
+                const std::span<const UInt8> data = reader.ReadData();
+                frame.Calls.UploadedBytes += data.size();
+                glBufferSubData(target, offset, size, data.data());
+                return false;
+            }
+            case GLCommand::Clear: {
+                glClear(reader.Read<GLbitfield>());
+                return false;
+            }
+            case GLCommand::ClearColor: {
+                std::array<GLfloat, 4> color{};
+                for (GLfloat& component : color) {
+                    component = reader.Read<GLfloat>();
+                }
+                const bool sameRedGreen = SetState(command, 0, Pack(std::bit_cast<UInt32>(color[0]),
+                                                                    std::bit_cast<UInt32>(color[1])));
+                const bool sameBlueAlpha = SetState(command, 1, Pack(std::bit_cast<UInt32>(color[2]),
+                                                                     std::bit_cast<UInt32>(color[3])));
+                glClearColor(color[0], color[1], color[2], color[3]);
+                return sameRedGreen && sameBlueAlpha;
+            }
+            case GLCommand::ClientWaitSync: {
+                const auto sync = reader.Read<UInt64>();
+                const auto flags = reader.Read<GLbitfield>();
+                const auto timeout = reader.Read<GLuint64>();
+                OGLTEST_UNUSED(reader.Read<GLenum>());
+
+                const auto mapped = m_Syncs.find(sync);
+                if (mapped != m_Syncs.end()) {
+                    glClientWaitSync(mapped->second, flags, timeout);
+                }
+                return false;
+            }
+            case GLCommand::ColorMask: {
+                UInt32 mask = 0;
+                for (UInt32 i = 0; i < 4; i++) {
+                    mask |= static_cast<UInt32>(reader.Read<GLboolean>() ? 1 : 0) << (i * 8);
+                }
+                const bool redundant = SetState(command, 0, mask);
+                glColorMask(mask & 0xFF, (mask >> 8) & 0xFF, (mask >> 16) & 0xFF, (mask >> 24) & 0xFF);
+                return redundant;
+            }
+            case GLCommand::CompileShader: {
+                glCompileShader(Remap(m_Programs, reader.Read<GLuint>()));
+                return false;
+            }
+            case GLCommand::CreateProgram: {
+                m_Programs[reader.Read<GLuint>()] = glCreateProgram();
+                return false;
+            }
+            case GLCommand::CreateShader: {
+                const auto type = reader.Read<GLenum>();
+                m_Programs[reader.Read<GLuint>()] = glCreateShader(type);
+                return false;
+            }
+            case GLCommand::DeleteBuffers: {
+                DeleteNames(m_Buffers, glDeleteBuffers, GLCommand::BindBuffer);
+                return false;
+            }
+            case GLCommand::DeleteFramebuffers: {
+                DeleteNames(m_Framebuffers, glDeleteFramebuffers, GLCommand::BindFramebuffer);
+                return false;
+            }
+            case GLCommand::DeleteProgram:
+            case GLCommand::DeleteShader: {
+                const auto name = reader.Read<GLuint>();
+                const auto mapped = m_Programs.find(name);
+                if (mapped != m_Programs.end()) {
+                    if (command == GLCommand::DeleteProgram) {
+                        ForgetObject(GLCommand::UseProgram, name);
+                        glDeleteProgram(mapped->second);
+                    } else {
+                        glDeleteShader(mapped->second);
+                    }
+                    m_Programs.erase(mapped);
+                }
+                return false;
+            }
+            case GLCommand::DeleteQueries: {
+                DeleteNames(m_Queries, glDeleteQueries, GLCommand::BeginQuery);
+                return false;
+            }
+            case GLCommand::DeleteRenderbuffers: {
+                DeleteNames(m_Renderbuffers, glDeleteRenderbuffers, GLCommand::BindRenderbuffer);
+                return false;
+            }
+            case GLCommand::DeleteSync: {
+                const auto mapped = m_Syncs.find(reader.Read<UInt64>());
+                if (mapped != m_Syncs.end()) {
+                    glDeleteSync(mapped->second);
+                    m_Syncs.erase(mapped);
+                }
+                return false;
+            }
+            case GLCommand::DeleteTextures: {
+                DeleteNames(m_Textures, glDeleteTextures, GLCommand::BindTexture);
+                return false;
+            }
+            case GLCommand::DeleteVertexArrays: {
+                DeleteNames(m_VertexArrays, glDeleteVertexArrays, GLCommand::BindVertexArray);
+                return false;
+            }
+            case GLCommand::DepthMask: {
+                const auto flag = reader.Read<GLboolean>();
+                const bool redundant = SetState(command, 0, flag ? GL_TRUE : GL_FALSE);
+                glDepthMask(flag);
+                return redundant;
+            }
+            case GLCommand::Disable:
+            case GLCommand::Enable: {
+                const auto cap = reader.Read<GLenum>();
+                const bool redundant = SetState(GLCommand::Enable, cap, command == GLCommand::Enable ? 1 : 0);
+                if (command == GLCommand::Enable) {
+                    glEnable(cap);
+                } else {
+                    glDisable(cap);
+                }
+                return redundant;
+            }
+            case GLCommand::DrawArrays: {
+                const auto mode = reader.Read<GLenum>();
+                const auto first = reader.Read<GLint>();
+                const auto count = reader.Read<GLsizei>();
+                glDrawArrays(mode, first, count);
+                return false;
+            }
+            case GLCommand::DrawBuffer: {
+                const auto buffer = reader.Read<GLenum>();
+                const bool redundant = SetState(command, m_DrawFramebuffer, buffer);
+                glDrawBuffer(RemapColorBuffer(buffer, m_DrawFramebuffer));
+                return redundant;
+            }
+            case GLCommand::DrawElements: {
+                const auto mode = reader.Read<GLenum>();
+                const auto count = reader.Read<GLsizei>();
+                const auto type = reader.Read<GLenum>();
+                const auto indices = reader.Read<const void*>();
+                glDrawElements(mode, count, type, indices);
+                return false;
+            }
+            case GLCommand::EnableVertexAttribArray: {
+                const auto index = reader.Read<GLuint>();
+                const bool redundant = SetState(command, Pack(index, m_VertexArray), 1);
+                glEnableVertexAttribArray(index);
+                return redundant;
+            }
+            case GLCommand::EndConditionalRender: {
+                glEndConditionalRender();
+                return false;
+            }
+            case GLCommand::EndQuery: {
+                glEndQuery(reader.Read<GLenum>());
+                return false;
+            }
+            case GLCommand::FenceSync: {
+                const auto condition = reader.Read<GLenum>();
+                const auto flags = reader.Read<GLbitfield>();
+                m_Syncs[reader.Read<UInt64>()] = glFenceSync(condition, flags);
+                return false;
+            }
+            case GLCommand::Finish: {
+                glFinish();
+                return false;
+            }
+            case GLCommand::FramebufferRenderbuffer: {
+                const auto target = reader.Read<GLenum>();
+                const auto attachment = reader.Read<GLenum>();
+                const auto renderbufferTarget = reader.Read<GLenum>();
+                const auto renderbuffer = reader.Read<GLuint>();
+                glFramebufferRenderbuffer(target, attachment, renderbufferTarget, Remap(m_Renderbuffers, renderbuffer));
+                return false;
+            }
+            case GLCommand::FramebufferTexture2D: {
+                const auto target = reader.Read<GLenum>();
+                const auto attachment = reader.Read<GLenum>();
+                const auto textureTarget = reader.Read<GLenum>();
+                const auto texture = reader.Read<GLuint>();
+                const auto level = reader.Read<GLint>();
+                glFramebufferTexture2D(target, attachment, textureTarget, Remap(m_Textures, texture), level);
+                return false;
+            }
+            case GLCommand::FramebufferTextureLayer: {
+                const auto target = reader.Read<GLenum>();
+                const auto attachment = reader.Read<GLenum>();
+                const auto texture = reader.Read<GLuint>();
+                const auto level = reader.Read<GLint>();
+                const auto layer = reader.Read<GLint>();
+                glFramebufferTextureLayer(target, attachment, Remap(m_Textures, texture), level, layer);
+                return false;
+            }
+            case GLCommand::GenBuffers: {
+                GenNames(m_Buffers, glGenBuffers);
+                return false;
+            }
+            case GLCommand::GenFramebuffers: {
+                GenNames(m_Framebuffers, glGenFramebuffers);
+                return false;
+            }
+            case GLCommand::GenQueries: {
+                GenNames(m_Queries, glGenQueries);
+                return false;
+            }
+            case GLCommand::GenRenderbuffers: {
+                GenNames(m_Renderbuffers, glGenRenderbuffers);
+                return false;
+            }
+            case GLCommand::GenTextures: {
+                GenNames(m_Textures, glGenTextures);
+                return false;
+            }
+            case GLCommand::GenVertexArrays: {
+                GenNames(m_VertexArrays, glGenVertexArrays);
+                return false;
+            }
+            case GLCommand::GenerateMipmap: {
+                glGenerateMipmap(reader.Read<GLenum>());
+                return false;
+            }
+            case GLCommand::GetUniformBlockIndex:
+            case GLCommand::GetUniformLocation: {
+                const auto program = reader.Read<GLuint>();
+                const std::span<const UInt8> data = reader.ReadData();
+                const std::string name(reinterpret_cast<const char*>(data.data()), data.size());
+
+                if (command == GLCommand::GetUniformLocation) {
+                    const auto recorded = reader.Read<GLint>();
+                    const GLint location = glGetUniformLocation(Remap(m_Programs, program), name.c_str());
+                    if (recorded >= 0) {
+                        m_UniformLocations[Pack(static_cast<UInt32>(recorded), program)] = location;
+                    }
+                } else {
+                    const auto recorded = reader.Read<GLuint>();
+                    m_UniformBlocks[Pack(recorded, program)] =
+                        glGetUniformBlockIndex(Remap(m_Programs, program), name.c_str());
+                }
+                return false;
+            }
+            case GLCommand::LinkProgram: {
+                const auto program = reader.Read<GLuint>();
+                // Linking resets the uniforms and the block bindings.
+                ForgetObject(GLCommand::UseProgram, program);
+                glLinkProgram(Remap(m_Programs, program));
+                return false;
+            }
+            case GLCommand::MapBufferRange: {
+                const auto target = reader.Read<GLenum>();
+                const auto offset = reader.Read<GLintptr>();
+                const auto length = reader.Read<GLsizeiptr>();
+                const auto access = reader.Read<GLbitfield>();
+                OGLTEST_UNUSED(reader.Read<UInt64>());
+                m_Mappings[target] = static_cast<UInt8*>(glMapBufferRange(target, offset, length, access));
+                return false;
+            }
+            case GLCommand::PixelStorei: {
+                const auto pname = reader.Read<GLenum>();
+                const auto param = reader.Read<GLint>();
+                const bool redundant = SetState(command, pname, static_cast<UInt32>(param));
+                glPixelStorei(pname, param);
+                return redundant;
+            }
+            case GLCommand::PolygonOffset: {
+                const auto factor = reader.Read<GLfloat>();
+                const auto units = reader.Read<GLfloat>();
+                const bool redundant = SetState(command, 0, Pack(std::bit_cast<UInt32>(factor),
+                                                                 std::bit_cast<UInt32>(units)));
+                glPolygonOffset(factor, units);
+                return redundant;
+            }
+            case GLCommand::ReadBuffer: {
+                const auto buffer = reader.Read<GLenum>();
+                const bool redundant = SetState(command, m_ReadFramebuffer, buffer);
+                glReadBuffer(RemapColorBuffer(buffer, m_ReadFramebuffer));
+                return redundant;
+            }
+            case GLCommand::RenderbufferStorage: {
+                const auto target = reader.Read<GLenum>();
+                const auto internalFormat = reader.Read<GLenum>();
+                const auto width = reader.Read<GLsizei>();
+                const auto height = reader.Read<GLsizei>();
+                glRenderbufferStorage(target, internalFormat, width, height);
+                return false;
+            }
+            case GLCommand::ShaderSource: {
+                const auto shader = reader.Read<GLuint>();
+                const std::span<const UInt8> source = reader.ReadData();
+                const auto* string = reinterpret_cast<const GLchar*>(source.data());
+                const auto length = static_cast<GLint>(source.size());
+                glShaderSource(Remap(m_Programs, shader), 1, &string, &length);
+                return false;
+            }
+            case GLCommand::TexImage2D:
+            case GLCommand::TexImage3D: {
+                const auto target = reader.Read<GLenum>();
+                const auto level = reader.Read<GLint>();
+                const auto internalFormat = reader.Read<GLint>();
+                const auto width = reader.Read<GLsizei>();
+                const auto height = reader.Read<GLsizei>();
+                const auto depth = command == GLCommand::TexImage3D ? reader.Read<GLsizei>() : 1;
+                const auto border = reader.Read<GLint>();
+                const auto format = reader.Read<GLenum>();
+                const auto type = reader.Read<GLenum>();
+                UInt64 size = 0;
+                const void* pixels = ReadImage(size);
+                frame.Calls.UploadedBytes += size;
+
+                if (command == GLCommand::TexImage3D) {
+                    glTexImage3D(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+                } else {
+                    glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+                }
+                return false;
+            }
+            case GLCommand::TexParameterfv: {
+                const auto target = reader.Read<GLenum>();
+                const auto pname = reader.Read<GLenum>();
+                glTexParameterfv(target, pname, ReadFloats());
+                return false;
+            }
+            case GLCommand::TexParameteri: {
+                const auto target = reader.Read<GLenum>();
+                const auto pname = reader.Read<GLenum>();
+                const auto param = reader.Read<GLint>();
+                const UInt64 texture = GetBoundTexture(target);
+                const bool redundant = SetState(command, Pack(pname, static_cast<UInt32>(texture)),
+                                                static_cast<UInt32>(param));
+                glTexParameteri(target, pname, param);
+                return redundant;
+            }
+            case GLCommand::TexSubImage2D:
+            case GLCommand::TexSubImage3D: {
+                const auto target = reader.Read<GLenum>();
+                const auto level = reader.Read<GLint>();
+                const auto xOffset = reader.Read<GLint>();
+                const auto yOffset = reader.Read<GLint>();
+                const auto zOffset = command == GLCommand::TexSubImage3D ? reader.Read<GLint>() : 0;
+                const auto width = reader.Read<GLsizei>();
+                const auto height = reader.Read<GLsizei>();
+                const auto depth = command == GLCommand::TexSubImage3D ? reader.Read<GLsizei>() : 1;
+                const auto format = reader.Read<GLenum>();
+                const auto type = reader.Read<GLenum>();
+                UInt64 size = 0;
+                const void* pixels = ReadImage(size);
+                frame.Calls.UploadedBytes += size;
+
+                if (command == GLCommand::TexSubImage3D) {
+                    glTexSubImage3D(target, level, xOffset, yOffset, zOffset, width, height, depth, format, type,
+                                    pixels);
+                } else {
+                    glTexSubImage2D(target, level, xOffset, yOffset, width, height, format, type, pixels);
+                }
+                return false;
+            }
+            case GLCommand::Uniform1f:
+            case GLCommand::Uniform2f:
+            case GLCommand::Uniform3f:
+            case GLCommand::Uniform4f: {
+                const auto location = reader.Read<GLint>();
+                const UInt32 components = command == GLCommand::Uniform1f   ? 1
+                                          : command == GLCommand::Uniform2f ? 2
+                                          : command == GLCommand::Uniform3f ? 3
+                                                                            : 4;
+                std::array<GLfloat, 4> value{};
+                for (UInt32 i = 0; i < components; i++) {
+                    value[i] = reader.Read<GLfloat>();
+                }
+
+                const bool redundant = SetUniform(location, value.data(), components * sizeof(GLfloat));
+                const GLint mapped = RemapLocation(location);
+                switch (components) {
+                    case 1: {
+                        glUniform1f(mapped, value[0]);
+                        break;
+                    }
+                    case 2: {
+                        glUniform2f(mapped, value[0], value[1]);
+                        break;
+                    }
+                    case 3: {
+                        glUniform3f(mapped, value[0], value[1], value[2]);
+                        break;
+                    }
+                    default: {
+                        glUniform4f(mapped, value[0], value[1], value[2], value[3]);
+                        break;
+                    }
+                }
+                return redundant;
+            }
+            case GLCommand::Uniform1i: {
+                const auto location = reader.Read<GLint>();
+                const auto value = reader.Read<GLint>();
+                const bool redundant = SetUniform(location, &value, sizeof(value));
+                glUniform1i(RemapLocation(location), value);
+                return redundant;
+            }
+            case GLCommand::Uniform2fv:
+            case GLCommand::Uniform3fv:
+            case GLCommand::Uniform4fv:
+            case GLCommand::UniformMatrix2fv:
+            case GLCommand::UniformMatrix3fv:
+            case GLCommand::UniformMatrix4fv: {
+                const auto location = reader.Read<GLint>();
+                const auto count = reader.Read<GLsizei>();
+                const bool matrix = command == GLCommand::UniformMatrix2fv ||
+                                    command == GLCommand::UniformMatrix3fv || command == GLCommand::UniformMatrix4fv;
+                const GLboolean transpose = matrix ? reader.Read<GLboolean>() : GL_FALSE;
+                const GLfloat* value = ReadFloats();
+
+                const bool redundant = SetUniform(location, value, value ? m_Floats.size() * sizeof(GLfloat) : 0);
+                const GLint mapped = RemapLocation(location);
+                switch (command) {
+                    case GLCommand::Uniform2fv: {
+                        glUniform2fv(mapped, count, value);
+                        break;
+                    }
+                    case GLCommand::Uniform3fv: {
+                        glUniform3fv(mapped, count, value);
+                        break;
+                    }
+                    case GLCommand::Uniform4fv: {
+                        glUniform4fv(mapped, count, value);
+                        break;
+                    }
+                    case GLCommand::UniformMatrix2fv: {
+                        glUniformMatrix2fv(mapped, count, transpose, value);
+                        break;
+                    }
+                    case GLCommand::UniformMatrix3fv: {
+                        glUniformMatrix3fv(mapped, count, transpose, value);
+                        break;
+                    }
+                    default: {
+                        glUniformMatrix4fv(mapped, count, transpose, value);
+                        break;
+                    }
+                }
+                return redundant;
+            }
+            case GLCommand::UniformBlockBinding: {
+                const auto program = reader.Read<GLuint>();
+                const auto index = reader.Read<GLuint>();
+                const auto binding = reader.Read<GLuint>();
+                const bool redundant = SetState(command, Pack(index, program), binding);
+
+                const auto mapped = m_UniformBlocks.find(Pack(index, program));
+                glUniformBlockBinding(Remap(m_Programs, program), mapped != m_UniformBlocks.end() ? mapped->second : index,
+                                      binding);
+                return redundant;
+            }
+            case GLCommand::UnmapBuffer: {
+                const auto target = reader.Read<GLenum>();
+                const std::span<const UInt8> data = reader.ReadData();
+                OGLTEST_UNUSED(reader.Read<GLboolean>());
+                frame.Calls.UploadedBytes += data.size();
+
+                const auto mapping = m_Mappings.find(target);
+                if (mapping != m_Mappings.end()) {
+                    if (mapping->second && data.data()) {
+                        std::memcpy(mapping->second, data.data(), data.size());
+                    }
+                    m_Mappings.erase(mapping);
+                }
+                glUnmapBuffer(target);
+                return false;
+            }
+            case GLCommand::UseProgram: {
+                const auto program = reader.Read<GLuint>();
+                m_Program = program;
+                const bool redundant = SetState(command, 0, program);
+                glUseProgram(Remap(m_Programs, program));
+                return redundant;
+            }
+            case GLCommand::VertexAttribPointer: {
+                const auto index = reader.Read<GLuint>();
+                const auto size = reader.Read<GLint>();
+                const auto type = reader.Read<GLenum>();
+                const auto normalized = reader.Read<GLboolean>();
+                const auto stride = reader.Read<GLsizei>();
+                const auto pointer = reader.Read<const void*>();
+                glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+                return false;
+            }
+            case GLCommand::Viewport: {
+                const auto x = reader.Read<GLint>();
+                const auto y = reader.Read<GLint>();
+                const auto width = reader.Read<GLsizei>();
+                const auto height = reader.Read<GLsizei>();
+                const bool sameOrigin = SetState(command, 0, Pack(static_cast<UInt32>(x), static_cast<UInt32>(y)));
+                const bool sameSize = SetState(command, 1, Pack(static_cast<UInt32>(width),
+                                                                static_cast<UInt32>(height)));
+                glViewport(x, y, width, height);
+                return sameOrigin && sameSize;
+            }
+            default: {
+                return false;
+            }
+        }
+    }
+}
@@ -0,0 +1,227 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/pch.hpp>
+
+#include <GLReplay/GLReplayer.hpp>
+
+#include <glad/glad.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <numeric>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A context without a window or a display server, e.g. on llvmpipe with GALLIUM_DRIVER=llvmpipe.
+struct HeadlessContext {
+    EGLDisplay Display = EGL_NO_DISPLAY;
+    EGLContext Context = EGL_NO_CONTEXT;
+    EGLSurface Surface = EGL_NO_SURFACE;
+};
+
+bool CreateHeadlessContext(HeadlessContext& headless);
+void DestroyHeadlessContext(HeadlessContext& headless);
+void PrintReport(const OGLTest::GLReplayer& replayer, OGLTest::UInt32 topCount);
+
+int main(int argc, char** argv) {
+    // GLReplay <capture> [options]
+    // --sync-draws: waits for each draw to finish, so its time includes the rasterization.
+    // --time-loading: also includes the calls of the loading in the per-command timings.
+    // --top <count>: number of commands listed by total time, 20 by default.
+    constexpr std::string_view usage = "Usage: GLReplay <capture> [--sync-draws] [--time-loading] [--top <count>]\n"
+                                       "Runs without a window, set GALLIUM_DRIVER=llvmpipe to replay on the CPU.";
+    if (argc < 2) {
+        std::cerr << usage << '\n';
+        return -1;
+    }
+
+    OGLTest::ReplaySettings settings;
+    OGLTest::UInt32 topCount = 20;
+    for (int i = 2; i < argc; i++) {
+        const std::string_view argument = argv[i];
+
+        if (argument == "--sync-draws") {
+            settings.SyncDraws = true;
+        } else if (argument == "--time-loading") {
+            settings.TimeLoading = true;
+        } else if (argument == "--top" && i + 1 < argc) {
+            topCount = static_cast<OGLTest::UInt32>(std::max(std::atoi(argv[++i]), 0));
+        } else {
+            std::cerr << "Unknown argument: " << argument << '\n' << usage << '\n';
+            return -1;
+        }
+    }
+
+    HeadlessContext headless;
+    if (!CreateHeadlessContext(headless)) {
+        DestroyHeadlessContext(headless);
+        return -2;
+    }
+
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress))) {
+        std::cerr << "Failed to load OpenGL loader." << '\n';
+        DestroyHeadlessContext(headless);
+        return -3;
+    }
+
+    std::cout << "Replaying on " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")" << '\n';
+
+    int result = 0;
+    {
+        OGLTest::GLReplayer replayer{settings};
+        if (!replayer.Open(argv[1])) {
+            result = -4;
+        } else {
+            if (!replayer.Replay()) {
+                std::cerr << "The capture is truncated, reporting the frames replayed until then." << '\n';
+                result = -5;
+            }
+            PrintReport(replayer, topCount);
+        }
+    }
+
+    DestroyHeadlessContext(headless);
+
+    return result;
+}
+
+bool CreateHeadlessContext(HeadlessContext& headless) {
+    // Surfaceless doesn't need a display server, the default display is the fallback for the other drivers.
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions && std::string_view{extensions}.find("EGL_MESA_platform_surfaceless") != std::string_view::npos) {
+        const auto getPlatformDisplay =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay) {
+            headless.Display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+    }
+    if (headless.Display == EGL_NO_DISPLAY) {
+        headless.Display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    if (headless.Display == EGL_NO_DISPLAY || !eglInitialize(headless.Display, nullptr, nullptr)) {
+        std::cerr << "Failed to initialize EGL." << '\n';
+        headless.Display = EGL_NO_DISPLAY;
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL doesn't support desktop OpenGL." << '\n';
+        return false;
+    }
+
+    constexpr EGLint configAttributes[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(headless.Display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        std::cerr << "No EGL config supports OpenGL." << '\n';
+        return false;
+    }
+
+    constexpr EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    headless.Context = eglCreateContext(headless.Display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (headless.Context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create an OpenGL 3.3 core context." << '\n';
+        return false;
+    }
+
+    // The replay renders to its own framebuffer, a surface is only needed without EGL_KHR_surfaceless_context.
+    if (eglMakeCurrent(headless.Display, EGL_NO_SURFACE, EGL_NO_SURFACE, headless.Context)) {
+        return true;
+    }
+
+    constexpr EGLint surfaceAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    headless.Surface = eglCreatePbufferSurface(headless.Display, config, surfaceAttributes);
+    if (headless.Surface == EGL_NO_SURFACE ||
+        !eglMakeCurrent(headless.Display, headless.Surface, headless.Surface, headless.Context)) {
+        std::cerr << "Failed to make the OpenGL context current." << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+void DestroyHeadlessContext(HeadlessContext& headless) {
+    if (headless.Display == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    eglMakeCurrent(headless.Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (headless.Surface != EGL_NO_SURFACE) {
+        eglDestroySurface(headless.Display, headless.Surface);
+    }
+    if (headless.Context != EGL_NO_CONTEXT) {
+        eglDestroyContext(headless.Display, headless.Context);
+    }
+    eglTerminate(headless.Display);
+
+    headless = HeadlessContext{};
+}
+
+void PrintReport(const OGLTest::GLReplayer& replayer, const OGLTest::UInt32 topCount) {
+    const OGLTest::CaptureFileHeader& header = replayer.GetHeader();
+    const std::span<const OGLTest::ReplayFrameStats> frames = replayer.GetFrames();
+    std::cout << "Capture: " << header.Width << "x" << header.Height << ", " << frames.size() - 1
+              << " frame(s) after the loading" << '\n' << '\n';
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::left << std::setw(10) << "Frame" << std::right << std::setw(10) << "Calls" << std::setw(10)
+              << "Draws" << std::setw(10) << "Binds" << std::setw(14) << "Uploaded KiB" << std::setw(12)
+              << "Redundant" << std::setw(12) << "Call ms" << std::setw(12) << "Frame ms" << '\n';
+    for (OGLTest::UInt64 i = 0; i < frames.size(); i++) {
+        const OGLTest::ReplayFrameStats& frame = frames[i];
+        std::cout << std::left << std::setw(10) << (i == 0 ? std::string("loading") : std::to_string(i)) << std::right
+                  << std::setw(10) << frame.Calls.Calls << std::setw(10) << frame.Calls.DrawCalls << std::setw(10)
+                  << frame.Calls.Binds << std::setw(14) << (frame.Calls.UploadedBytes >> 10) << std::setw(12)
+                  << frame.RedundantCalls << std::setw(12) << frame.CallMs << std::setw(12) << frame.FrameMs << '\n';
+    }
+
+    // The commands sorted by the time spent in them.
+    const std::span<const OGLTest::CommandTiming> timings = replayer.GetCommandTimings();
+    std::vector<OGLTest::UInt64> order(timings.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](const OGLTest::UInt64 a, const OGLTest::UInt64 b) {
+        return timings[a].TotalMs > timings[b].TotalMs;
+    });
+
+    std::cout << '\n' << std::left << std::setw(28) << "Command" << std::right << std::setw(10) << "Count"
+              << std::setw(12) << "Redundant" << std::setw(12) << "Total ms" << std::setw(12) << "Avg us"
+              << std::setw(12) << "Max us" << '\n';
+    for (OGLTest::UInt64 i = 0; i < std::min<OGLTest::UInt64>(topCount, order.size()); i++) {
+        const OGLTest::CommandTiming& timing = timings[order[i]];
+        if (timing.Count == 0) {
+            break;
+        }
+
+        const std::string_view name = OGLTest::GetCommandName(static_cast<OGLTest::GLCommand>(order[i]));
+        std::cout << std::left << std::setw(28) << name << std::right << std::setw(10) << timing.Count << std::setw(12)
+                  << timing.Redundant << std::setw(12) << timing.TotalMs << std::setw(12)
+                  << timing.TotalMs * 1000.0 / static_cast<OGLTest::Float64>(timing.Count) << std::setw(12)
+                  << timing.MaxMs * 1000.0 << '\n';
+    }
+
+    if (replayer.GetUnknownNames() > 0) {
+        std::cout << '\n' << replayer.GetUnknownNames()
+                  << " call(s) used objects the capture didn't create, the replay may not match the application."
+                  << '\n';
+    }
+}
@@ -0,0 +1,629 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/Benchmarks.hpp>
+
+#include <OpenGLTest/Bvh.hpp>
+#include <OpenGLTest/ChunkFile.hpp>
+#include <OpenGLTest/Model.hpp>
+#include <OpenGLTest/StreamBuffer.hpp>
+#include <OpenGLTest/StreamingManager.hpp>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace OGLTest {
+    namespace {
+        void BenchmarkTriangleBvh(const char* name, const std::span<const glm::vec3> positions,
+                                  const std::span<const UInt32> indices, JobSystem& jobs) {
+            constexpr UInt32 buildCount = 5;
+            constexpr UInt32 rayCount = 1 << 18;
+
+            const UInt64 triangleCount = indices.size() / 3;
+            std::vector<BoundingBox> triangleBounds(triangleCount);
+            for (UInt64 i = 0; i < triangleCount; i++) {
+                triangleBounds[i].Extend(positions[indices[i * 3]]);
+                triangleBounds[i].Extend(positions[indices[i * 3 + 1]]);
+                triangleBounds[i].Extend(positions[indices[i * 3 + 2]]);
+            }
+
+            Bvh bvh;
+            Float64 bestBuildMs = 0.0;
+            for (UInt32 repeat = 0; repeat < buildCount; repeat++) {
+                const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                bvh.Build(triangleBounds);
+                const Float64 ms =
+                    std::chrono::duration<Float64, std::milli>(std::chrono::steady_clock::now() - start).count();
+                bestBuildMs = repeat == 0 ? ms : std::min(bestBuildMs, ms);
+            }
+
+            // From a sphere around the mesh towards random points of its bounds, the same rays on every run.
+            const BoundingBox& bounds = bvh.GetBounds();
+            const glm::vec3 center = bounds.GetCenter();
+            const Float32 radius = glm::length(bounds.GetExtent());
+            std::mt19937 random{1234};
+            std::uniform_real_distribution<Float32> uniform{0.0f, 1.0f};
+            std::normal_distribution<Float32> normal;
+            const auto randomVector = [&random](auto& distribution) {
+                glm::vec3 vector;
+                vector.x = distribution(random);
+                vector.y = distribution(random);
+                vector.z = distribution(random);
+                return vector;
+            };
+
+            std::vector<Ray> rays(rayCount);
+            for (Ray& ray : rays) {
+                const glm::vec3 origin = center + glm::normalize(randomVector(normal)) * radius;
+                const glm::vec3 target = bounds.Min + bounds.GetExtent() * randomVector(uniform);
+                ray = Ray{origin, glm::normalize(target - origin)};
+            }
+
+            const auto castRays = [&](const UInt64 first, const UInt64 last) {
+                UInt32 hits = 0;
+                for (UInt64 i = first; i < last; i++) {
+                    const Ray& ray = rays[i];
+                    const Float32 distance = bvh.Raycast(ray, [&](const UInt32 triangle,
+                                                                           const Float32 closest) {
+                        OGLTEST_UNUSED(closest);
+
+                        return IntersectRayTriangle(ray, positions[indices[triangle * 3]],
+                                                             positions[indices[triangle * 3 + 1]],
+                                                             positions[indices[triangle * 3 + 2]]);
+                    });
+                    hits += distance != g_Infinity ? 1 : 0;
+                }
+                return hits;
+            };
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            const UInt32 hits = castRays(0, rayCount);
+            const Float64 serialSeconds =
+                std::chrono::duration<Float64>(std::chrono::steady_clock::now() - start).count();
+
+            std::atomic<UInt32> parallelHits = 0;
+            start = std::chrono::steady_clock::now();
+            jobs.ParallelFor(0, rayCount, 1024, [&](const UInt64 first, const UInt64 last) {
+                parallelHits += castRays(first, last);
+            });
+            const Float64 parallelSeconds =
+                std::chrono::duration<Float64>(std::chrono::steady_clock::now() - start).count();
+
+            std::cout << name << ": " << triangleCount << " triangles, " << bvh.GetNodes().size() << " nodes, "
+                      << (bvh.GetMemoryUsage() >> 10) << " KiB, build " << bestBuildMs << " ms (best of " << buildCount
+                      << ")" << '\n';
+            std::cout << "  " << rayCount << " rays, " << 100.0 * hits / rayCount << "% hit: "
+                      << rayCount / serialSeconds / 1.0e6 << " Mrays/s on one thread, "
+                      << rayCount / parallelSeconds / 1.0e6 << " Mrays/s with " << jobs.GetWorkerCount() << " workers"
+                      << (parallelHits == hits ? "" : " (the hits don't match)") << '\n';
+        }
+    }
+
+    void BenchmarkStreamBuffers() {
+        // Small uniform-sized writes, the typical per-object dynamic data.
+        constexpr UInt32 frameCount = 500;
+        constexpr UInt64 allocationSize = 256;
+        constexpr UInt64 allocationsPerFrame = 4096;
+        constexpr UInt64 frameSize = allocationSize * allocationsPerFrame;
+
+        const std::vector<UInt8> payload(allocationSize, 0x5A);
+
+        const auto report = [&](const char* name, const std::chrono::steady_clock::time_point start) {
+            glFinish();
+            const Float64 seconds =
+                std::chrono::duration<Float64>(std::chrono::steady_clock::now() - start).count();
+            const Float64 mebibytes = static_cast<Float64>(frameSize * frameCount) / (1024.0 * 1024.0);
+
+            std::cout << name << ": " << mebibytes / seconds << " MiB/s, " << seconds * 1000.0 / frameCount
+                      << " ms per frame" << '\n';
+        };
+
+        // Baseline, orphaning the whole buffer every frame and uploading each block separately.
+        {
+            GLuint buffer;
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (UInt32 frame = 0; frame < frameCount; frame++) {
+                glBufferData(GL_UNIFORM_BUFFER, frameSize, nullptr, GL_STREAM_DRAW);
+                for (UInt64 i = 0; i < allocationsPerFrame; i++) {
+                    glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(i * allocationSize), allocationSize,
+                                    payload.data());
+                }
+            }
+            report("glBufferData + glBufferSubData", start);
+
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            glDeleteBuffers(1, &buffer);
+        }
+
+        for (const bool persistent : {false, true}) {
+            StreamBuffer streamBuffer{GL_UNIFORM_BUFFER, frameSize, persistent};
+            if (persistent && !streamBuffer.IsPersistent()) {
+                std::cout << "Persistent mapping isn't available (GL " << GLVersion.major << "." << GLVersion.minor
+                          << ")" << '\n';
+                continue;
+            }
+
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (UInt32 frame = 0; frame < frameCount; frame++) {
+                streamBuffer.BeginFrame();
+                for (UInt64 i = 0; i < allocationsPerFrame; i++) {
+                    const StreamAllocation allocation = streamBuffer.Allocate(allocationSize);
+                    std::memcpy(allocation.Data, payload.data(), allocationSize);
+                }
+                streamBuffer.EndFrame();
+            }
+            report(persistent ? "StreamBuffer (persistent mapping)" : "StreamBuffer (staging + glBufferSubData)",
+                   start);
+
+            const StreamBufferStats& stats = streamBuffer.GetStats();
+            std::cout << "  fence waits: " << stats.FenceWaits << ", " << stats.FenceWaitMs << " ms" << '\n';
+        }
+    }
+
+    bool BenchmarkJobs() {
+        // A fine grained loop for the stealing and a burst of tiny jobs for the scheduling overhead.
+        constexpr UInt64 itemCount = 1ull << 24;
+        constexpr UInt32 tinyJobCount = 1u << 16;
+        constexpr UInt32 repeatCount = 10;
+
+        const auto work = [](const UInt64 i) {
+            return std::sin(static_cast<Float64>(i) * 0.001) * std::cos(static_cast<Float64>(i) * 0.002);
+        };
+
+        Float64 expected = 0.0;
+        for (UInt64 i = 0; i < itemCount; i++) {
+            expected += work(i);
+        }
+
+        std::vector<UInt32> workerCounts{0};
+        for (UInt32 count = 1; count < JobSystem::GetDefaultWorkerCount(); count *= 2) {
+            workerCounts.push_back(count);
+        }
+        if (JobSystem::GetDefaultWorkerCount() > 0) {
+            workerCounts.push_back(JobSystem::GetDefaultWorkerCount());
+        }
+
+        bool passed = true;
+        Float64 baselineMs = 0.0;
+        for (const UInt32 workerCount : workerCounts) {
+            JobSystem jobs{workerCount};
+
+            // One partial sum per batch, summed in order so the result doesn't depend on the scheduling.
+            constexpr UInt64 batchSize = 4096;
+            std::vector<Float64> partials(itemCount / batchSize);
+
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (UInt32 repeat = 0; repeat < repeatCount; repeat++) {
+                jobs.ParallelFor(0, partials.size(), 1, [&](const UInt64 first, const UInt64 last) {
+                    for (UInt64 batch = first; batch < last; batch++) {
+                        Float64 sum = 0.0;
+                        for (UInt64 i = batch * batchSize; i < (batch + 1) * batchSize; i++) {
+                            sum += work(i);
+                        }
+                        partials[batch] = sum;
+                    }
+                });
+            }
+            const Float64 loopMs =
+                std::chrono::duration<Float64, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                repeatCount;
+
+            Float64 total = 0.0;
+            for (const Float64 partial : partials) {
+                total += partial;
+            }
+
+            // Every job increments the same counter, a lost or repeated job shows up in the count.
+            std::atomic<UInt32> executed = 0;
+            const std::chrono::steady_clock::time_point tinyStart = std::chrono::steady_clock::now();
+            JobCounter counter;
+            for (UInt32 i = 0; i < tinyJobCount; i++) {
+                jobs.Schedule([&executed]() {
+                    executed.fetch_add(1, std::memory_order_relaxed);
+                }, &counter);
+            }
+            jobs.Wait(counter);
+            const Float64 tinyUs =
+                std::chrono::duration<Float64, std::micro>(std::chrono::steady_clock::now() - tinyStart).count();
+
+            if (workerCount == 0) {
+                baselineMs = loopMs;
+            }
+
+            const JobStats stats = jobs.GetStats();
+            std::cout << workerCount + 1 << " threads: parallel for " << loopMs << " ms (x" << baselineMs / loopMs
+                      << "), " << tinyUs * 1000.0 / tinyJobCount << " ns per tiny job, " << stats.Stolen << " stolen"
+                      << '\n';
+
+            if (std::abs(total - expected) > 1e-6 * std::max(1.0, std::abs(expected)) || executed != tinyJobCount) {
+                std::cerr << "Job system results don't match with " << workerCount << " workers." << '\n';
+                passed = false;
+            }
+        }
+
+        return passed;
+    }
+
+    bool TestJobs() {
+        constexpr UInt32 repeatCount = 20;
+
+        bool passed = true;
+        const auto check = [&passed](const bool condition, const char* name, const UInt32 workerCount) {
+            if (!condition) {
+                std::cerr << "Job system test failed with " << workerCount << " workers: " << name << '\n';
+                passed = false;
+            }
+        };
+
+        const std::thread::id mainThread = std::this_thread::get_id();
+        for (const UInt32 workerCount : {0u, 1u, std::max(2u, JobSystem::GetDefaultWorkerCount())}) {
+            JobSystem jobs{workerCount};
+
+            for (UInt32 repeat = 0; repeat < repeatCount; repeat++) {
+                // A chain where each job only starts once the previous one finished.
+                {
+                    constexpr UInt32 chainLength = 256;
+                    const auto counters = std::make_unique<JobCounter[]>(chainLength);
+                    std::atomic<UInt32> next = 0;
+                    std::atomic<bool> ordered = true;
+
+                    for (UInt32 i = 0; i < chainLength; i++) {
+                        jobs.Schedule([&next, &ordered, i]() {
+                            if (next.fetch_add(1) != i) {
+                                ordered = false;
+                            }
+                        }, &counters[i], i > 0 ? &counters[i - 1] : nullptr);
+                    }
+                    jobs.Wait(counters[chainLength - 1]);
+
+                    check(ordered && next == chainLength, "dependency chain", workerCount);
+                }
+
+                // A continuation depending on many jobs sees all of them done.
+                {
+                    constexpr UInt32 producerCount = 64;
+                    JobCounter producers, consumer;
+                    std::atomic<UInt32> produced = 0;
+                    UInt32 seen = 0;
+
+                    for (UInt32 i = 0; i < producerCount; i++) {
+                        jobs.Schedule([&produced]() {
+                            produced.fetch_add(1);
+                        }, &producers);
+                    }
+                    jobs.Schedule([&]() {
+                        seen = produced.load();
+                    }, &consumer, &producers);
+                    jobs.Wait(consumer);
+
+                    check(seen == producerCount, "fan-in dependency", workerCount);
+                }
+
+                // Jobs scheduled from workers with the main thread affinity only run on the main thread.
+                {
+                    constexpr UInt32 jobCount = 16;
+                    JobCounter spawners, mainThreadJobs;
+                    std::atomic<UInt32> ran = 0, wrongThread = 0;
+
+                    for (UInt32 i = 0; i < jobCount; i++) {
+                        jobs.Schedule([&]() {
+                            jobs.Schedule([&]() {
+                                ran.fetch_add(1);
+                                if (std::this_thread::get_id() != mainThread) {
+                                    wrongThread.fetch_add(1);
+                                }
+                            }, &mainThreadJobs, nullptr, JobAffinity::MainThread);
+                        }, &spawners);
+                    }
+                    jobs.Wait(spawners);
+                    jobs.Wait(mainThreadJobs);
+
+                    check(ran == jobCount && wrongThread == 0, "main thread affinity", workerCount);
+                }
+
+                // Nested loops from the main thread and a loop from a thread outside the system, at the same time:
+                // every item must run exactly once.
+                {
+                    constexpr UInt64 itemCount = 1ull << 16;
+                    const auto hits = std::make_unique<std::atomic<UInt32>[]>(itemCount);
+                    const auto visit = [&hits](const UInt64 first, const UInt64 last) {
+                        for (UInt64 i = first; i < last; i++) {
+                            hits[i].fetch_add(1, std::memory_order_relaxed);
+                        }
+                    };
+
+                    std::thread outside([&]() {
+                        jobs.ParallelFor(0, itemCount / 2, 64, visit);
+                    });
+                    jobs.ParallelFor(itemCount / 2, itemCount, 1024, [&](const UInt64 first,
+                                                                         const UInt64 last) {
+                        jobs.ParallelFor(first, last, 64, visit);
+                    });
+                    outside.join();
+
+                    bool exactlyOnce = true;
+                    for (UInt64 i = 0; i < itemCount; i++) {
+                        exactlyOnce &= hits[i].load() == 1;
+                    }
+                    check(exactlyOnce, "contended parallel loops", workerCount);
+                }
+            }
+
+            // Jobs queued on the main thread are taken by the idle workers.
+            if (workerCount > 0) {
+                constexpr UInt32 jobCount = 64;
+                const UInt64 stolenBefore = jobs.GetStats().Stolen;
+                JobCounter counter;
+                std::atomic<UInt32> offMainThread = 0;
+
+                for (UInt32 i = 0; i < jobCount; i++) {
+                    jobs.Schedule([&]() {
+                        std::this_thread::sleep_for(std::chrono::microseconds(200));
+                        if (std::this_thread::get_id() != mainThread) {
+                            offMainThread.fetch_add(1);
+                        }
+                    }, &counter);
+                }
+                jobs.Wait(counter);
+
+                check(jobs.GetStats().Stolen > stolenBefore && offMainThread > 0, "work stealing", workerCount);
+            }
+        }
+
+        std::cout << (passed ? "Job system tests passed." : "Job system tests failed.") << '\n';
+        return passed;
+    }
+
+    void BenchmarkGltf(const std::string& path, JobSystem& jobs) {
+        constexpr UInt32 repeatCount = 5;
+
+        // Same flip as the scene, the Assimp path relies on it for the images.
+        stbi_set_flip_vertically_on_load(true);
+
+        for (const bool native : {true, false}) {
+            ModelImportSettings settings;
+            settings.UseNativeGltf = native;
+
+            Float64 totalMs = 0.0;
+            Float64 bestMs = 0.0;
+            UInt32 meshCount = 0;
+            MemoryUsage memory;
+            for (UInt32 repeat = 0; repeat < repeatCount; repeat++) {
+                std::optional<Model> model;
+
+                const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                model.emplace(path, jobs, settings);
+                // Includes the uploads, the driver may still be copying the buffers when the loading returns.
+                glFinish();
+                const Float64 ms =
+                    std::chrono::duration<Float64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                meshCount = model->GetMeshCount();
+                memory = model->GetMemoryUsage();
+
+                // Every run starts from the same GPU memory, the destruction isn't part of the loading time.
+                model.reset();
+                glFinish();
+
+                totalMs += ms;
+                bestMs = repeat == 0 ? ms : std::min(bestMs, ms);
+            }
+
+            std::cout << (native ? "Native GLB" : "Assimp") << ": " << totalMs / repeatCount << " ms average, "
+                      << bestMs << " ms best, " << meshCount << " meshes, " << (memory.GpuBytes >> 10) << " KiB GPU, "
+                      << (memory.CpuBytes >> 10) << " KiB CPU" << '\n';
+        }
+    }
+
+    void BenchmarkBvh(const std::string& modelPath, JobSystem& jobs) {
+        // The triangles of every mesh in world space, in a single hierarchy.
+        {
+            const Model model{modelPath, jobs};
+
+            std::vector<glm::vec3> positions;
+            std::vector<UInt32> indices;
+            for (UInt32 meshIndex = 0; meshIndex < model.GetMeshCount(); meshIndex++) {
+                const Mesh& mesh = model.GetMesh(meshIndex);
+                const glm::mat4& transform = model.GetMeshTransform(meshIndex);
+                const auto baseVertex = static_cast<UInt32>(positions.size());
+
+                for (const glm::vec3& position : mesh.GetPositions()) {
+                    positions.push_back(glm::vec3(transform * glm::vec4(position, 1.0f)));
+                }
+
+                for (const UInt32 index : mesh.GetIndices()) {
+                    indices.push_back(baseVertex + index);
+                }
+            }
+
+            if (indices.empty()) {
+                std::cerr << "No triangles to benchmark in: " << modelPath << '\n';
+            } else {
+                BenchmarkTriangleBvh(modelPath.c_str(), positions, indices, jobs);
+            }
+        }
+
+        // A 708x708 quads height field, 1002528 triangles.
+        constexpr UInt32 gridSize = 708;
+        constexpr UInt32 verticesPerSide = gridSize + 1;
+
+        std::vector<glm::vec3> positions;
+        positions.reserve(static_cast<UInt64>(verticesPerSide) * verticesPerSide);
+        for (UInt32 z = 0; z < verticesPerSide; z++) {
+            for (UInt32 x = 0; x < verticesPerSide; x++) {
+                const auto worldX = static_cast<Float32>(x);
+                const auto worldZ = static_cast<Float32>(z);
+                positions.emplace_back(worldX, 8.0f * std::sin(worldX * 0.05f) * std::cos(worldZ * 0.07f), worldZ);
+            }
+        }
+
+        std::vector<UInt32> indices;
+        indices.reserve(static_cast<UInt64>(gridSize) * gridSize * 6);
+        for (UInt32 z = 0; z < gridSize; z++) {
+            for (UInt32 x = 0; x < gridSize; x++) {
+                const UInt32 topLeft = z * verticesPerSide + x;
+                const UInt32 bottomLeft = topLeft + verticesPerSide;
+
+                indices.insert(indices.end(), {topLeft, bottomLeft, topLeft + 1});
+                indices.insert(indices.end(), {topLeft + 1, bottomLeft, bottomLeft + 1});
+            }
+        }
+
+        BenchmarkTriangleBvh("Synthetic height field", positions, indices, jobs);
+    }
+
+    bool TestStreaming(JobSystem& jobs) {
+        // 32x32 chunks of 16x16 quads, about 15 KiB each. The CPU budget only holds a few reads at once and the GPU
+        // budget a bit more than the chunks around the camera, so moving evicts.
+        constexpr UInt32 gridSize = 32;
+        constexpr Float32 chunkSize = 16.0f;
+        constexpr UInt32 maxSettleFrames = 5000;
+
+        StreamingSettings settings;
+        settings.LoadRadius = 48.0f;
+        settings.CpuBudget = 96ull * 1024;
+        settings.GpuBudget = 1024ull * 1024;
+        settings.MaxUploadsPerFrame = 4;
+
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "OpenGLTest_streaming.chunks";
+        if (!WriteSyntheticChunkFile(path, gridSize, 16, chunkSize)) {
+            return false;
+        }
+
+        std::vector<ChunkDesc> chunks;
+        if (!ReadChunkTable(path, chunks)) {
+            return false;
+        }
+        // Every synthetic chunk has the same size, the GPU bytes must be a multiple of it.
+        const UInt64 chunkBytes = chunks.front().GetDataSize();
+
+        bool passed = true;
+        {
+            StreamingManager streaming{jobs, settings};
+            passed = streaming.Open(path);
+
+            UInt64 frame = 0;
+            const auto check = [&](const bool condition, const char* name) {
+                if (!condition && passed) {
+                    std::cerr << "Streaming test failed at frame " << frame << ": " << name << '\n';
+                    passed = false;
+                }
+            };
+
+            const auto update = [&](const glm::vec3& position) {
+                streaming.Update(position);
+                frame++;
+
+                const ResidencyStats& stats = streaming.GetStats();
+                check(stats.TotalChunks == chunks.size(), "chunk count");
+                check(stats.CpuBytes <= settings.CpuBudget, "CPU budget");
+                check(stats.GpuBytes <= settings.GpuBudget, "GPU budget");
+                check(stats.GpuBytes == stats.ResidentChunks * chunkBytes, "GPU bytes of the resident chunks");
+                check(stats.UploadsThisFrame <= settings.MaxUploadsPerFrame, "uploads per frame");
+                check(stats.QueuedChunks + stats.LoadingChunks + stats.ResidentChunks <= stats.TotalChunks,
+                      "chunk states");
+                check(stats.QueuedChunks <= stats.RequestedChunks, "queued chunks not requested");
+            };
+
+            // Across the grid and back over the chunks evicted on the way, stopping where the most chunks are
+            // requested.
+            const Float32 extent = static_cast<Float32>(gridSize) * chunkSize;
+            const glm::vec3 waypoints[] = {
+                glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(extent * 0.5f, 0.0f, extent * 0.5f),
+                glm::vec3(extent, 0.0f, extent), glm::vec3(extent * 0.5f, 0.0f, extent * 0.5f),
+                glm::vec3(0.0f, 0.0f, extent * 0.5f)
+            };
+
+            glm::vec3 position = waypoints[0];
+            for (const glm::vec3& waypoint : waypoints) {
+                while (passed && position != waypoint) {
+                    const glm::vec3 offset = waypoint - position;
+                    position = glm::length(offset) <= 4.0f ? waypoint : position + glm::normalize(offset) * 4.0f;
+                    update(position);
+                }
+
+                // Once the camera stops, every requested chunk must end up resident.
+                UInt32 settleFrames = 0;
+                for (; passed && settleFrames < maxSettleFrames; settleFrames++) {
+                    update(position);
+
+                    const ResidencyStats& stats = streaming.GetStats();
+                    if (stats.QueuedChunks == 0 && stats.LoadingChunks == 0) {
+                        check(stats.ResidentChunks >= stats.RequestedChunks, "requested chunks resident");
+                        break;
+                    }
+
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                check(settleFrames < maxSettleFrames, "requested chunks loaded in time");
+            }
+
+            if (passed) {
+                std::cout << "Streaming test passed after " << frame << " frames" << '\n';
+            }
+        }
+
+        std::filesystem::remove(path);
+        return passed;
+    }
+
+    bool ChunkModel(const std::string& modelPath, const std::string& chunkPath, const Float32 cellSize,
+                    JobSystem& jobs) {
+        // The chunks need the full vertices, which only the Assimp import keeps.
+        ModelImportSettings settings;
+        settings.CpuData = MeshCpuData::All;
+        settings.UseNativeGltf = false;
+
+        const Model model{modelPath, jobs, settings};
+
+        // The chunk file is in world space, the meshes are merged with their node transforms applied.
+        std::vector<Vertex> vertices;
+        std::vector<UInt32> indices;
+        for (UInt32 meshIndex = 0; meshIndex < model.GetMeshCount(); meshIndex++) {
+            const Mesh& mesh = model.GetMesh(meshIndex);
+            const glm::mat4& transform = model.GetMeshTransform(meshIndex);
+            const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+            const auto baseVertex = static_cast<UInt32>(vertices.size());
+
+            for (const Vertex& vertex : mesh.GetVertices()) {
+                vertices.push_back(Vertex{glm::vec3(transform * glm::vec4(vertex.Position, 1.0f)),
+                                                   normalMatrix * vertex.Normal, vertex.UVs});
+            }
+
+            for (const UInt32 index : mesh.GetIndices()) {
+                indices.push_back(baseVertex + index);
+            }
+        }
+
+        if (indices.empty() || cellSize <= 0.0f) {
+            std::cerr << "Nothing to split into chunks in: " << modelPath << '\n';
+            return false;
+        }
+
+        if (!WriteChunkFile(chunkPath, vertices, indices, cellSize)) {
+            return false;
+        }
+
+        std::cout << "Wrote " << indices.size() / 3 << " triangles to " << chunkPath << '\n';
+        return true;
+    }
+}
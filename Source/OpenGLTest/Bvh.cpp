@@ -0,0 +1,219 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/Bvh.hpp>
+
+#include <algorithm>
+
+namespace OGLTest {
+    void Bvh::Build(const std::span<const BoundingBox> primitiveBounds) {
+        m_Nodes.clear();
+        m_PrimitiveIndices.clear();
+
+        if (primitiveBounds.empty()) {
+            return;
+        }
+
+        const auto primitiveCount = static_cast<UInt32>(primitiveBounds.size());
+
+        std::vector<glm::vec3> centroids(primitiveCount);
+        m_PrimitiveIndices.resize(primitiveCount);
+        for (UInt32 i = 0; i < primitiveCount; i++) {
+            centroids[i] = primitiveBounds[i].GetCenter();
+            m_PrimitiveIndices[i] = i;
+        }
+
+        // A binary tree with N leaves has at most 2N - 1 nodes.
+        m_Nodes.reserve(2 * primitiveCount - 1);
+        m_Nodes.push_back(BvhNode{{}, 0, primitiveCount});
+        UpdateNodeBounds(0, primitiveBounds);
+        Subdivide(0, 0, primitiveBounds, centroids);
+
+        m_Nodes.shrink_to_fit();
+    }
+
+    void Bvh::Refit(const std::span<const BoundingBox> primitiveBounds) {
+        // Children are always stored after their parent, walking backwards visits them first.
+        for (UInt64 i = m_Nodes.size(); i-- > 0;) {
+            BvhNode& node = m_Nodes[i];
+
+            if (node.IsLeaf()) {
+                UpdateNodeBounds(static_cast<UInt32>(i), primitiveBounds);
+                continue;
+            }
+
+            node.Bounds = m_Nodes[node.LeftFirst].Bounds;
+            node.Bounds.Extend(m_Nodes[node.LeftFirst + 1].Bounds);
+        }
+    }
+
+    void Bvh::QueryFrustum(const Frustum& frustum, JobSystem& jobs, std::vector<UInt32>& primitiveIndices) const {
+        const auto append = [&primitiveIndices](const UInt32 primitiveIndex) {
+            primitiveIndices.push_back(primitiveIndex);
+        };
+
+        if (IsEmpty() || jobs.GetWorkerCount() == 0 || m_PrimitiveIndices.size() < g_BvhParallelQueryThreshold) {
+            QueryFrustum(frustum, append);
+            return;
+        }
+
+        // Opens the visible nodes breadth first until there are a few subtrees per thread to spread.
+        const UInt64 subtreeTarget = (jobs.GetWorkerCount() + 1) * 4;
+        std::vector<UInt32> subtrees{0};
+        std::vector<UInt32> next;
+        while (!subtrees.empty() && subtrees.size() < subtreeTarget) {
+            next.clear();
+            for (const UInt32 nodeIndex : subtrees) {
+                const BvhNode& node = m_Nodes[nodeIndex];
+                if (!frustum.Intersects(node.Bounds)) {
+                    continue;
+                }
+
+                if (node.IsLeaf()) {
+                    for (UInt32 i = 0; i < node.Count; i++) {
+                        append(m_PrimitiveIndices[node.LeftFirst + i]);
+                    }
+                } else {
+                    next.push_back(node.LeftFirst);
+                    next.push_back(node.LeftFirst + 1);
+                }
+            }
+            subtrees.swap(next);
+        }
+
+        // One result list per subtree, appended in order so the output doesn't depend on the scheduling.
+        std::vector<std::vector<UInt32>> results(subtrees.size());
+        jobs.ParallelFor(0, subtrees.size(), 1, [&](const UInt64 first, const UInt64 last) {
+            for (UInt64 i = first; i < last; i++) {
+                QuerySubtree(subtrees[i], frustum, [&results, i](const UInt32 primitiveIndex) {
+                    results[i].push_back(primitiveIndex);
+                });
+            }
+        });
+
+        for (const std::vector<UInt32>& result : results) {
+            primitiveIndices.insert(primitiveIndices.end(), result.begin(), result.end());
+        }
+    }
+
+    void Bvh::UpdateNodeBounds(const UInt32 nodeIndex, const std::span<const BoundingBox> primitiveBounds) {
+        BvhNode& node = m_Nodes[nodeIndex];
+        node.Bounds = BoundingBox{};
+
+        for (UInt32 i = 0; i < node.Count; i++) {
+            node.Bounds.Extend(primitiveBounds[m_PrimitiveIndices[node.LeftFirst + i]]);
+        }
+    }
+
+    void Bvh::Subdivide(const UInt32 nodeIndex, const UInt32 depth, const std::span<const BoundingBox> primitiveBounds,
+                        const std::span<const glm::vec3> centroids) {
+        const UInt32 first = m_Nodes[nodeIndex].LeftFirst;
+        const UInt32 count = m_Nodes[nodeIndex].Count;
+
+        if (count <= g_BvhMaxLeafSize || depth >= g_BvhMaxDepth) {
+            return;
+        }
+
+        // Bin the primitives along each axis by centroid and evaluate the SAH cost at every bin boundary.
+        BoundingBox centroidBounds;
+        for (UInt32 i = 0; i < count; i++) {
+            centroidBounds.Extend(centroids[m_PrimitiveIndices[first + i]]);
+        }
+
+        Int32 bestAxis = -1;
+        UInt32 bestSplit = 0;
+        Float32 bestCost = g_Infinity;
+
+        for (Int32 axis = 0; axis < 3; axis++) {
+            const Float32 axisMin = centroidBounds.Min[axis];
+            const Float32 axisMax = centroidBounds.Max[axis];
+
+            if (axisMax <= axisMin) {
+                continue;
+            }
+
+            BoundingBox binBounds[g_BvhBinCount];
+            UInt32 binCounts[g_BvhBinCount] = {};
+            const Float32 scale = static_cast<Float32>(g_BvhBinCount) / (axisMax - axisMin);
+
+            for (UInt32 i = 0; i < count; i++) {
+                const UInt32 primitive = m_PrimitiveIndices[first + i];
+                const auto bin = std::min(g_BvhBinCount - 1,
+                                          static_cast<UInt32>((centroids[primitive][axis] - axisMin) * scale));
+                binCounts[bin]++;
+                binBounds[bin].Extend(primitiveBounds[primitive]);
+            }
+
+            // Sweep from both sides to get the area and count on each side of every split plane.
+            Float32 leftAreas[g_BvhBinCount - 1];
+            Float32 rightAreas[g_BvhBinCount - 1];
+            UInt32 leftCounts[g_BvhBinCount - 1];
+            UInt32 rightCounts[g_BvhBinCount - 1];
+
+            BoundingBox leftBox;
+            BoundingBox rightBox;
+            UInt32 leftSum = 0;
+            UInt32 rightSum = 0;
+
+            for (UInt32 i = 0; i < g_BvhBinCount - 1; i++) {
+                leftSum += binCounts[i];
+                leftCounts[i] = leftSum;
+                leftBox.Extend(binBounds[i]);
+                leftAreas[i] = leftBox.GetSurfaceArea();
+
+                rightSum += binCounts[g_BvhBinCount - 1 - i];
+                rightCounts[g_BvhBinCount - 2 - i] = rightSum;
+                rightBox.Extend(binBounds[g_BvhBinCount - 1 - i]);
+                rightAreas[g_BvhBinCount - 2 - i] = rightBox.GetSurfaceArea();
+            }
+
+            for (UInt32 i = 0; i < g_BvhBinCount - 1; i++) {
+                if (leftCounts[i] == 0 || rightCounts[i] == 0) {
+                    continue;
+                }
+
+                const Float32 cost = static_cast<Float32>(leftCounts[i]) * leftAreas[i] +
+                                     static_cast<Float32>(rightCounts[i]) * rightAreas[i];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i + 1;
+                }
+            }
+        }
+
+        // Splitting must be cheaper than intersecting every primitive of the node.
+        const Float32 leafCost = static_cast<Float32>(count) * m_Nodes[nodeIndex].Bounds.GetSurfaceArea();
+        if (bestAxis < 0 || bestCost >= leafCost) {
+            return;
+        }
+
+        const Float32 axisMin = centroidBounds.Min[bestAxis];
+        const Float32 scale = static_cast<Float32>(g_BvhBinCount) / (centroidBounds.Max[bestAxis] - axisMin);
+        const auto middle = std::partition(m_PrimitiveIndices.begin() + first,
+                                           m_PrimitiveIndices.begin() + first + count,
+                                           [&](const UInt32 primitive) {
+                                               const auto bin = std::min(g_BvhBinCount - 1, static_cast<UInt32>(
+                                                   (centroids[primitive][bestAxis] - axisMin) * scale));
+                                               return bin < bestSplit;
+                                           });
+        const auto leftCount = static_cast<UInt32>(middle - (m_PrimitiveIndices.begin() + first));
+
+        if (leftCount == 0 || leftCount == count) {
+            return;
+        }
+
+        const auto leftIndex = static_cast<UInt32>(m_Nodes.size());
+        m_Nodes.push_back(BvhNode{{}, first, leftCount});
+        m_Nodes.push_back(BvhNode{{}, first + leftCount, count - leftCount});
+        m_Nodes[nodeIndex].LeftFirst = leftIndex;
+        m_Nodes[nodeIndex].Count = 0;
+
+        UpdateNodeBounds(leftIndex, primitiveBounds);
+        UpdateNodeBounds(leftIndex + 1, primitiveBounds);
+
+        Subdivide(leftIndex, depth + 1, primitiveBounds, centroids);
+        Subdivide(leftIndex + 1, depth + 1, primitiveBounds, centroids);
+    }
+}
@@ -23,6 +23,20 @@ namespace OGLTest {
         UpdateCameraVectors();
     }
 
+    Ray Camera::ScreenPointToRay(const Float32 x, const Float32 y, const Float32 viewportWidth,
+                                 const Float32 viewportHeight) const {
+        // convert to normalized device coordinates, y pointing up
+        const Float32 ndcX = 2.0f * x / viewportWidth - 1.0f;
+        const Float32 ndcY = 1.0f - 2.0f * y / viewportHeight;
+
+        // same projection as glm::perspective with Fov as the vertical field of view
+        const Float32 tanHalfFov = std::tan(glm::radians(Fov) * 0.5f);
+        const Float32 aspect = viewportWidth / viewportHeight;
+
+        const glm::vec3 direction = Front + Right * (ndcX * tanHalfFov * aspect) + Up * (ndcY * tanHalfFov);
+        return Ray{Position, glm::normalize(direction)};
+    }
+
     void Camera::ProcessKeyboard(CameraMovement direction, Float32 deltaTime) {
         Float32 velocity = MovementSpeed * deltaTime;
 
@@ -0,0 +1,6 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
\ No newline at end of file
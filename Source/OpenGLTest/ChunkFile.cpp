@@ -0,0 +1,193 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/ChunkFile.hpp>
+
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace OGLTest {
+    namespace {
+        bool WriteHeaderAndTable(std::ofstream& file, const std::vector<ChunkDesc>& chunks) {
+            const ChunkFileHeader header{g_ChunkFileMagic, g_ChunkFileVersion, static_cast<UInt32>(chunks.size()), 0};
+
+            file.seekp(0);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(chunks.data()),
+                       static_cast<std::streamsize>(chunks.size() * sizeof(ChunkDesc)));
+
+            return static_cast<bool>(file);
+        }
+
+        void WriteChunk(std::ofstream& file, const ChunkData& data, ChunkDesc& desc) {
+            desc.VertexCount = static_cast<UInt32>(data.Vertices.size());
+            desc.IndexCount = static_cast<UInt32>(data.Indices.size());
+            desc.Offset = static_cast<UInt64>(file.tellp());
+
+            file.write(reinterpret_cast<const char*>(data.Vertices.data()),
+                       static_cast<std::streamsize>(data.Vertices.size() * sizeof(Vertex)));
+            file.write(reinterpret_cast<const char*>(data.Indices.data()),
+                       static_cast<std::streamsize>(data.Indices.size() * sizeof(UInt32)));
+        }
+    }
+
+    bool ReadChunkTable(const std::filesystem::path& path, std::vector<ChunkDesc>& chunks) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Couldn't open chunk file at path: " << path << '\n';
+            return false;
+        }
+
+        ChunkFileHeader header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || header.Magic != g_ChunkFileMagic || header.Version != g_ChunkFileVersion) {
+            std::cerr << "Invalid chunk file: " << path << '\n';
+            return false;
+        }
+
+        chunks.resize(header.ChunkCount);
+        file.read(reinterpret_cast<char*>(chunks.data()),
+                  static_cast<std::streamsize>(chunks.size() * sizeof(ChunkDesc)));
+        if (!file) {
+            std::cerr << "Truncated chunk table in: " << path << '\n';
+            chunks.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool ReadChunkData(std::ifstream& file, const ChunkDesc& desc, ChunkData& data) {
+        data.Vertices.resize(desc.VertexCount);
+        data.Indices.resize(desc.IndexCount);
+
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(desc.Offset));
+        file.read(reinterpret_cast<char*>(data.Vertices.data()),
+                  static_cast<std::streamsize>(data.Vertices.size() * sizeof(Vertex)));
+        file.read(reinterpret_cast<char*>(data.Indices.data()),
+                  static_cast<std::streamsize>(data.Indices.size() * sizeof(UInt32)));
+
+        return static_cast<bool>(file);
+    }
+
+    bool WriteChunkFile(const std::filesystem::path& path, const std::span<const Vertex> vertices,
+                        const std::span<const UInt32> indices, const Float32 cellSize) {
+        using CellKey = std::tuple<Int32, Int32, Int32>;
+
+        struct ChunkBuilder {
+            ChunkData Data;
+            BoundingBox Bounds;
+            std::unordered_map<UInt32, UInt32> Remap;
+        };
+
+        // std::map keeps neighbouring cells next to each other in the file.
+        std::map<CellKey, ChunkBuilder> cells;
+
+        for (UInt64 i = 0; i + 2 < indices.size(); i += 3) {
+            const glm::vec3 centroid = (vertices[indices[i]].Position + vertices[indices[i + 1]].Position +
+                                        vertices[indices[i + 2]].Position) / 3.0f;
+            const CellKey key{static_cast<Int32>(std::floor(centroid.x / cellSize)),
+                              static_cast<Int32>(std::floor(centroid.y / cellSize)),
+                              static_cast<Int32>(std::floor(centroid.z / cellSize))};
+
+            ChunkBuilder& builder = cells[key];
+            for (UInt64 corner = 0; corner < 3; corner++) {
+                const UInt32 index = indices[i + corner];
+                const auto [it, inserted] = builder.Remap.try_emplace(index,
+                                                                      static_cast<UInt32>(builder.Data.Vertices.size()));
+                if (inserted) {
+                    builder.Data.Vertices.push_back(vertices[index]);
+                    builder.Bounds.Extend(vertices[index].Position);
+                }
+                builder.Data.Indices.push_back(it->second);
+            }
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Couldn't create chunk file at path: " << path << '\n';
+            return false;
+        }
+
+        std::vector<ChunkDesc> chunks(cells.size());
+        WriteHeaderAndTable(file, chunks);
+
+        UInt64 chunkIndex = 0;
+        for (auto& [key, builder] : cells) {
+            chunks[chunkIndex].Bounds = builder.Bounds;
+            WriteChunk(file, builder.Data, chunks[chunkIndex]);
+            chunkIndex++;
+        }
+
+        return WriteHeaderAndTable(file, chunks);
+    }
+
+    bool WriteSyntheticChunkFile(const std::filesystem::path& path, const UInt32 gridSize,
+                                 const UInt32 chunkResolution, const Float32 chunkSize) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Couldn't create chunk file at path: " << path << '\n';
+            return false;
+        }
+
+        std::vector<ChunkDesc> chunks(static_cast<UInt64>(gridSize) * gridSize);
+        WriteHeaderAndTable(file, chunks);
+
+        const UInt32 verticesPerSide = chunkResolution + 1;
+        const Float32 step = chunkSize / static_cast<Float32>(chunkResolution);
+        const auto height = [](const Float32 x, const Float32 z) {
+            return 2.0f * std::sin(x * 0.05f) * std::cos(z * 0.07f) + 0.5f * std::sin(x * 0.31f + z * 0.17f);
+        };
+
+        ChunkData data;
+        for (UInt32 chunkZ = 0; chunkZ < gridSize; chunkZ++) {
+            for (UInt32 chunkX = 0; chunkX < gridSize; chunkX++) {
+                ChunkDesc& desc = chunks[static_cast<UInt64>(chunkZ) * gridSize + chunkX];
+                desc.Bounds = BoundingBox{};
+
+                data.Vertices.clear();
+                data.Indices.clear();
+
+                const glm::vec2 origin(static_cast<Float32>(chunkX) * chunkSize,
+                                       static_cast<Float32>(chunkZ) * chunkSize);
+                for (UInt32 z = 0; z < verticesPerSide; z++) {
+                    for (UInt32 x = 0; x < verticesPerSide; x++) {
+                        const Float32 worldX = origin.x + static_cast<Float32>(x) * step;
+                        const Float32 worldZ = origin.y + static_cast<Float32>(z) * step;
+
+                        // Normal from central differences of the height function.
+                        const glm::vec3 normal = glm::normalize(glm::vec3(
+                            height(worldX - step, worldZ) - height(worldX + step, worldZ), 2.0f * step,
+                            height(worldX, worldZ - step) - height(worldX, worldZ + step)));
+
+                        Vertex vertex;
+                        vertex.Position = glm::vec3(worldX, height(worldX, worldZ), worldZ);
+                        vertex.Normal = normal;
+                        vertex.UVs = glm::vec2(static_cast<Float32>(x), static_cast<Float32>(z)) /
+                                     static_cast<Float32>(chunkResolution);
+                        data.Vertices.push_back(vertex);
+                        desc.Bounds.Extend(vertex.Position);
+                    }
+                }
+
+                for (UInt32 z = 0; z < chunkResolution; z++) {
+                    for (UInt32 x = 0; x < chunkResolution; x++) {
+                        const UInt32 topLeft = z * verticesPerSide + x;
+                        const UInt32 bottomLeft = topLeft + verticesPerSide;
+
+                        data.Indices.insert(data.Indices.end(), {topLeft, bottomLeft, topLeft + 1});
+                        data.Indices.insert(data.Indices.end(), {topLeft + 1, bottomLeft, bottomLeft + 1});
+                    }
+                }
+
+                WriteChunk(file, data, desc);
+            }
+        }
+
+        return WriteHeaderAndTable(file, chunks);
+    }
+}
@@ -0,0 +1,204 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/DynamicResolution.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace OGLTest {
+    namespace {
+        // Weight of a new timing in the smoothed GPU frame time.
+        constexpr Float32 g_GpuTimeSmoothing = 0.25f;
+        // Smaller scale changes aren't worth a visible resolution change.
+        constexpr Float32 g_MinScaleChange = 0.02f;
+    }
+
+    DynamicResolution::DynamicResolution(const DynamicResolutionSettings& settings)
+        : m_Settings(settings), m_UpscaleShader("Resources/Shaders/upscale.vert", "Resources/Shaders/upscale.frag") {
+        m_Settings.MaxScale = std::clamp(m_Settings.MaxScale, 0.1f, 1.0f);
+        m_Settings.MinScale = std::clamp(m_Settings.MinScale, 0.1f, m_Settings.MaxScale);
+        m_Scale = m_Settings.MaxScale;
+
+        for (TimerQuery& query : m_Queries) {
+            glGenQueries(1, &query.Query);
+        }
+
+        // The fullscreen triangle has no attributes, but the core profile needs a vertex array bound to draw.
+        glGenVertexArrays(1, &m_EmptyVAO);
+
+        m_UpscaleShader.Use();
+        m_UpscaleShader.Set("sceneColor", static_cast<Int32>(g_SceneColorUnit));
+    }
+
+    DynamicResolution::~DynamicResolution() {
+        DestroyTarget();
+        glDeleteVertexArrays(1, &m_EmptyVAO);
+
+        for (const TimerQuery& query : m_Queries) {
+            glDeleteQueries(1, &query.Query);
+        }
+    }
+
+    void DynamicResolution::BeginFrame(const Int32 width, const Int32 height) {
+        ReadQueries();
+
+        m_OutputWidth = std::max(width, 1);
+        m_OutputHeight = std::max(height, 1);
+        if (m_OutputWidth != m_TargetWidth || m_OutputHeight != m_TargetHeight) {
+            ResizeTarget(m_OutputWidth, m_OutputHeight);
+        }
+
+        m_RenderWidth = std::max(static_cast<Int32>(std::lround(static_cast<Float32>(m_OutputWidth) * m_Scale)), 1);
+        m_RenderHeight = std::max(static_cast<Int32>(std::lround(static_cast<Float32>(m_OutputHeight) * m_Scale)), 1);
+
+        // When the GPU is more than g_ResolutionQueryCount frames behind this frame goes untimed.
+        TimerQuery& query = m_Queries[m_QueryIndex];
+        m_Timing = !query.Pending;
+        if (m_Timing) {
+            query.Scale = m_Scale;
+            glBeginQuery(GL_TIME_ELAPSED, query.Query);
+        }
+
+        BindSceneTarget();
+    }
+
+    void DynamicResolution::BindSceneTarget() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+        glViewport(0, 0, m_RenderWidth, m_RenderHeight);
+    }
+
+    void DynamicResolution::Resolve() {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, m_OutputWidth, m_OutputHeight);
+        glDisable(GL_DEPTH_TEST);
+
+        glActiveTexture(GL_TEXTURE0 + g_SceneColorUnit);
+        glBindTexture(GL_TEXTURE_2D, m_ColorTexture);
+
+        const Float32 targetWidth = static_cast<Float32>(m_TargetWidth);
+        const Float32 targetHeight = static_cast<Float32>(m_TargetHeight);
+        m_UpscaleShader.Use();
+        m_UpscaleShader.Set("renderScale", static_cast<Float32>(m_RenderWidth) / targetWidth,
+                            static_cast<Float32>(m_RenderHeight) / targetHeight);
+        m_UpscaleShader.Set("texelSize", 1.0f / targetWidth, 1.0f / targetHeight);
+        m_UpscaleShader.Set("sharpness", m_Settings.Filter == UpscaleFilter::Sharpen ? m_Settings.Sharpness : 0.0f);
+
+        glBindVertexArray(m_EmptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+
+        glEnable(GL_DEPTH_TEST);
+
+        if (m_Timing) {
+            glEndQuery(GL_TIME_ELAPSED);
+            m_Queries[m_QueryIndex].Pending = true;
+            m_QueryIndex = (m_QueryIndex + 1) % g_ResolutionQueryCount;
+            m_Timing = false;
+        }
+    }
+
+    void DynamicResolution::ResizeTarget(const Int32 width, const Int32 height) {
+        DestroyTarget();
+
+        glGenTextures(1, &m_ColorTexture);
+        glBindTexture(GL_TEXTURE_2D, m_ColorTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenRenderbuffers(1, &m_DepthRenderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, m_DepthRenderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &m_Framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorTexture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthRenderbuffer);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Scene framebuffer of " << width << "x" << height << " is incomplete." << '\n';
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        m_TargetWidth = width;
+        m_TargetHeight = height;
+    }
+
+    void DynamicResolution::DestroyTarget() {
+        glDeleteFramebuffers(1, &m_Framebuffer);
+        glDeleteRenderbuffers(1, &m_DepthRenderbuffer);
+        glDeleteTextures(1, &m_ColorTexture);
+        m_Framebuffer = m_DepthRenderbuffer = m_ColorTexture = 0;
+    }
+
+    void DynamicResolution::ReadQueries() {
+        // Oldest first, the slot about to be reused is the one issued the longest ago.
+        for (UInt32 i = 0; i < g_ResolutionQueryCount; i++) {
+            TimerQuery& query = m_Queries[(m_QueryIndex + i) % g_ResolutionQueryCount];
+            if (!query.Pending) {
+                continue;
+            }
+
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(query.Query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                // The later ones can't be done either.
+                break;
+            }
+
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query.Query, GL_QUERY_RESULT, &nanoseconds);
+            query.Pending = false;
+
+            if (query.Scale == m_Scale) {
+                UpdateScale(static_cast<Float32>(static_cast<Float64>(nanoseconds) / 1.0e6));
+            }
+        }
+    }
+
+    void DynamicResolution::UpdateScale(const Float32 gpuFrameMs) {
+        m_GpuFrameMs = m_GpuFrameMs > 0.0f ? m_GpuFrameMs + (gpuFrameMs - m_GpuFrameMs) * g_GpuTimeSmoothing
+                                           : gpuFrameMs;
+        if (!m_Settings.Enabled) {
+            return;
+        }
+
+        const Float32 target = m_Settings.TargetFrameMs;
+        if (m_GpuFrameMs > target * m_Settings.DownscaleThreshold) {
+            m_OverBudgetFrames++;
+            m_UnderBudgetFrames = 0;
+        } else if (m_GpuFrameMs < target * m_Settings.UpscaleThreshold) {
+            m_UnderBudgetFrames++;
+            m_OverBudgetFrames = 0;
+        } else {
+            m_OverBudgetFrames = m_UnderBudgetFrames = 0;
+        }
+
+        if (m_OverBudgetFrames < m_Settings.DownscaleFrames && m_UnderBudgetFrames < m_Settings.UpscaleFrames) {
+            return;
+        }
+
+        // The GPU time mostly follows the pixel count, the square of the scale. Aim for the middle of the dead band so
+        // the next timings don't cross a threshold straight away.
+        const Float32 aim = target * 0.5f * (m_Settings.DownscaleThreshold + m_Settings.UpscaleThreshold);
+        Float32 scale = m_Scale * std::sqrt(aim / m_GpuFrameMs);
+        scale = std::clamp(scale, m_Scale - m_Settings.MaxScaleStep, m_Scale + m_Settings.MaxScaleStep);
+        scale = std::clamp(scale, m_Settings.MinScale, m_Settings.MaxScale);
+
+        m_OverBudgetFrames = m_UnderBudgetFrames = 0;
+        const bool atBound = scale == m_Settings.MinScale || scale == m_Settings.MaxScale;
+        if (scale == m_Scale || (std::abs(scale - m_Scale) < g_MinScaleChange && !atBound)) {
+            return;
+        }
+
+        // The frames in flight were rendered at the old scale, the average starts over from the next timing.
+        m_Scale = scale;
+        m_GpuFrameMs = 0.0f;
+    }
+}
@@ -0,0 +1,897 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/GLCapture.hpp>
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <tuple>
+
+namespace OGLTest {
+    namespace {
+        // The recorded calls are buffered and written at the end of each frame, or once this much is pending.
+        constexpr UInt64 g_CaptureFlushSize = 4ull << 20;
+
+        constexpr std::array<std::string_view, static_cast<UInt64>(GLCommand::Count)> g_CommandNames{
+            "FrameEnd",
+            "glActiveTexture",
+            "glAttachShader",
+            "glBeginConditionalRender",
+            "glBeginQuery",
+            "glBindBuffer",
+            "glBindBufferBase",
+            "glBindBufferRange",
+            "glBindFramebuffer",
+            "glBindRenderbuffer",
+            "glBindTexture",
+            "glBindVertexArray",
+            "glBlitFramebuffer",
+            "glBufferData",
+            "glBufferStorage",
+            "glBufferSubData",
+            "glClear",
+            "glClearColor",
+            "glClientWaitSync",
+            "glColorMask",
+            "glCompileShader",
+            "glCreateProgram",
+            "glCreateShader",
+            "glDeleteBuffers",
+            "glDeleteFramebuffers",
+            "glDeleteProgram",
+            "glDeleteQueries",
+            "glDeleteRenderbuffers",
+            "glDeleteShader",
+            "glDeleteSync",
+            "glDeleteTextures",
+            "glDeleteVertexArrays",
+            "glDepthMask",
+            "glDisable",
+            "glDrawArrays",
+            "glDrawBuffer",
+            "glDrawElements",
+            "glEnable",
+            "glEnableVertexAttribArray",
+            "glEndConditionalRender",
+            "glEndQuery",
+            "glFenceSync",
+            "glFinish",
+            "glFramebufferRenderbuffer",
+            "glFramebufferTexture2D",
+            "glFramebufferTextureLayer",
+            "glGenBuffers",
+            "glGenFramebuffers",
+            "glGenQueries",
+            "glGenRenderbuffers",
+            "glGenTextures",
+            "glGenVertexArrays",
+            "glGenerateMipmap",
+            "glGetUniformBlockIndex",
+            "glGetUniformLocation",
+            "glLinkProgram",
+            "glMapBufferRange",
+            "glPixelStorei",
+            "glPolygonOffset",
+            "glReadBuffer",
+            "glRenderbufferStorage",
+            "glShaderSource",
+            "glTexImage2D",
+            "glTexImage3D",
+            "glTexParameterfv",
+            "glTexParameteri",
+            "glTexSubImage2D",
+            "glTexSubImage3D",
+            "glUniform1f",
+            "glUniform1i",
+            "glUniform2f",
+            "glUniform2fv",
+            "glUniform3f",
+            "glUniform3fv",
+            "glUniform4f",
+            "glUniform4fv",
+            "glUniformBlockBinding",
+            "glUniformMatrix2fv",
+            "glUniformMatrix3fv",
+            "glUniformMatrix4fv",
+            "glUnmapBuffer",
+            "glUseProgram",
+            "glVertexAttribPointer",
+            "glViewport"
+        };
+
+        // The hooks are plain functions, they find the capture layer through this.
+        GLCapture* g_ActiveCapture = nullptr;
+
+        constexpr UInt32 GetUniformComponents(const GLCommand command) {
+            switch (command) {
+                case GLCommand::Uniform2fv: {
+                    return 2;
+                }
+                case GLCommand::Uniform3fv: {
+                    return 3;
+                }
+                case GLCommand::Uniform4fv:
+                case GLCommand::UniformMatrix2fv: {
+                    return 4;
+                }
+                case GLCommand::UniformMatrix3fv: {
+                    return 9;
+                }
+                case GLCommand::UniformMatrix4fv: {
+                    return 16;
+                }
+                default: {
+                    return 1;
+                }
+            }
+        }
+    }
+
+    std::string_view GetCommandName(const GLCommand command) {
+        const auto index = static_cast<UInt64>(command);
+        return index < g_CommandNames.size() ? g_CommandNames[index] : "Unknown";
+    }
+
+    GLCommandKind GetCommandKind(const GLCommand command) {
+        switch (command) {
+            case GLCommand::BlitFramebuffer:
+            case GLCommand::Clear:
+            case GLCommand::DrawArrays:
+            case GLCommand::DrawElements: {
+                return GLCommandKind::Draw;
+            }
+            case GLCommand::BindBuffer:
+            case GLCommand::BindBufferBase:
+            case GLCommand::BindBufferRange:
+            case GLCommand::BindFramebuffer:
+            case GLCommand::BindRenderbuffer:
+            case GLCommand::BindTexture:
+            case GLCommand::BindVertexArray:
+            case GLCommand::UseProgram: {
+                return GLCommandKind::Bind;
+            }
+            case GLCommand::BufferData:
+            case GLCommand::BufferStorage:
+            case GLCommand::BufferSubData:
+            case GLCommand::TexImage2D:
+            case GLCommand::TexImage3D:
+            case GLCommand::TexSubImage2D:
+            case GLCommand::TexSubImage3D:
+            case GLCommand::UnmapBuffer: {
+                return GLCommandKind::Upload;
+            }
+            default: {
+                return GLCommandKind::Other;
+            }
+        }
+    }
+
+    UInt64 GetImageSize(const GLsizei width, const GLsizei height, const GLsizei depth, const GLenum format,
+                        const GLenum type, const GLint alignment) {
+        UInt64 components;
+        switch (format) {
+            case GL_RED:
+            case GL_RED_INTEGER:
+            case GL_DEPTH_COMPONENT:
+            case GL_DEPTH_STENCIL: {
+                components = 1;
+                break;
+            }
+            case GL_RG:
+            case GL_RG_INTEGER: {
+                components = 2;
+                break;
+            }
+            case GL_RGB:
+            case GL_BGR:
+            case GL_RGB_INTEGER: {
+                components = 3;
+                break;
+            }
+            default: {
+                components = 4;
+                break;
+            }
+        }
+
+        UInt64 pixelSize;
+        switch (type) {
+            case GL_UNSIGNED_BYTE:
+            case GL_BYTE: {
+                pixelSize = components;
+                break;
+            }
+            case GL_UNSIGNED_SHORT:
+            case GL_SHORT:
+            case GL_HALF_FLOAT: {
+                pixelSize = components * 2;
+                break;
+            }
+            // Packed types, one value per pixel.
+            case GL_UNSIGNED_SHORT_5_6_5:
+            case GL_UNSIGNED_SHORT_4_4_4_4:
+            case GL_UNSIGNED_SHORT_5_5_5_1: {
+                pixelSize = 2;
+                break;
+            }
+            case GL_UNSIGNED_INT_24_8:
+            case GL_UNSIGNED_INT_2_10_10_10_REV:
+            case GL_UNSIGNED_INT_10F_11F_11F_REV:
+            case GL_UNSIGNED_INT_5_9_9_9_REV:
+            case GL_UNSIGNED_INT_8_8_8_8:
+            case GL_UNSIGNED_INT_8_8_8_8_REV: {
+                pixelSize = 4;
+                break;
+            }
+            case GL_FLOAT_32_UNSIGNED_INT_24_8_REV: {
+                pixelSize = 8;
+                break;
+            }
+            default: {
+                pixelSize = components * 4;
+                break;
+            }
+        }
+
+        const UInt64 rowAlignment = static_cast<UInt64>(std::max(alignment, 1));
+        const UInt64 rowSize = (static_cast<UInt64>(width) * pixelSize + rowAlignment - 1) / rowAlignment * rowAlignment;
+        return rowSize * static_cast<UInt64>(height) * static_cast<UInt64>(depth);
+    }
+
+    // Calls with scalar arguments, and pointers only used as values: recorded as they are, then the result.
+    template<GLCommand Command, typename Result, typename... Args>
+    struct GLCapture::Hook<Command, Result(APIENTRYP)(Args...)> {
+        static inline Result(APIENTRYP Original)(Args...) = nullptr;
+
+        static Result APIENTRY Call(Args... args) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(Command);
+
+            if constexpr (Command == GLCommand::PixelStorei) {
+                const auto [pname, param] = std::tuple{args...};
+                if (pname == GL_UNPACK_ALIGNMENT) {
+                    capture.m_UnpackAlignment = param;
+                }
+            } else if constexpr (Command == GLCommand::BindBuffer) {
+                const auto [target, buffer] = std::tuple{args...};
+                if (target == GL_PIXEL_UNPACK_BUFFER) {
+                    capture.m_PixelUnpackBuffer = buffer;
+                }
+            }
+
+            if (!capture.m_Recording) {
+                return Original(args...);
+            }
+
+            capture.Write(Command);
+            (capture.Write(args), ...);
+
+            if constexpr (std::is_void_v<Result>) {
+                Original(args...);
+            } else {
+                const Result result = Original(args...);
+                capture.Write(result);
+                return result;
+            }
+        }
+    };
+
+    // glGen*: the names are recorded once the GL returned them.
+    template<GLCommand Command>
+    struct GLCapture::Hook<Command, void(APIENTRYP)(GLsizei, GLuint*)> {
+        static inline void(APIENTRYP Original)(GLsizei, GLuint*) = nullptr;
+
+        static void APIENTRY Call(const GLsizei n, GLuint* names) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(Command);
+
+            Original(n, names);
+            if (capture.m_Recording) {
+                capture.WriteNames(Command, n, names);
+            }
+        }
+    };
+
+    // glDelete*
+    template<GLCommand Command>
+    struct GLCapture::Hook<Command, void(APIENTRYP)(GLsizei, const GLuint*)> {
+        static inline void(APIENTRYP Original)(GLsizei, const GLuint*) = nullptr;
+
+        static void APIENTRY Call(const GLsizei n, const GLuint* names) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(Command);
+
+            if (capture.m_Recording) {
+                capture.WriteNames(Command, n, names);
+            }
+            Original(n, names);
+        }
+    };
+
+    // glUniform*fv
+    template<GLCommand Command>
+    struct GLCapture::Hook<Command, void(APIENTRYP)(GLint, GLsizei, const GLfloat*)> {
+        static inline void(APIENTRYP Original)(GLint, GLsizei, const GLfloat*) = nullptr;
+
+        static void APIENTRY Call(const GLint location, const GLsizei count, const GLfloat* value) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(Command);
+
+            if (capture.m_Recording) {
+                capture.Write(Command);
+                capture.Write(location);
+                capture.Write(count);
+                capture.WriteData(value, static_cast<UInt64>(count) * GetUniformComponents(Command) * sizeof(GLfloat));
+            }
+            Original(location, count, value);
+        }
+    };
+
+    // glUniformMatrix*fv
+    template<GLCommand Command>
+    struct GLCapture::Hook<Command, void(APIENTRYP)(GLint, GLsizei, GLboolean, const GLfloat*)> {
+        static inline void(APIENTRYP Original)(GLint, GLsizei, GLboolean, const GLfloat*) = nullptr;
+
+        static void APIENTRY Call(const GLint location, const GLsizei count, const GLboolean transpose,
+                                  const GLfloat* value) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(Command);
+
+            if (capture.m_Recording) {
+                capture.Write(Command);
+                capture.Write(location);
+                capture.Write(count);
+                capture.Write(transpose);
+                capture.WriteData(value, static_cast<UInt64>(count) * GetUniformComponents(Command) * sizeof(GLfloat));
+            }
+            Original(location, count, transpose, value);
+        }
+    };
+
+    // glGetUniformLocation and glGetUniformBlockIndex, the replay maps the results to its own.
+    template<GLCommand Command, typename Result>
+    struct GLCapture::Hook<Command, Result(APIENTRYP)(GLuint, const GLchar*)> {
+        static inline Result(APIENTRYP Original)(GLuint, const GLchar*) = nullptr;
+
+        static Result APIENTRY Call(const GLuint program, const GLchar* name) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(Command);
+
+            const Result result = Original(program, name);
+            if (capture.m_Recording) {
+                capture.Write(Command);
+                capture.Write(program);
+                capture.WriteData(name, std::char_traits<GLchar>::length(name));
+                capture.Write(result);
+            }
+
+            return result;
+        }
+    };
+
+    // glBufferData and glBufferStorage
+    template<GLCommand Command>
+    struct GLCapture::Hook<Command, void(APIENTRYP)(GLenum, GLsizeiptr, const void*, GLenum)> {
+        static inline void(APIENTRYP Original)(GLenum, GLsizeiptr, const void*, GLenum) = nullptr;
+
+        static void APIENTRY Call(const GLenum target, const GLsizeiptr size, const void* data, const GLenum usage) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(Command);
+            if (data) {
+                capture.m_Counters.UploadedBytes += static_cast<UInt64>(size);
+            }
+
+            if (capture.m_Recording) {
+                capture.Write(Command);
+                capture.Write(target);
+                capture.Write(size);
+                capture.WriteData(data, static_cast<UInt64>(size));
+                capture.Write(usage);
+            }
+            Original(target, size, data, usage);
+        }
+    };
+
+    template<>
+    struct GLCapture::Hook<GLCommand::BufferSubData, PFNGLBUFFERSUBDATAPROC> {
+        static inline PFNGLBUFFERSUBDATAPROC Original = nullptr;
+
+        static void APIENTRY Call(const GLenum target, const GLintptr offset, const GLsizeiptr size,
+                                  const void* data) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(GLCommand::BufferSubData);
+            capture.m_Counters.UploadedBytes += static_cast<UInt64>(size);
+
+            if (capture.m_Recording) {
+                capture.Write(GLCommand::BufferSubData);
+                capture.Write(target);
+                capture.Write(offset);
+                capture.Write(size);
+                capture.WriteData(data, static_cast<UInt64>(size));
+            }
+            Original(target, offset, size, data);
+        }
+    };
+
+    template<>
+    struct GLCapture::Hook<GLCommand::MapBufferRange, PFNGLMAPBUFFERRANGEPROC> {
+        static inline PFNGLMAPBUFFERRANGEPROC Original = nullptr;
+
+        static void* APIENTRY Call(const GLenum target, const GLintptr offset, const GLsizeiptr length,
+                                   const GLbitfield access) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(GLCommand::MapBufferRange);
+
+            void* data = Original(target, offset, length, access);
+            if (data && (access & GL_MAP_WRITE_BIT)) {
+                capture.m_Mappings.push_back({target, static_cast<const UInt8*>(data), length, access});
+            }
+
+            if (capture.m_Recording) {
+                capture.Write(GLCommand::MapBufferRange);
+                capture.Write(target);
+                capture.Write(offset);
+                capture.Write(length);
+                capture.Write(access);
+                capture.Write(data);
+            }
+
+            return data;
+        }
+    };
+
+    // What was written through a mapping is recorded when it's unmapped.
+    template<>
+    struct GLCapture::Hook<GLCommand::UnmapBuffer, PFNGLUNMAPBUFFERPROC> {
+        static inline PFNGLUNMAPBUFFERPROC Original = nullptr;
+
+        static GLboolean APIENTRY Call(const GLenum target) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(GLCommand::UnmapBuffer);
+
+            const auto mapping = std::find_if(capture.m_Mappings.begin(), capture.m_Mappings.end(),
+                                              [target](const Mapping& candidate) {
+                                                  return candidate.Target == target;
+                                              });
+            const UInt8* data = nullptr;
+            UInt64 size = 0;
+            if (mapping != capture.m_Mappings.end()) {
+                data = mapping->Data;
+                size = static_cast<UInt64>(mapping->Length);
+                capture.m_Counters.UploadedBytes += size;
+            }
+
+            if (capture.m_Recording) {
+                capture.Write(GLCommand::UnmapBuffer);
+                capture.Write(target);
+                capture.WriteData(data, size);
+            }
+
+            if (mapping != capture.m_Mappings.end()) {
+                capture.m_Mappings.erase(mapping);
+            }
+
+            const GLboolean result = Original(target);
+            if (capture.m_Recording) {
+                capture.Write(result);
+            }
+
+            return result;
+        }
+    };
+
+    template<>
+    struct GLCapture::Hook<GLCommand::ShaderSource, PFNGLSHADERSOURCEPROC> {
+        static inline PFNGLSHADERSOURCEPROC Original = nullptr;
+
+        static void APIENTRY Call(const GLuint shader, const GLsizei count, const GLchar* const* string,
+                                  const GLint* length) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(GLCommand::ShaderSource);
+
+            if (capture.m_Recording) {
+                // The strings are recorded concatenated, as a single one.
+                std::string source;
+                for (GLsizei i = 0; i < count; i++) {
+                    if (length && length[i] >= 0) {
+                        source.append(string[i], static_cast<UInt64>(length[i]));
+                    } else {
+                        source.append(string[i]);
+                    }
+                }
+
+                capture.Write(GLCommand::ShaderSource);
+                capture.Write(shader);
+                capture.WriteData(source.data(), source.size());
+            }
+            Original(shader, count, string, length);
+        }
+    };
+
+    template<>
+    struct GLCapture::Hook<GLCommand::TexParameterfv, PFNGLTEXPARAMETERFVPROC> {
+        static inline PFNGLTEXPARAMETERFVPROC Original = nullptr;
+
+        static void APIENTRY Call(const GLenum target, const GLenum pname, const GLfloat* params) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(GLCommand::TexParameterfv);
+
+            if (capture.m_Recording) {
+                const UInt64 count = pname == GL_TEXTURE_BORDER_COLOR ? 4 : 1;
+
+                capture.Write(GLCommand::TexParameterfv);
+                capture.Write(target);
+                capture.Write(pname);
+                capture.WriteData(params, count * sizeof(GLfloat));
+            }
+            Original(target, pname, params);
+        }
+    };
+
+    template<>
+    struct GLCapture::Hook<GLCommand::TexImage2D, PFNGLTEXIMAGE2DPROC> {
+        static inline PFNGLTEXIMAGE2DPROC Original = nullptr;
+
+        static void APIENTRY Call(const GLenum target, const GLint level, const GLint internalFormat,
+                                  const GLsizei width, const GLsizei height, const GLint border, const GLenum format,
+                                  const GLenum type, const void* pixels) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(GLCommand::TexImage2D);
+
+            const UInt64 size = capture.GetUploadSize(pixels, width, height, 1, format, type);
+            capture.m_Counters.UploadedBytes += size;
+
+            if (capture.m_Recording) {
+                capture.Write(GLCommand::TexImage2D);
+                capture.Write(target);
+                capture.Write(level);
+                capture.Write(internalFormat);
+                capture.Write(width);
+                capture.Write(height);
+                capture.Write(border);
+                capture.Write(format);
+                capture.Write(type);
+                capture.WriteImage(pixels, size);
+            }
+            Original(target, level, internalFormat, width, height, border, format, type, pixels);
+        }
+    };
+
+    template<>
+    struct GLCapture::Hook<GLCommand::TexImage3D, PFNGLTEXIMAGE3DPROC> {
+        static inline PFNGLTEXIMAGE3DPROC Original = nullptr;
+
+        static void APIENTRY Call(const GLenum target, const GLint level, const GLint internalFormat,
+                                  const GLsizei width, const GLsizei height, const GLsizei depth, const GLint border,
+                                  const GLenum format, const GLenum type, const void* pixels) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(GLCommand::TexImage3D);
+
+            const UInt64 size = capture.GetUploadSize(pixels, width, height, depth, format, type);
+            capture.m_Counters.UploadedBytes += size;
+
+            if (capture.m_Recording) {
+                capture.Write(GLCommand::TexImage3D);
+                capture.Write(target);
+                capture.Write(level);
+                capture.Write(internalFormat);
+                capture.Write(width);
+                capture.Write(height);
+                capture.Write(depth);
+                capture.Write(border);
+                capture.Write(format);
+                capture.Write(type);
+                capture.WriteImage(pixels, size);
+            }
+            Original(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+        }
+    };
+
+    template<>
+    struct GLCapture::Hook<GLCommand::TexSubImage2D, PFNGLTEXSUBIMAGE2DPROC> {
+        static inline PFNGLTEXSUBIMAGE2DPROC Original = nullptr;
+
+        static void APIENTRY Call(const GLenum target, const GLint level, const GLint xOffset, const GLint yOffset,
+                                  const GLsizei width, const GLsizei height, const GLenum format, const GLenum type,
+                                  const void* pixels) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(GLCommand::TexSubImage2D);
+
+            const UInt64 size = capture.GetUploadSize(pixels, width, height, 1, format, type);
+            capture.m_Counters.UploadedBytes += size;
+
+            if (capture.m_Recording) {
+                capture.Write(GLCommand::TexSubImage2D);
+                capture.Write(target);
+                capture.Write(level);
+                capture.Write(xOffset);
+                capture.Write(yOffset);
+                capture.Write(width);
+                capture.Write(height);
+                capture.Write(format);
+                capture.Write(type);
+                capture.WriteImage(pixels, size);
+            }
+            Original(target, level, xOffset, yOffset, width, height, format, type, pixels);
+        }
+    };
+
+    template<>
+    struct GLCapture::Hook<GLCommand::TexSubImage3D, PFNGLTEXSUBIMAGE3DPROC> {
+        static inline PFNGLTEXSUBIMAGE3DPROC Original = nullptr;
+
+        static void APIENTRY Call(const GLenum target, const GLint level, const GLint xOffset, const GLint yOffset,
+                                  const GLint zOffset, const GLsizei width, const GLsizei height, const GLsizei depth,
+                                  const GLenum format, const GLenum type, const void* pixels) {
+            GLCapture& capture = *g_ActiveCapture;
+            capture.Count(GLCommand::TexSubImage3D);
+
+            const UInt64 size = capture.GetUploadSize(pixels, width, height, depth, format, type);
+            capture.m_Counters.UploadedBytes += size;
+
+            if (capture.m_Recording) {
+                capture.Write(GLCommand::TexSubImage3D);
+                capture.Write(target);
+                capture.Write(level);
+                capture.Write(xOffset);
+                capture.Write(yOffset);
+                capture.Write(zOffset);
+                capture.Write(width);
+                capture.Write(height);
+                capture.Write(depth);
+                capture.Write(format);
+                capture.Write(type);
+                capture.WriteImage(pixels, size);
+            }
+            Original(target, level, xOffset, yOffset, zOffset, width, height, depth, format, type, pixels);
+        }
+    };
+
+    GLCapture::GLCapture() {
+        if (g_ActiveCapture) {
+            std::cerr << "A GL capture layer is already installed." << '\n';
+            return;
+        }
+
+        g_ActiveCapture = this;
+        InstallHooks(true);
+    }
+
+    GLCapture::~GLCapture() {
+        if (g_ActiveCapture != this) {
+            return;
+        }
+
+        StopRecording();
+        InstallHooks(false);
+        g_ActiveCapture = nullptr;
+    }
+
+    bool GLCapture::StartRecording(const std::filesystem::path& path, const UInt32 width, const UInt32 height,
+                                   const UInt32 frameCount) {
+        StopRecording();
+
+        if (g_ActiveCapture != this) {
+            return false;
+        }
+
+        m_File.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_File) {
+            std::cerr << "Couldn't create capture file at path: " << path << '\n';
+            return false;
+        }
+
+        const CaptureFileHeader header{g_CaptureFileMagic, g_CaptureFileVersion, width, height};
+        WriteBytes(&header, sizeof(header));
+
+        m_Recording = true;
+        m_FramesLeft = frameCount;
+        m_StopAfterFrames = frameCount > 0;
+
+        return true;
+    }
+
+    void GLCapture::StopRecording() {
+        if (!m_Recording) {
+            return;
+        }
+
+        Flush();
+        m_File.close();
+        m_Recording = false;
+    }
+
+    bool GLCapture::IsRecording() {
+        return g_ActiveCapture && g_ActiveCapture->m_Recording;
+    }
+
+    void GLCapture::EndFrame() {
+        if (m_Recording) {
+            Write(GLCommand::FrameEnd);
+            Flush();
+
+            // The first frame ending is the loading one, which isn't counted.
+            if (m_StopAfterFrames) {
+                if (m_FramesLeft == 0) {
+                    StopRecording();
+                } else {
+                    m_FramesLeft--;
+                }
+            }
+        }
+
+        std::lock_guard lock(m_StatsMutex);
+        m_FrameStats = m_Counters;
+        m_Counters = GLCallStats{};
+    }
+
+    GLCallStats GLCapture::GetFrameStats() const {
+        std::lock_guard lock(m_StatsMutex);
+        return m_FrameStats;
+    }
+
+    template<GLCommand Command, typename Function>
+    void GLCapture::SwapHook(Function& pointer, const bool install) {
+        using HookType = Hook<Command, Function>;
+
+        if (install) {
+            // Functions the loader didn't find stay null.
+            if (pointer) {
+                HookType::Original = pointer;
+                pointer = &HookType::Call;
+            }
+        } else if (HookType::Original) {
+            pointer = HookType::Original;
+            HookType::Original = nullptr;
+        }
+    }
+
+    void GLCapture::InstallHooks(const bool install) {
+        SwapHook<GLCommand::ActiveTexture>(glad_glActiveTexture, install);
+        SwapHook<GLCommand::AttachShader>(glad_glAttachShader, install);
+        SwapHook<GLCommand::BeginConditionalRender>(glad_glBeginConditionalRender, install);
+        SwapHook<GLCommand::BeginQuery>(glad_glBeginQuery, install);
+        SwapHook<GLCommand::BindBuffer>(glad_glBindBuffer, install);
+        SwapHook<GLCommand::BindBufferBase>(glad_glBindBufferBase, install);
+        SwapHook<GLCommand::BindBufferRange>(glad_glBindBufferRange, install);
+        SwapHook<GLCommand::BindFramebuffer>(glad_glBindFramebuffer, install);
+        SwapHook<GLCommand::BindRenderbuffer>(glad_glBindRenderbuffer, install);
+        SwapHook<GLCommand::BindTexture>(glad_glBindTexture, install);
+        SwapHook<GLCommand::BindVertexArray>(glad_glBindVertexArray, install);
+        SwapHook<GLCommand::BlitFramebuffer>(glad_glBlitFramebuffer, install);
+        SwapHook<GLCommand::BufferData>(glad_glBufferData, install);
+#ifdef GL_MAP_PERSISTENT_BIT
+        SwapHook<GLCommand::BufferStorage>(glad_glBufferStorage, install);
+#endif
+        SwapHook<GLCommand::BufferSubData>(glad_glBufferSubData, install);
+        SwapHook<GLCommand::Clear>(glad_glClear, install);
+        SwapHook<GLCommand::ClearColor>(glad_glClearColor, install);
+        SwapHook<GLCommand::ClientWaitSync>(glad_glClientWaitSync, install);
+        SwapHook<GLCommand::ColorMask>(glad_glColorMask, install);
+        SwapHook<GLCommand::CompileShader>(glad_glCompileShader, install);
+        SwapHook<GLCommand::CreateProgram>(glad_glCreateProgram, install);
+        SwapHook<GLCommand::CreateShader>(glad_glCreateShader, install);
+        SwapHook<GLCommand::DeleteBuffers>(glad_glDeleteBuffers, install);
+        SwapHook<GLCommand::DeleteFramebuffers>(glad_glDeleteFramebuffers, install);
+        SwapHook<GLCommand::DeleteProgram>(glad_glDeleteProgram, install);
+        SwapHook<GLCommand::DeleteQueries>(glad_glDeleteQueries, install);
+        SwapHook<GLCommand::DeleteRenderbuffers>(glad_glDeleteRenderbuffers, install);
+        SwapHook<GLCommand::DeleteShader>(glad_glDeleteShader, install);
+        SwapHook<GLCommand::DeleteSync>(glad_glDeleteSync, install);
+        SwapHook<GLCommand::DeleteTextures>(glad_glDeleteTextures, install);
+        SwapHook<GLCommand::DeleteVertexArrays>(glad_glDeleteVertexArrays, install);
+        SwapHook<GLCommand::DepthMask>(glad_glDepthMask, install);
+        SwapHook<GLCommand::Disable>(glad_glDisable, install);
+        SwapHook<GLCommand::DrawArrays>(glad_glDrawArrays, install);
+        SwapHook<GLCommand::DrawBuffer>(glad_glDrawBuffer, install);
+        SwapHook<GLCommand::DrawElements>(glad_glDrawElements, install);
+        SwapHook<GLCommand::Enable>(glad_glEnable, install);
+        SwapHook<GLCommand::EnableVertexAttribArray>(glad_glEnableVertexAttribArray, install);
+        SwapHook<GLCommand::EndConditionalRender>(glad_glEndConditionalRender, install);
+        SwapHook<GLCommand::EndQuery>(glad_glEndQuery, install);
+        SwapHook<GLCommand::FenceSync>(glad_glFenceSync, install);
+        SwapHook<GLCommand::Finish>(glad_glFinish, install);
+        SwapHook<GLCommand::FramebufferRenderbuffer>(glad_glFramebufferRenderbuffer, install);
+        SwapHook<GLCommand::FramebufferTexture2D>(glad_glFramebufferTexture2D, install);
+        SwapHook<GLCommand::FramebufferTextureLayer>(glad_glFramebufferTextureLayer, install);
+        SwapHook<GLCommand::GenBuffers>(glad_glGenBuffers, install);
+        SwapHook<GLCommand::GenFramebuffers>(glad_glGenFramebuffers, install);
+        SwapHook<GLCommand::GenQueries>(glad_glGenQueries, install);
+        SwapHook<GLCommand::GenRenderbuffers>(glad_glGenRenderbuffers, install);
+        SwapHook<GLCommand::GenTextures>(glad_glGenTextures, install);
+        SwapHook<GLCommand::GenVertexArrays>(glad_glGenVertexArrays, install);
+        SwapHook<GLCommand::GenerateMipmap>(glad_glGenerateMipmap, install);
+        SwapHook<GLCommand::GetUniformBlockIndex>(glad_glGetUniformBlockIndex, install);
+        SwapHook<GLCommand::GetUniformLocation>(glad_glGetUniformLocation, install);
+        SwapHook<GLCommand::LinkProgram>(glad_glLinkProgram, install);
+        SwapHook<GLCommand::MapBufferRange>(glad_glMapBufferRange, install);
+        SwapHook<GLCommand::PixelStorei>(glad_glPixelStorei, install);
+        SwapHook<GLCommand::PolygonOffset>(glad_glPolygonOffset, install);
+        SwapHook<GLCommand::ReadBuffer>(glad_glReadBuffer, install);
+        SwapHook<GLCommand::RenderbufferStorage>(glad_glRenderbufferStorage, install);
+        SwapHook<GLCommand::ShaderSource>(glad_glShaderSource, install);
+        SwapHook<GLCommand::TexImage2D>(glad_glTexImage2D, install);
+        SwapHook<GLCommand::TexImage3D>(glad_glTexImage3D, install);
+        SwapHook<GLCommand::TexParameterfv>(glad_glTexParameterfv, install);
+        SwapHook<GLCommand::TexParameteri>(glad_glTexParameteri, install);
+        SwapHook<GLCommand::TexSubImage2D>(glad_glTexSubImage2D, install);
+        SwapHook<GLCommand::TexSubImage3D>(glad_glTexSubImage3D, install);
+        SwapHook<GLCommand::Uniform1f>(glad_glUniform1f, install);
+        SwapHook<GLCommand::Uniform1i>(glad_glUniform1i, install);
+        SwapHook<GLCommand::Uniform2f>(glad_glUniform2f, install);
+        SwapHook<GLCommand::Uniform2fv>(glad_glUniform2fv, install);
+        SwapHook<GLCommand::Uniform3f>(glad_glUniform3f, install);
+        SwapHook<GLCommand::Uniform3fv>(glad_glUniform3fv, install);
+        SwapHook<GLCommand::Uniform4f>(glad_glUniform4f, install);
+        SwapHook<GLCommand::Uniform4fv>(glad_glUniform4fv, install);
+        SwapHook<GLCommand::UniformBlockBinding>(glad_glUniformBlockBinding, install);
+        SwapHook<GLCommand::UniformMatrix2fv>(glad_glUniformMatrix2fv, install);
+        SwapHook<GLCommand::UniformMatrix3fv>(glad_glUniformMatrix3fv, install);
+        SwapHook<GLCommand::UniformMatrix4fv>(glad_glUniformMatrix4fv, install);
+        SwapHook<GLCommand::UnmapBuffer>(glad_glUnmapBuffer, install);
+        SwapHook<GLCommand::UseProgram>(glad_glUseProgram, install);
+        SwapHook<GLCommand::VertexAttribPointer>(glad_glVertexAttribPointer, install);
+        SwapHook<GLCommand::Viewport>(glad_glViewport, install);
+    }
+
+    void GLCapture::WriteData(const void* data, const UInt64 size) {
+        if (!data) {
+            Write(g_CaptureNullData);
+            return;
+        }
+
+        Write(size);
+        if (size < g_CaptureFlushSize) {
+            WriteBytes(data, size);
+            if (m_Buffer.size() >= g_CaptureFlushSize) {
+                Flush();
+            }
+            return;
+        }
+
+        // Large uploads go straight to the file instead of through the buffer.
+        Flush();
+        m_File.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+
+    void GLCapture::WriteNames(const GLCommand command, const GLsizei n, const GLuint* names) {
+        Write(command);
+        Write(n);
+        WriteBytes(names, static_cast<UInt64>(std::max(n, 0)) * sizeof(GLuint));
+    }
+
+    UInt64 GLCapture::GetUploadSize(const void* pixels, const GLsizei width, const GLsizei height,
+                                    const GLsizei depth, const GLenum format, const GLenum type) const {
+        if (!pixels || m_PixelUnpackBuffer != 0) {
+            return 0;
+        }
+
+        return GetImageSize(width, height, depth, format, type, m_UnpackAlignment);
+    }
+
+    void GLCapture::WriteImage(const void* pixels, const UInt64 size) {
+        if (m_PixelUnpackBuffer != 0) {
+            Write(UInt8{1});
+            Write(pixels);
+            return;
+        }
+
+        Write(UInt8{0});
+        WriteData(pixels, size);
+    }
+
+    void GLCapture::Flush() {
+        if (!m_Buffer.empty()) {
+            m_File.write(reinterpret_cast<const char*>(m_Buffer.data()), static_cast<std::streamsize>(m_Buffer.size()));
+            m_Buffer.clear();
+        }
+
+        if (m_Recording && !m_File) {
+            std::cerr << "Couldn't write the capture file, recording stopped." << '\n';
+            m_File.close();
+            m_Recording = false;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/GLCaptureReader.hpp>
+
+namespace OGLTest {
+    bool GLCaptureReader::Open(const std::filesystem::path& path) {
+        m_Offset = 0;
+        m_Failed = false;
+
+        if (!m_File.Open(path)) {
+            std::cerr << "Couldn't open capture file at path: " << path << '\n';
+            return false;
+        }
+
+        m_Header = Read<CaptureFileHeader>();
+        if (m_Failed || m_Header.Magic != g_CaptureFileMagic || m_Header.Version != g_CaptureFileVersion) {
+            std::cerr << "Invalid capture file: " << path << '\n';
+            m_File.Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool GLCaptureReader::ReadCommand(GLCommand& command) {
+        if (m_Failed || m_Offset >= m_File.GetData().size()) {
+            return false;
+        }
+
+        command = static_cast<GLCommand>(Read<UInt16>());
+        if (command >= GLCommand::Count) {
+            std::cerr << "Unknown command " << static_cast<UInt16>(command) << " in capture at offset " << m_Offset
+                      << '\n';
+            m_Failed = true;
+        }
+
+        return !m_Failed;
+    }
+
+    std::span<const UInt8> GLCaptureReader::ReadData() {
+        const UInt64 size = Read<UInt64>();
+        if (size == g_CaptureNullData) {
+            return {};
+        }
+
+        const UInt8* data = Consume(size);
+        return data ? std::span<const UInt8>{data, size} : std::span<const UInt8>{};
+    }
+
+    const UInt8* GLCaptureReader::Consume(const UInt64 size) {
+        const std::span<const UInt8> file = m_File.GetData();
+        if (m_Failed || size > file.size() - m_Offset) {
+            if (!m_Failed) {
+                std::cerr << "Truncated capture at offset " << m_Offset << '\n';
+            }
+            m_Failed = true;
+            return nullptr;
+        }
+
+        const UInt8* data = file.data() + m_Offset;
+        m_Offset += size;
+        return data;
+    }
+}
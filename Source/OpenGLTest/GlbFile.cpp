@@ -0,0 +1,128 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/GlbFile.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace OGLTest {
+    GlbFile::~GlbFile() {
+        cgltf_free(m_Data);
+    }
+
+    bool GlbFile::Open(const std::filesystem::path& path) {
+        cgltf_free(m_Data);
+        m_Data = nullptr;
+
+        if (!m_File.Open(path)) {
+            std::cerr << "Couldn't map glTF file: " << path << '\n';
+            return false;
+        }
+
+        const std::span<const UInt8> bytes = m_File.GetData();
+        cgltf_options options{};
+        options.type = cgltf_file_type_glb;
+        if (cgltf_parse(&options, bytes.data(), bytes.size(), &m_Data) != cgltf_result_success) {
+            std::cerr << "Couldn't parse GLB file: " << path << '\n';
+            m_Data = nullptr;
+            return false;
+        }
+
+        if (cgltf_validate(m_Data) != cgltf_result_success) {
+            std::cerr << "Invalid glTF data in " << path << '\n';
+            return false;
+        }
+
+        return IsSupported(path);
+    }
+
+    std::span<const UInt8> GlbFile::GetBufferView(const cgltf_buffer_view& view) const {
+        return {static_cast<const UInt8*>(m_Data->bin) + view.offset, view.size};
+    }
+
+    const UInt8* GlbFile::GetAccessorData(const cgltf_accessor& accessor) const {
+        return GetBufferView(*accessor.buffer_view).data() + accessor.offset;
+    }
+
+    bool GlbFile::IsSupported(const std::filesystem::path& path) const {
+        const auto reject = [&](const std::string_view reason) {
+            std::cerr << "Native glTF loading of " << path << " isn't possible: " << reason << '\n';
+            return false;
+        };
+
+        if (m_Data->extensions_required_count > 0) {
+            return reject(std::string("required extension ") + m_Data->extensions_required[0]);
+        }
+
+        // Every buffer view must be in the binary chunk, which is only the case of the first buffer without URI.
+        for (UInt64 i = 0; i < m_Data->buffer_views_count; i++) {
+            const cgltf_buffer_view& view = m_Data->buffer_views[i];
+            if (view.buffer != &m_Data->buffers[0] || view.buffer->uri || !m_Data->bin ||
+                view.offset + view.size > m_Data->bin_size) {
+                return reject("buffer outside of the binary chunk");
+            }
+
+            if (view.has_meshopt_compression) {
+                return reject("compressed buffer view");
+            }
+        }
+
+        for (UInt64 i = 0; i < m_Data->meshes_count; i++) {
+            const cgltf_mesh& mesh = m_Data->meshes[i];
+            for (UInt64 j = 0; j < mesh.primitives_count; j++) {
+                const cgltf_primitive& primitive = mesh.primitives[j];
+                if (primitive.type != cgltf_primitive_type_triangles) {
+                    return reject("non-triangle primitive");
+                }
+
+                if (primitive.has_draco_mesh_compression) {
+                    return reject("compressed primitive");
+                }
+
+                if (!primitive.indices || !IsAccessorInBounds(*primitive.indices) ||
+                    primitive.indices->type != cgltf_type_scalar ||
+                    primitive.indices->component_type == cgltf_component_type_r_32f) {
+                    return reject("primitive without valid indices");
+                }
+
+                bool hasPosition = false, hasNormal = false;
+                for (UInt64 k = 0; k < primitive.attributes_count; k++) {
+                    const cgltf_attribute& attribute = primitive.attributes[k];
+                    if (!IsAccessorInBounds(*attribute.data)) {
+                        return reject("sparse or out of bounds vertex data");
+                    }
+
+                    // The CPU copies read the positions as they are.
+                    const bool isFloatVec3 = attribute.data->type == cgltf_type_vec3 &&
+                                             attribute.data->component_type == cgltf_component_type_r_32f;
+                    const bool isPositionOrNormal = attribute.type == cgltf_attribute_type_position ||
+                                                    attribute.type == cgltf_attribute_type_normal;
+                    if (isPositionOrNormal && !isFloatVec3) {
+                        return reject("quantized positions or normals");
+                    }
+
+                    hasPosition |= attribute.type == cgltf_attribute_type_position;
+                    hasNormal |= attribute.type == cgltf_attribute_type_normal;
+                }
+
+                // The shaders need normals and the importer is the one generating them.
+                if (!hasPosition || !hasNormal) {
+                    return reject("primitive without positions or normals");
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool GlbFile::IsAccessorInBounds(const cgltf_accessor& accessor) const {
+        if (accessor.is_sparse || !accessor.buffer_view || accessor.count == 0) {
+            return false;
+        }
+
+        const UInt64 elementSize = cgltf_num_components(accessor.type) * cgltf_component_size(accessor.component_type);
+        return accessor.offset + (accessor.count - 1) * accessor.stride + elementSize <= accessor.buffer_view->size;
+    }
+}
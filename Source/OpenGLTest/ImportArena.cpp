@@ -0,0 +1,42 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/ImportArena.hpp>
+
+#include <algorithm>
+
+namespace OGLTest {
+    TrackingMemoryResource::TrackingMemoryResource(std::pmr::memory_resource* upstream) : m_Upstream(upstream) {}
+
+    void* TrackingMemoryResource::do_allocate(const std::size_t bytes, const std::size_t alignment) {
+        void* pointer = m_Upstream->allocate(bytes, alignment);
+
+        m_Allocations.fetch_add(1, std::memory_order_relaxed);
+        const UInt64 inUse = m_Bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        UInt64 peak = m_PeakBytes.load(std::memory_order_relaxed);
+        while (inUse > peak && !m_PeakBytes.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)) {}
+
+        return pointer;
+    }
+
+    void TrackingMemoryResource::do_deallocate(void* pointer, const std::size_t bytes, const std::size_t alignment) {
+        m_Upstream->deallocate(pointer, bytes, alignment);
+        m_Bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    bool TrackingMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+        return this == &other;
+    }
+
+    ImportArena::ImportArena(const UInt64 initialSize, std::pmr::memory_resource* upstream)
+        : m_Upstream(upstream), m_BlockSize(std::max<UInt64>(initialSize, 1)),
+          m_Block(upstream->allocate(m_BlockSize, alignof(std::max_align_t))),
+          m_Monotonic(m_Block, m_BlockSize, upstream) {}
+
+    ImportArena::~ImportArena() {
+        // The overflow blocks before the one they follow.
+        m_Monotonic.release();
+        m_Upstream->deallocate(m_Block, m_BlockSize, alignof(std::max_align_t));
+    }
+}
@@ -0,0 +1,283 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/JobSystem.hpp>
+
+#include <utility>
+
+namespace OGLTest {
+    namespace {
+        // The job system the current thread owns a queue of, and the index of that queue.
+        thread_local const JobSystem* t_JobSystem = nullptr;
+        thread_local UInt32 t_QueueIndex = 0;
+    }
+
+    bool WorkStealingQueue::Push(Job* job) {
+        const Int64 bottom = m_Bottom.load(std::memory_order_relaxed);
+        const Int64 top = m_Top.load(std::memory_order_acquire);
+        if (bottom - top >= static_cast<Int64>(g_JobQueueCapacity)) {
+            return false;
+        }
+
+        m_Jobs[static_cast<UInt64>(bottom) % g_JobQueueCapacity].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    Job* WorkStealingQueue::Pop() {
+        const Int64 bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+        m_Bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Int64 top = m_Top.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job* job = m_Jobs[static_cast<UInt64>(bottom) % g_JobQueueCapacity].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // Last job, race the thieves for it.
+            if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                job = nullptr;
+            }
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return job;
+    }
+
+    Job* WorkStealingQueue::Steal() {
+        Int64 top = m_Top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const Int64 bottom = m_Bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        Job* job = m_Jobs[static_cast<UInt64>(top) % g_JobQueueCapacity].load(std::memory_order_relaxed);
+        if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+
+        return job;
+    }
+
+    JobSystem::JobSystem(const UInt32 workerCount) : m_MainThread(std::this_thread::get_id()) {
+        for (UInt32 i = 0; i < workerCount + 1; i++) {
+            m_Queues.push_back(std::make_unique<WorkStealingQueue>());
+        }
+
+        t_JobSystem = this;
+        t_QueueIndex = 0;
+
+        for (UInt32 i = 0; i < workerCount; i++) {
+            m_Workers.emplace_back(&JobSystem::WorkerMain, this, i + 1);
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard lock(m_WakeMutex);
+            m_Stop = true;
+        }
+        m_WakeCondition.notify_all();
+
+        for (auto& worker : m_Workers) {
+            worker.join();
+        }
+
+        // Jobs still queued are dropped, whoever scheduled them had to wait on their counters before this.
+        for (UInt32 i = 0; i < m_Queues.size(); i++) {
+            while (Job* job = m_Queues[i]->Steal()) {
+                delete job;
+            }
+        }
+
+        for (const Job* job : m_SharedJobs) {
+            delete job;
+        }
+
+        for (const Job* job : m_MainThreadJobs) {
+            delete job;
+        }
+
+        if (t_JobSystem == this) {
+            t_JobSystem = nullptr;
+        }
+    }
+
+    UInt32 JobSystem::GetDefaultWorkerCount() {
+        const UInt32 cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 0;
+    }
+
+    void JobSystem::Schedule(std::function<void()> function, JobCounter* counter, JobCounter* dependency,
+                             const JobAffinity affinity) {
+        Job* job = new Job{std::move(function), counter, affinity};
+
+        if (counter) {
+            std::lock_guard lock(counter->m_Mutex);
+            counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (dependency) {
+            std::lock_guard lock(dependency->m_Mutex);
+            if (dependency->m_Pending.load(std::memory_order_relaxed) != 0) {
+                dependency->m_Continuations.push_back(job);
+                return;
+            }
+        }
+
+        Enqueue(job);
+    }
+
+    void JobSystem::Wait(JobCounter& counter) {
+        const UInt32 queueIndex = GetQueueIndex();
+
+        while (!counter.IsDone()) {
+            Job* job = IsMainThread() ? PopMainThreadJob() : nullptr;
+            if (!job) {
+                job = FindJob(queueIndex);
+            }
+
+            if (job) {
+                Execute(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        // The last job may still be unlocking the counter.
+        std::lock_guard lock(counter.m_Mutex);
+    }
+
+    void JobSystem::RunMainThreadJobs() {
+        while (Job* job = PopMainThreadJob()) {
+            Execute(job);
+        }
+    }
+
+    JobStats JobSystem::GetStats() const {
+        return JobStats{m_ExecutedJobs.load(std::memory_order_relaxed), m_StolenJobs.load(std::memory_order_relaxed)};
+    }
+
+    void JobSystem::WorkerMain(const UInt32 queueIndex) {
+        t_JobSystem = this;
+        t_QueueIndex = queueIndex;
+
+        while (!m_Stop) {
+            if (Job* job = FindJob(queueIndex)) {
+                Execute(job);
+                continue;
+            }
+
+            std::unique_lock lock(m_WakeMutex);
+            m_SleepingWorkers++;
+            m_WakeCondition.wait(lock, [&]() {
+                return m_Stop || m_QueuedJobs.load() > 0;
+            });
+            m_SleepingWorkers--;
+        }
+    }
+
+    UInt32 JobSystem::GetQueueIndex() const {
+        return t_JobSystem == this ? t_QueueIndex : g_NoQueue;
+    }
+
+    void JobSystem::Enqueue(Job* job) {
+        if (job->Affinity == JobAffinity::MainThread) {
+            std::lock_guard lock(m_MainThreadMutex);
+            m_MainThreadJobs.push_back(job);
+            return;
+        }
+
+        m_QueuedJobs++;
+
+        const UInt32 queueIndex = GetQueueIndex();
+        if (queueIndex == g_NoQueue || !m_Queues[queueIndex]->Push(job)) {
+            std::lock_guard lock(m_SharedMutex);
+            m_SharedJobs.push_back(job);
+        }
+
+        // Taking the lock orders the notification after a worker that is going to sleep started waiting.
+        if (m_SleepingWorkers.load() > 0) {
+            { std::lock_guard lock(m_WakeMutex); }
+            m_WakeCondition.notify_one();
+        }
+    }
+
+    Job* JobSystem::FindJob(const UInt32 queueIndex) {
+        Job* job = nullptr;
+
+        if (queueIndex != g_NoQueue) {
+            job = m_Queues[queueIndex]->Pop();
+        }
+
+        if (!job) {
+            std::lock_guard lock(m_SharedMutex);
+            if (!m_SharedJobs.empty()) {
+                job = m_SharedJobs.front();
+                m_SharedJobs.pop_front();
+            }
+        }
+
+        if (!job) {
+            // Start after our own queue so the thieves spread over the victims.
+            const UInt32 start = queueIndex == g_NoQueue ? 0 : queueIndex + 1;
+            for (UInt32 i = 0; i < m_Queues.size() && !job; i++) {
+                const UInt32 victim = (start + i) % static_cast<UInt32>(m_Queues.size());
+                if (victim != queueIndex) {
+                    job = m_Queues[victim]->Steal();
+                }
+            }
+
+            if (job) {
+                m_StolenJobs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (job) {
+            m_QueuedJobs--;
+        }
+
+        return job;
+    }
+
+    Job* JobSystem::PopMainThreadJob() {
+        std::lock_guard lock(m_MainThreadMutex);
+        if (m_MainThreadJobs.empty()) {
+            return nullptr;
+        }
+
+        // Oldest first, a job may schedule follow-up work for the main thread.
+        Job* job = m_MainThreadJobs.front();
+        m_MainThreadJobs.pop_front();
+        return job;
+    }
+
+    void JobSystem::Execute(Job* job) {
+        job->Function();
+        m_ExecutedJobs.fetch_add(1, std::memory_order_relaxed);
+
+        if (JobCounter* counter = job->Counter) {
+            std::vector<Job*> continuations;
+            {
+                std::lock_guard lock(counter->m_Mutex);
+                if (counter->m_Pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    continuations.swap(counter->m_Continuations);
+                }
+            }
+
+            for (Job* continuation : continuations) {
+                Enqueue(continuation);
+            }
+        }
+
+        delete job;
+    }
+}
@@ -0,0 +1,103 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/MappedFile.hpp>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace OGLTest {
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+#ifdef _WIN32
+    bool MappedFile::Open(const std::filesystem::path& path) {
+        Close();
+
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!data) {
+            if (mapping) {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+            return false;
+        }
+
+        m_File = file;
+        m_Mapping = mapping;
+        m_Data = static_cast<const UInt8*>(data);
+        m_Size = static_cast<UInt64>(size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (m_Data) {
+            UnmapViewOfFile(m_Data);
+            CloseHandle(m_Mapping);
+            CloseHandle(m_File);
+        }
+
+        m_Data = nullptr;
+        m_Size = 0;
+        m_File = m_Mapping = nullptr;
+    }
+#else
+    bool MappedFile::Open(const std::filesystem::path& path) {
+        Close();
+
+        const int file = open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            return false;
+        }
+
+        struct stat status;
+        if (fstat(file, &status) != 0 || status.st_size == 0) {
+            close(file);
+            return false;
+        }
+
+        // The mapping stays valid once the descriptor is closed.
+        void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+
+        m_Data = static_cast<const UInt8*>(data);
+        m_Size = static_cast<UInt64>(status.st_size);
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (m_Data) {
+            munmap(const_cast<UInt8*>(m_Data), m_Size);
+        }
+
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+#endif
+}
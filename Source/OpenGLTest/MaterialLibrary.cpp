@@ -0,0 +1,341 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/MaterialLibrary.hpp>
+
+#include <OpenGLTest/GLCapture.hpp>
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace OGLTest {
+    namespace {
+        void GetFormats(const Int32 channels, GLenum& internalFormat, GLenum& format) {
+            switch (channels) {
+            case 1:
+                {
+                    internalFormat = GL_R8;
+                    format = GL_RED;
+                    break;
+                }
+            case 3:
+                {
+                    internalFormat = GL_RGB8;
+                    format = GL_RGB;
+                    break;
+                }
+            default:
+                {
+                    internalFormat = GL_RGBA8;
+                    format = GL_RGBA;
+                    break;
+                }
+            }
+        }
+    }
+
+    MaterialLibrary::MaterialLibrary(const bool useBindless) : m_Bindless(useBindless && IsBindlessSupported()) {
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &m_MaxLayers);
+    }
+
+    MaterialLibrary::~MaterialLibrary() {
+        for (const auto& image : m_PendingImages) {
+            stbi_image_free(image.Pixels);
+        }
+
+        for (const auto& [key, image] : m_DecodedImages) {
+            stbi_image_free(image.Pixels);
+        }
+
+        for (const auto& array : m_Arrays) {
+#if defined(GL_ARB_bindless_texture)
+            if (array.Handle != 0) {
+                glMakeTextureHandleNonResidentARB(array.Handle);
+            }
+#endif
+            if (array.Id != 0) {
+                glDeleteTextures(1, &array.Id);
+            }
+        }
+
+        if (m_MaterialBuffer != 0) {
+            glDeleteBuffers(1, &m_MaterialBuffer);
+        }
+
+        if (m_HandleBuffer != 0) {
+            glDeleteBuffers(1, &m_HandleBuffer);
+        }
+    }
+
+    bool MaterialLibrary::IsBindlessSupported() {
+        // The handles live in a shader storage buffer, core since GL 4.3. The capture doesn't record the handles.
+#if defined(GL_ARB_bindless_texture) && defined(GL_SHADER_STORAGE_BUFFER)
+        return GLAD_GL_ARB_bindless_texture && !GLCapture::IsRecording() && (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3));
+#else
+        return false;
+#endif
+    }
+
+    void MaterialLibrary::DecodeTextures(const std::span<const std::filesystem::path> paths, JobSystem& jobs) {
+        std::vector<std::string> keys;
+        for (const auto& path : paths) {
+            std::string key = path.lexically_normal().string();
+            if (!m_TextureRefs.contains(key) && !m_DecodedImages.contains(key) &&
+                std::find(keys.begin(), keys.end(), key) == keys.end()) {
+                keys.push_back(std::move(key));
+            }
+        }
+
+        // stb_image keeps no state between calls besides the flip flag, which is only read here.
+        std::vector<DecodedImage> images(keys.size());
+        jobs.ParallelFor(0, keys.size(), 1, [&](const UInt64 first, const UInt64 last) {
+            for (UInt64 i = first; i < last; i++) {
+                images[i] = DecodeImage(keys[i]);
+            }
+        });
+
+        for (UInt64 i = 0; i < keys.size(); i++) {
+            m_DecodedImages.emplace(std::move(keys[i]), images[i]);
+        }
+    }
+
+    TextureRef MaterialLibrary::AddTexture(const std::filesystem::path& path) {
+        if (m_Built) {
+            std::cerr << "Can't add textures to a built material library: " << path << '\n';
+            return TextureRef{};
+        }
+
+        const std::string key = path.lexically_normal().string();
+        if (const auto it = m_TextureRefs.find(key); it != m_TextureRefs.end()) {
+            return it->second;
+        }
+
+        DecodedImage image;
+        if (const auto it = m_DecodedImages.find(key); it != m_DecodedImages.end()) {
+            image = it->second;
+            m_DecodedImages.erase(it);
+        } else {
+            image = DecodeImage(key);
+        }
+
+        return AddDecodedImage(key, image);
+    }
+
+    TextureRef MaterialLibrary::AddEmbeddedTexture(const std::string& name, const std::span<const UInt8> encoded,
+                                                   const bool flipRows) {
+        if (m_Built) {
+            std::cerr << "Can't add textures to a built material library: " << name << '\n';
+            return TextureRef{};
+        }
+
+        if (const auto it = m_TextureRefs.find(name); it != m_TextureRefs.end()) {
+            return it->second;
+        }
+
+        DecodedImage image = DecodeImage(encoded);
+        if (image.Pixels && flipRows) {
+            const UInt64 rowSize = static_cast<UInt64>(image.Width) * image.Channels;
+            for (Int32 y = 0; y < image.Height / 2; y++) {
+                std::swap_ranges(image.Pixels + y * rowSize, image.Pixels + (y + 1) * rowSize,
+                                 image.Pixels + (image.Height - 1 - y) * rowSize);
+            }
+        }
+
+        return AddDecodedImage(name, image);
+    }
+
+    UInt32 MaterialLibrary::AddMaterial(const TextureRef diffuse, const TextureRef specular, const TextureRef shininess) {
+        if (m_Built || m_Materials.size() >= g_MaxMaterials) {
+            std::cerr << "Can't add more materials to the library." << '\n';
+            return g_InvalidMaterial;
+        }
+
+        m_Materials.push_back({diffuse, specular, shininess, TextureRef{}});
+        return static_cast<UInt32>(m_Materials.size() - 1);
+    }
+
+    void MaterialLibrary::Build() {
+        if (m_Built) {
+            return;
+        }
+        m_Built = true;
+
+        // Rows of 1 and 3 channel images aren't 4-byte aligned.
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (auto& array : m_Arrays) {
+            GLenum internalFormat, format;
+            GetFormats(array.Channels, internalFormat, format);
+
+            glGenTextures(1, &array.Id);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array.Id);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, static_cast<GLint>(internalFormat), array.Width, array.Height,
+                         array.LayerCount, 0, format, GL_UNSIGNED_BYTE, nullptr);
+
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            // The full mipmap chain adds about a third to the base level.
+            m_GpuBytes += static_cast<UInt64>(array.Width) * array.Height * array.Channels * array.LayerCount * 4 / 3;
+        }
+
+        for (const auto& image : m_PendingImages) {
+            const TextureArray& array = m_Arrays[image.Ref.Array];
+            GLenum internalFormat, format;
+            GetFormats(array.Channels, internalFormat, format);
+
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array.Id);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, image.Ref.Layer, array.Width, array.Height, 1, format,
+                            GL_UNSIGNED_BYTE, image.Pixels);
+            stbi_image_free(image.Pixels);
+        }
+        m_PendingImages.clear();
+        m_PendingImages.shrink_to_fit();
+
+        for (auto& array : m_Arrays) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array.Id);
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        }
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        // The block is always allocated at full size, its declaration in the shader has a fixed length.
+        std::vector<MaterialData> materials(g_MaxMaterials);
+        std::copy(m_Materials.begin(), m_Materials.end(), materials.begin());
+
+        glGenBuffers(1, &m_MaterialBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_MaterialBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(materials.size() * sizeof(MaterialData)),
+                     materials.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+#if defined(GL_ARB_bindless_texture) && defined(GL_SHADER_STORAGE_BUFFER)
+        if (m_Bindless && !m_Arrays.empty()) {
+            std::vector<GLuint64> handles;
+            handles.reserve(m_Arrays.size());
+
+            for (auto& array : m_Arrays) {
+                array.Handle = glGetTextureHandleARB(array.Id);
+                glMakeTextureHandleResidentARB(array.Handle);
+                handles.push_back(array.Handle);
+            }
+
+            glGenBuffers(1, &m_HandleBuffer);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_HandleBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(handles.size() * sizeof(GLuint64)),
+                         handles.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+#endif
+    }
+
+    void MaterialLibrary::ConfigureShader(const Shader& shader) const {
+        shader.Use();
+        shader.BindUniformBlock("Materials", g_MaterialsBinding);
+
+        // The bindless shader declares the binding of its storage block itself.
+        if (!m_Bindless) {
+            for (UInt32 i = 0; i < g_MaxTextureArrays; i++) {
+                shader.Set("textureArrays[" + std::to_string(i) + "]", static_cast<Int32>(g_TextureArrayFirstUnit + i));
+            }
+        }
+    }
+
+    void MaterialLibrary::Bind() const {
+        glBindBufferBase(GL_UNIFORM_BUFFER, g_MaterialsBinding, m_MaterialBuffer);
+
+#if defined(GL_ARB_bindless_texture) && defined(GL_SHADER_STORAGE_BUFFER)
+        if (m_Bindless) {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_TextureHandlesBinding, m_HandleBuffer);
+            return;
+        }
+#endif
+
+        for (UInt32 i = 0; i < m_Arrays.size(); i++) {
+            glActiveTexture(GL_TEXTURE0 + g_TextureArrayFirstUnit + i);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_Arrays[i].Id);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    MaterialLibrary::DecodedImage MaterialLibrary::DecodeImage(const std::span<const UInt8> encoded) {
+        DecodedImage image;
+        const Int32 size = static_cast<Int32>(encoded.size());
+        image.Pixels = stbi_load_from_memory(encoded.data(), size, &image.Width, &image.Height, &image.Channels, 0);
+
+        if (image.Pixels && image.Channels == 2) {
+            stbi_image_free(image.Pixels);
+            image.Pixels = stbi_load_from_memory(encoded.data(), size, &image.Width, &image.Height, &image.Channels, 4);
+            image.Channels = 4;
+        }
+
+        return image;
+    }
+
+    TextureRef MaterialLibrary::AddDecodedImage(const std::string& key, const DecodedImage& image) {
+        if (!image.Pixels) {
+            std::cerr << "Failed to load texture: " << key << '\n';
+            m_TextureRefs.emplace(key, TextureRef{});
+            return TextureRef{};
+        }
+
+        const TextureRef ref = AllocateLayer(image.Width, image.Height, image.Channels);
+        if (!ref.IsValid()) {
+            std::cerr << "No texture array left for " << image.Width << "x" << image.Height << " images: " << key
+                      << '\n';
+            stbi_image_free(image.Pixels);
+        } else {
+            m_PendingImages.push_back({image.Pixels, ref});
+        }
+
+        m_TextureRefs.emplace(key, ref);
+        return ref;
+    }
+
+    MaterialLibrary::DecodedImage MaterialLibrary::DecodeImage(const std::string& path) {
+        DecodedImage image;
+        image.Pixels = stbi_load(path.c_str(), &image.Width, &image.Height, &image.Channels, 0);
+
+        // Two channel images aren't expected, they're expanded instead of getting a format of their own.
+        if (image.Pixels && image.Channels == 2) {
+            stbi_image_free(image.Pixels);
+            image.Pixels = stbi_load(path.c_str(), &image.Width, &image.Height, &image.Channels, 4);
+            image.Channels = 4;
+        }
+
+        return image;
+    }
+
+    TextureRef MaterialLibrary::AllocateLayer(const Int32 width, const Int32 height, const Int32 channels) {
+        // The last array of a kind is the only one that can still have free layers.
+        for (auto it = m_Arrays.rbegin(); it != m_Arrays.rend(); ++it) {
+            if (it->Width != width || it->Height != height || it->Channels != channels) {
+                continue;
+            }
+
+            if (it->LayerCount < m_MaxLayers) {
+                const Int32 arrayIndex = static_cast<Int32>(std::distance(m_Arrays.begin(), it.base()) - 1);
+                return TextureRef{arrayIndex, it->LayerCount++};
+            }
+            break;
+        }
+
+        if (!m_Bindless && m_Arrays.size() >= g_MaxTextureArrays) {
+            return TextureRef{};
+        }
+
+        TextureArray& array = m_Arrays.emplace_back();
+        array.Width = width;
+        array.Height = height;
+        array.Channels = channels;
+        array.LayerCount = 1;
+
+        return TextureRef{static_cast<Int32>(m_Arrays.size() - 1), 0};
+    }
+}
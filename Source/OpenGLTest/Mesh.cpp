@@ -4,11 +4,154 @@
 
 #include <OpenGLTest/Mesh.hpp>
 
+#include <utility>
+
 namespace OGLTest {
-    Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<UInt32>& indices,
-               const std::vector<Texture>& textures)
-        : m_Vertices(vertices), m_Indices(indices), m_Textures(textures) {
+    Mesh::Mesh(std::vector<Vertex>&& vertices, std::vector<UInt32>&& indices, const UInt32 materialIndex,
+               const MeshCpuData cpuData)
+        : m_Vertices(std::move(vertices)), m_Indices(std::move(indices)), m_MaterialIndex(materialIndex),
+          m_VertexCount(static_cast<UInt32>(m_Vertices.size())), m_IndexCount(static_cast<UInt32>(m_Indices.size())),
+          m_IndexType(m_VertexCount <= g_MaxShortIndexVertices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT) {
         SetupMesh();
+        m_GpuBytes = static_cast<UInt64>(m_VertexCount) * sizeof(Vertex) +
+                     static_cast<UInt64>(m_IndexCount) * GetIndexSize();
+
+        m_Positions.reserve(m_Vertices.size());
+        for (const auto& vertex : m_Vertices) {
+            m_Positions.push_back(vertex.Position);
+            m_Bounds.Extend(vertex.Position);
+        }
+
+        if (cpuData != MeshCpuData::None) {
+            BuildBvh();
+        }
+
+        ReleaseCpuData(cpuData);
+    }
+
+    Mesh::Mesh(const MeshBufferLayout& layout, std::vector<glm::vec3>&& positions, std::vector<UInt32>&& indices,
+               const BoundingBox& bounds, const UInt32 materialIndex, const MeshCpuData cpuData)
+        : m_Positions(std::move(positions)), m_Indices(std::move(indices)), m_MaterialIndex(materialIndex),
+          m_VertexCount(layout.VertexCount), m_IndexCount(layout.IndexCount), m_IndexType(layout.IndexType),
+          m_IndexOffset(layout.IndexOffset), m_GpuBytes(layout.GpuBytes), m_Bounds(bounds) {
+        glGenVertexArrays(1, &m_VAO);
+        glBindVertexArray(m_VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, layout.IndexBuffer);
+
+        for (UInt32 location = 0; location < layout.Attributes.size(); location++) {
+            const VertexAttributeLayout& attribute = layout.Attributes[location];
+            if (attribute.Buffer == 0) {
+                continue;
+            }
+
+            glBindBuffer(GL_ARRAY_BUFFER, attribute.Buffer);
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, attribute.Components, attribute.Type,
+                                  attribute.Normalized ? GL_TRUE : GL_FALSE, attribute.Stride,
+                                  reinterpret_cast<const void*>(attribute.Offset));
+        }
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        if (cpuData != MeshCpuData::None && !m_Positions.empty() && !m_Indices.empty()) {
+            BuildBvh();
+        }
+
+        ReleaseCpuData(cpuData);
+    }
+
+    Mesh::~Mesh() {
+        DeleteBuffers();
+    }
+
+    Mesh::Mesh(Mesh&& other) noexcept
+        : m_Vertices(std::move(other.m_Vertices)), m_Positions(std::move(other.m_Positions)),
+          m_Indices(std::move(other.m_Indices)), m_MaterialIndex(other.m_MaterialIndex),
+          m_VertexCount(other.m_VertexCount), m_IndexCount(other.m_IndexCount), m_IndexType(other.m_IndexType),
+          m_IndexOffset(other.m_IndexOffset), m_GpuBytes(other.m_GpuBytes), m_VAO(std::exchange(other.m_VAO, 0)),
+          m_VBO(std::exchange(other.m_VBO, 0)), m_EBO(std::exchange(other.m_EBO, 0)), m_Bounds(other.m_Bounds),
+          m_Bvh(std::move(other.m_Bvh)) {}
+
+    Mesh& Mesh::operator=(Mesh&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+
+        DeleteBuffers();
+
+        m_Vertices = std::move(other.m_Vertices);
+        m_Positions = std::move(other.m_Positions);
+        m_Indices = std::move(other.m_Indices);
+        m_MaterialIndex = other.m_MaterialIndex;
+        m_VertexCount = other.m_VertexCount;
+        m_IndexCount = other.m_IndexCount;
+        m_IndexType = other.m_IndexType;
+        m_IndexOffset = other.m_IndexOffset;
+        m_GpuBytes = other.m_GpuBytes;
+        m_VAO = std::exchange(other.m_VAO, 0);
+        m_VBO = std::exchange(other.m_VBO, 0);
+        m_EBO = std::exchange(other.m_EBO, 0);
+        m_Bounds = other.m_Bounds;
+        m_Bvh = std::move(other.m_Bvh);
+
+        return *this;
+    }
+
+    MemoryUsage Mesh::GetMemoryUsage() const {
+        MemoryUsage usage;
+        usage.CpuBytes = m_Vertices.capacity() * sizeof(Vertex) + m_Positions.capacity() * sizeof(glm::vec3) +
+                         m_Indices.capacity() * sizeof(UInt32) + m_Bvh.GetMemoryUsage();
+        usage.GpuBytes = m_GpuBytes;
+
+        return usage;
+    }
+
+    void Mesh::ReleaseCpuData(const MeshCpuData keep) {
+        // Swapping with an empty vector actually gives the memory back, clear() would keep the capacity.
+        if (keep != MeshCpuData::All) {
+            std::vector<Vertex>().swap(m_Vertices);
+        }
+
+        if (keep == MeshCpuData::None) {
+            std::vector<glm::vec3>().swap(m_Positions);
+            std::vector<UInt32>().swap(m_Indices);
+            m_Bvh = Bvh{};
+        }
+    }
+
+    Float32 Mesh::Raycast(const Ray& ray, UInt32& triangleIndex, const Float32 maxDistance) const {
+        return m_Bvh.Raycast(ray, [&](const UInt32 triangle, const Float32 closest) {
+            const Float32 distance = IntersectRayTriangle(ray, m_Positions[m_Indices[triangle * 3]],
+                                                          m_Positions[m_Indices[triangle * 3 + 1]],
+                                                          m_Positions[m_Indices[triangle * 3 + 2]]);
+            if (distance < closest) {
+                triangleIndex = triangle;
+            }
+
+            return distance;
+        }, maxDistance);
+    }
+
+    void Mesh::RasterizeOccluder(SoftwareOcclusionBuffer& buffer, const glm::mat4& modelViewProjection) const {
+        if (m_Positions.empty()) {
+            return;
+        }
+
+        buffer.RasterizeIndexed(modelViewProjection, m_Positions.data(), sizeof(glm::vec3),
+                                static_cast<UInt32>(m_Positions.size()), m_Indices);
+    }
+
+    void Mesh::BuildBvh() {
+        std::vector<BoundingBox> triangleBounds(m_Indices.size() / 3);
+
+        for (UInt64 i = 0; i < triangleBounds.size(); i++) {
+            triangleBounds[i].Extend(m_Positions[m_Indices[i * 3]]);
+            triangleBounds[i].Extend(m_Positions[m_Indices[i * 3 + 1]]);
+            triangleBounds[i].Extend(m_Positions[m_Indices[i * 3 + 2]]);
+        }
+
+        m_Bvh.Build(triangleBounds);
     }
 
     void Mesh::SetupMesh() {
@@ -22,7 +165,14 @@ namespace OGLTest {
         glBufferData(GL_ARRAY_BUFFER, m_Vertices.size() * sizeof(Vertex), m_Vertices.data(), GL_STATIC_DRAW);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Indices.size() * sizeof(UInt32), m_Indices.data(), GL_STATIC_DRAW);
+        if (m_IndexType == GL_UNSIGNED_SHORT) {
+            // Halves the index buffer, the narrowed copy only lives until the upload.
+            const std::vector<UInt16> shortIndices(m_Indices.begin(), m_Indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(UInt16), shortIndices.data(),
+                         GL_STATIC_DRAW);
+        } else {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Indices.size() * sizeof(UInt32), m_Indices.data(), GL_STATIC_DRAW);
+        }
 
         // Vertex positions
         glEnableVertexAttribArray(0);
@@ -37,45 +187,30 @@ namespace OGLTest {
         glBindVertexArray(0);
     }
 
-    void Mesh::Draw(Shader& shader) {
-        UInt32 diffuseNr = 1;
-        UInt32 specularNr = 1;
-        UInt32 shininessNr = 1;
-
-        for (UInt32 i = 0; i < m_Textures.size(); i++) {
-            glActiveTexture(GL_TEXTURE0 + i);
-            std::string number;
-            std::string name;
-            switch (m_Textures[i].Type) {
-            case TextureType::Diffuse:
-                {
-                    number = std::to_string(diffuseNr++);
-                    name = "texture_diffuse";
-                    break;
-                }
-            case TextureType::Specular:
-                {
-                    number = std::to_string(specularNr++);
-                    name = "texture_specular";
-                    break;
-                }
-            case TextureType::Shininess:
-                {
-                    number = std::to_string(shininessNr++);
-                    name = "texture_sininess";
-                    break;
-                }
-            }
+    void Mesh::DeleteBuffers() {
+        // The buffers of a mesh over the caller's buffers aren't ours, only the vertex array is.
+        if (m_VAO != 0) {
+            glDeleteVertexArrays(1, &m_VAO);
+        }
 
-            shader.Set(("material." + name + number), static_cast<Int32>(i));
-            glBindTexture(GL_TEXTURE_2D, m_Textures[i].Id);
+        if (m_VBO != 0) {
+            glDeleteBuffers(1, &m_VBO);
         }
-        glActiveTexture(GL_TEXTURE0);
 
-        // Draw mesh
+        if (m_EBO != 0) {
+            glDeleteBuffers(1, &m_EBO);
+        }
+
+        m_VAO = m_VBO = m_EBO = 0;
+    }
+
+    void Mesh::Draw(Shader& shader) {
+        // The textures are layers of the arrays bound once by the material library, only the material changes.
+        shader.Set("materialIndex", static_cast<Int32>(m_MaterialIndex));
+
         glBindVertexArray(m_VAO);
-        glDrawElements(GL_TRIANGLES, m_Indices.size(), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_IndexCount), m_IndexType,
+                       reinterpret_cast<const void*>(m_IndexOffset));
         glBindVertexArray(0);
     }
-
 }
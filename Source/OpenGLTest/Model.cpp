@@ -3,129 +3,761 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <OpenGLTest/Model.hpp>
-#include <OpenGLTest/TextureUtils.hpp>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <memory_resource>
+#include <string_view>
+
 namespace OGLTest {
+    namespace {
+        static_assert(sizeof(Vertex) == 8 * sizeof(Float32), "The weld key covers every vertex attribute");
+
+        // 64-bit words: the epsilon cells of coordinates in the tens of thousands don't fit in 32 bits.
+        using WeldKey = std::array<UInt64, 8>;
+
+        UInt64 HashWeldKey(const WeldKey& key) {
+            // FNV-1a over the attribute words.
+            UInt64 hash = 14695981039346656037ull;
+            for (const UInt64 word : key) {
+                hash = (hash ^ word) * 1099511628211ull;
+            }
+            return hash;
+        }
+
+        UInt64 QuantizeWeldValue(const Float32 value) {
+            // Clamped so that huge, infinite or NaN values can't overflow the integer conversion.
+            constexpr Float64 limit = 9.0e18;
+            const Float64 cell = std::round(static_cast<Float64>(value) / static_cast<Float64>(g_WeldEpsilon));
+            return static_cast<UInt64>(std::isnan(cell) ? Int64{0}
+                                                        : static_cast<Int64>(std::clamp(cell, -limit, limit)));
+        }
+
+        WeldKey MakeWeldKey(const Vertex& vertex, const VertexWelding welding) {
+            const std::array<Float32, 8> values = {
+                vertex.Position.x, vertex.Position.y, vertex.Position.z,
+                vertex.Normal.x, vertex.Normal.y, vertex.Normal.z,
+                vertex.UVs.x, vertex.UVs.y
+            };
+
+            WeldKey key;
+            for (UInt32 i = 0; i < values.size(); i++) {
+                if (welding == VertexWelding::Epsilon) {
+                    // Cell coordinates instead of bits, two values closer than the epsilon may still land in
+                    // neighbouring cells but the lookup stays a single hash probe.
+                    key[i] = QuantizeWeldValue(values[i]);
+                } else {
+                    // Adding zero turns -0 into +0.
+                    key[i] = std::bit_cast<UInt32>(values[i] + 0.0f);
+                }
+            }
+
+            return key;
+        }
+
+        // Open addressing table of vertex indices, at most half full.
+        UInt64 GetWeldTableSize(const UInt32 vertexCount) {
+            return std::bit_ceil(std::max<UInt64>(static_cast<UInt64>(vertexCount) * 2, 2));
+        }
+
+        // Upper bound of the scratch memory ProcessMesh needs for a mesh, alignment padding included.
+        UInt64 GetImportScratchSize(const aiMesh* mesh, const VertexWelding welding) {
+            if (welding == VertexWelding::Disabled) {
+                return 0;
+            }
+
+            const UInt64 vertexCount = mesh->mNumVertices;
+            return vertexCount * (sizeof(WeldKey) + sizeof(UInt32)) +
+                   GetWeldTableSize(mesh->mNumVertices) * sizeof(UInt32) + 3 * alignof(std::max_align_t);
+        }
+
+        Vertex ReadVertex(const aiMesh* mesh, const UInt32 i) {
+            Vertex vertex;
+            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+            vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+
+            // Check if the mesh has UVs
+            if (mesh->mTextureCoords[0]) {
+                vertex.UVs = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+            } else {
+                vertex.UVs = glm::vec2(0.0f, 0.0f);
+            }
+
+            return vertex;
+        }
+
+        GLenum GetGltfComponentType(const cgltf_component_type type) {
+            switch (type) {
+            case cgltf_component_type_r_8:
+                {
+                    return GL_BYTE;
+                }
+            case cgltf_component_type_r_8u:
+                {
+                    return GL_UNSIGNED_BYTE;
+                }
+            case cgltf_component_type_r_16:
+                {
+                    return GL_SHORT;
+                }
+            case cgltf_component_type_r_16u:
+                {
+                    return GL_UNSIGNED_SHORT;
+                }
+            case cgltf_component_type_r_32u:
+                {
+                    return GL_UNSIGNED_INT;
+                }
+            default:
+                {
+                    return GL_FLOAT;
+                }
+            }
+        }
+
+        UInt64 GetGeometryBytes(const UInt32 vertexCount, const UInt32 indexCount) {
+            const UInt64 indexSize = vertexCount <= g_MaxShortIndexVertices ? sizeof(UInt16) : sizeof(UInt32);
+            return static_cast<UInt64>(vertexCount) * sizeof(Vertex) + static_cast<UInt64>(indexCount) * indexSize;
+        }
+    }
+
+    RayHit Model::Raycast(const Ray& ray) const {
+        RayHit hit;
+
+        hit.Distance = m_Bvh.Raycast(ray, [&](const UInt32 meshIndex, const Float32 closest) {
+            // Meshes are tested in their own space, the ray direction isn't renormalized so distances stay comparable.
+            const Ray localRay = ray.Transform(glm::inverse(m_SceneGraph.GetWorldTransform(m_MeshNodes[meshIndex])));
+
+            UInt32 triangleIndex;
+            const Float32 distance = m_Meshes[meshIndex].Raycast(localRay, triangleIndex, closest);
+            if (distance < closest) {
+                hit.MeshIndex = meshIndex;
+                hit.TriangleIndex = triangleIndex;
+            }
+
+            return distance;
+        });
+
+        return hit;
+    }
+
+    void Model::QueryFrustum(const Frustum& frustum, std::vector<UInt32>& meshIndices) const {
+        m_Bvh.QueryFrustum(frustum, m_Jobs, meshIndices);
+    }
+
+    MemoryUsage Model::GetMemoryUsage() const {
+        MemoryUsage usage;
+        usage.CpuBytes = m_Meshes.capacity() * sizeof(Mesh) + m_MeshWorldBounds.capacity() * sizeof(BoundingBox) +
+                         m_Bvh.GetMemoryUsage();
+
+        for (const auto& mesh : m_Meshes) {
+            usage += mesh.GetMemoryUsage();
+        }
+
+        usage.GpuBytes += m_Materials.GetGpuBytes();
+
+        return usage;
+    }
+
+    bool Model::HasDynamicMeshesIn(const Frustum& frustum) const {
+        if (m_DynamicMeshCount == 0) {
+            return false;
+        }
+
+        for (UInt32 i = 0; i < GetMeshCount(); i++) {
+            if (IsMeshDynamic(i) && frustum.Intersects(m_MeshWorldBounds[i])) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool Model::Update() {
+        if (!m_SceneGraph.UpdateWorldTransforms()) {
+            return false;
+        }
+
+        const bool staticMeshMoved = UpdateMeshWorldBounds();
+        m_Bvh.Refit(m_MeshWorldBounds);
+
+        return staticMeshMoved;
+    }
+
     void Model::Draw(Shader& shader) {
-        for (auto& mesh : m_Meshes) {
-            mesh.Draw(shader);
+        for (UInt32 i = 0; i < GetMeshCount(); i++) {
+            DrawMesh(shader, i);
+        }
+    }
+
+    void Model::Draw(Shader& shader, const Frustum& frustum) {
+        m_VisibleMeshes.clear();
+        QueryFrustum(frustum, m_VisibleMeshes);
+
+        for (const UInt32 meshIndex : m_VisibleMeshes) {
+            DrawMesh(shader, meshIndex);
+        }
+    }
+
+    void Model::DrawMesh(Shader& shader, const UInt32 meshIndex) {
+        shader.Set("model", GetMeshTransform(meshIndex));
+        m_Meshes[meshIndex].Draw(shader);
+    }
+
+    void Model::DrawShadowCasters(Shader& shader, const Frustum& frustum, const bool dynamic) {
+        if (dynamic && m_DynamicMeshCount == 0) {
+            return;
+        }
+
+        m_VisibleMeshes.clear();
+        QueryFrustum(frustum, m_VisibleMeshes);
+
+        for (const UInt32 meshIndex : m_VisibleMeshes) {
+            if (IsMeshDynamic(meshIndex) == dynamic) {
+                DrawMesh(shader, meshIndex);
+            }
+        }
+    }
+
+    bool Model::UpdateMeshWorldBounds() {
+        m_MeshWorldBounds.resize(m_Meshes.size());
+        m_MeshWorldTransforms.resize(m_Meshes.size(), glm::mat4(0.0f));
+        m_DynamicMeshes.resize(m_Meshes.size(), 0);
+
+        std::atomic<bool> staticMeshMoved = false;
+        m_Jobs.ParallelFor(0, m_Meshes.size(), 64, [&](const UInt64 first, const UInt64 last) {
+            bool moved = false;
+            for (UInt64 i = first; i < last; i++) {
+                const glm::mat4& transform = m_SceneGraph.GetWorldTransform(m_MeshNodes[i]);
+                m_MeshWorldBounds[i] = m_Meshes[i].GetBounds().Transform(transform);
+
+                if (m_MeshWorldTransforms[i] != transform) {
+                    m_MeshWorldTransforms[i] = transform;
+                    moved |= m_DynamicMeshes[i] == 0;
+                }
+            }
+
+            if (moved) {
+                staticMeshMoved.store(true, std::memory_order_relaxed);
+            }
+        });
+
+        return staticMeshMoved;
+    }
+
+    Model::~Model() {
+        for (const GLuint buffer : m_GltfBuffers) {
+            if (buffer != 0) {
+                glDeleteBuffers(1, &buffer);
+            }
         }
     }
 
     void Model::LoadModel(const std::filesystem::path& path) {
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](const char c) {
+            return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        });
+
+        bool loaded = m_Settings.UseNativeGltf && extension == ".glb" && LoadGlb(path);
+        if (!loaded) {
+            loaded = LoadWithAssimp(path);
+        }
+
+        if (!loaded) {
+            return;
+        }
+
+        m_SceneGraph.UpdateWorldTransforms();
+
+        UpdateMeshWorldBounds();
+        m_Bvh.Build(m_MeshWorldBounds);
+    }
+
+    bool Model::LoadWithAssimp(const std::filesystem::path& path) {
         Assimp::Importer importer;
         const aiScene* scene = importer.ReadFile(path.string(), aiProcess_Triangulate | aiProcess_FlipUVs);
 
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
             std::cerr << "Couldn't import model at path: " << path << "\nError: " << importer.GetErrorString() << '\n';
-            return;
+            return false;
         }
         m_Directory = path.string().substr(0, path.string().find_last_of('/'));
 
-        ProcessNode(scene->mRootNode, scene);
+        // The textures are decoded while the meshes are converted, the GL uploads run on this thread once both are
+        // done, while it waits.
+        std::vector<MeshGeometry> geometries(scene->mNumMeshes);
+        // Upstream of the mesh conversion temporaries, to compare the arena with plain heap allocations.
+        TrackingMemoryResource scratchTracker;
+        JobCounter prepared, uploaded;
+
+        m_Jobs.Schedule([&]() {
+            LoadMaterials(scene);
+        }, &prepared);
+        m_Jobs.Schedule([&]() {
+            m_Jobs.ParallelFor(0, geometries.size(), 1, [&](const UInt64 first, const UInt64 last) {
+                if (!m_Settings.UseImportArena) {
+                    for (UInt64 i = first; i < last; i++) {
+                        geometries[i] = ProcessMesh(scene->mMeshes[i], m_Settings.Welding, &scratchTracker);
+                    }
+                    return;
+                }
+
+                // One arena per batch, sized for its largest mesh and reset between the meshes.
+                UInt64 scratchSize = 0;
+                for (UInt64 i = first; i < last; i++) {
+                    scratchSize = std::max(scratchSize, GetImportScratchSize(scene->mMeshes[i], m_Settings.Welding));
+                }
+
+                ImportArena arena{scratchSize, &scratchTracker};
+                for (UInt64 i = first; i < last; i++) {
+                    geometries[i] = ProcessMesh(scene->mMeshes[i], m_Settings.Welding, arena.GetResource());
+                    arena.Reset();
+                }
+            });
+        }, &prepared);
+        m_Jobs.Schedule([&]() {
+            ProcessNode(scene->mRootNode, m_RootNode, geometries);
+            m_Materials.Build();
+        }, &uploaded, &prepared, JobAffinity::MainThread);
+
+        m_Jobs.Wait(uploaded);
+
+        m_ImportStats.reserve(geometries.size());
+        for (const MeshGeometry& geometry : geometries) {
+            m_ImportStats.push_back(geometry.Stats);
+        }
+        m_ScratchAllocations = scratchTracker.GetStats();
+
+        return true;
     }
 
-    void Model::ProcessNode(const aiNode* node, const aiScene* scene) {
+    void Model::ProcessNode(const aiNode* node, const NodeId parent, std::vector<MeshGeometry>& geometries) {
+        // Assimp matrices are row-major, glm ones are column-major.
+        const glm::mat4 localTransform = glm::transpose(glm::make_mat4(&node->mTransformation.a1));
+        const NodeId nodeId = m_SceneGraph.AddNode(parent, localTransform);
+
         // process all the node's meshes (if any)
         for (UInt32 i = 0; i < node->mNumMeshes; i++) {
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            m_Meshes.push_back(ProcessMesh(mesh, scene));
+            MeshGeometry& geometry = geometries[node->mMeshes[i]];
+            const UInt32 materialIndex = geometry.SceneMaterial < m_MaterialIndices.size()
+                                             ? m_MaterialIndices[geometry.SceneMaterial]
+                                             : g_InvalidMaterial;
+
+            if (geometry.Used) {
+                std::vector<Vertex> vertices = geometry.Vertices;
+                std::vector<UInt32> indices = geometry.Indices;
+                m_Meshes.emplace_back(std::move(vertices), std::move(indices), materialIndex, m_Settings.CpuData);
+            } else {
+                m_Meshes.emplace_back(std::move(geometry.Vertices), std::move(geometry.Indices), materialIndex,
+                                      m_Settings.CpuData);
+                geometry.Used = true;
+            }
+            m_MeshNodes.push_back(nodeId);
         }
 
-        // Then do the same for each of its children
+        // Then do the same for each of its children, the recursion keeps parents before their children
         for (UInt32 i = 0; i < node->mNumChildren; i++) {
-            ProcessNode(node->mChildren[i], scene);
+            ProcessNode(node->mChildren[i], nodeId, geometries);
         }
     }
 
-    Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
-        std::vector<Vertex> vertices;
-        std::vector<UInt32> indices;
-        std::vector<Texture> textures;
+    Model::MeshGeometry Model::ProcessMesh(const aiMesh* mesh, const VertexWelding welding,
+                                           std::pmr::memory_resource* scratch) {
+        MeshGeometry geometry;
+        std::vector<Vertex>& vertices = geometry.Vertices;
+        std::vector<UInt32>& indices = geometry.Indices;
 
-        for (UInt32 i = 0; i < mesh->mNumVertices; i++) {
-            Vertex vertex;
+        const UInt32 vertexCount = mesh->mNumVertices;
+        UInt64 indexCount = 0;
+        for (UInt32 i = 0; i < mesh->mNumFaces; i++) {
+            indexCount += mesh->mFaces[i].mNumIndices;
+        }
 
-            glm::vec3 vector;
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
+        // remap[i] is the welded index of vertex i, the first vertex of each group keeps its place in the order.
+        std::pmr::vector<UInt32> remap(scratch);
+        UInt32 uniqueCount = vertexCount;
+        if (welding != VertexWelding::Disabled) {
+            // The keys are kept to compare the vertices landing in the same slot.
+            std::pmr::vector<WeldKey> keys(vertexCount, scratch);
+            std::pmr::vector<UInt32> table(GetWeldTableSize(vertexCount), ~0u, scratch);
+            const UInt64 mask = table.size() - 1;
+            remap.resize(vertexCount);
+            uniqueCount = 0;
 
-            vector.x = mesh->mNormals[i].x;
-            vector.y = mesh->mNormals[i].y;
-            vector.z = mesh->mNormals[i].z;
-            vertex.Normal = vector;
+            for (UInt32 i = 0; i < vertexCount; i++) {
+                keys[i] = MakeWeldKey(ReadVertex(mesh, i), welding);
 
-            // Check if the mesh has UVs
-            if (mesh->mTextureCoords[0]) {
-                glm::vec2 vec;
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.UVs = vec;
-            } else {
-                vertex.UVs = glm::vec2(0.0f, 0.0f);
+                UInt64 slot = HashWeldKey(keys[i]) & mask;
+                while (table[slot] != ~0u && keys[table[slot]] != keys[i]) {
+                    slot = (slot + 1) & mask;
+                }
+
+                if (table[slot] == ~0u) {
+                    table[slot] = i;
+                    remap[i] = uniqueCount++;
+                } else {
+                    remap[i] = remap[table[slot]];
+                }
             }
+        }
+
+        // Exact sizes, the vectors are moved into the mesh as they are.
+        vertices.reserve(uniqueCount);
+        indices.reserve(indexCount);
 
-            vertices.push_back(vertex);
+        for (UInt32 i = 0; i < vertexCount; i++) {
+            if (remap.empty() || remap[i] == vertices.size()) {
+                vertices.push_back(ReadVertex(mesh, i));
+            }
         }
 
         for (UInt32 i = 0; i < mesh->mNumFaces; i++) {
-            aiFace face = mesh->mFaces[i];
+            const aiFace& face = mesh->mFaces[i];
 
             for (UInt32 j = 0; j < face.mNumIndices; j++) {
-                indices.push_back(face.mIndices[j]);
+                indices.push_back(remap.empty() ? face.mIndices[j] : remap[face.mIndices[j]]);
             }
         }
 
-        if (mesh->mMaterialIndex >= 0) {
-            aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-            std::vector<Texture> diffuseMaps = LoadMaterialTextures(material, aiTextureType_DIFFUSE,
-                                                                    TextureType::Diffuse);
-            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        geometry.SceneMaterial = mesh->mMaterialIndex;
 
-            std::vector<Texture> specularMaps = LoadMaterialTextures(material, aiTextureType_SPECULAR,
-                                                                     TextureType::Specular);
-            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        MeshImportStats& stats = geometry.Stats;
+        stats.VerticesBefore = vertexCount;
+        stats.VerticesAfter = uniqueCount;
+        stats.IndexCount = static_cast<UInt32>(indexCount);
+        stats.BytesBefore = GetGeometryBytes(stats.VerticesBefore, stats.IndexCount);
+        stats.BytesAfter = GetGeometryBytes(stats.VerticesAfter, stats.IndexCount);
 
-            std::vector<Texture> shininessMaps = LoadMaterialTextures(material, aiTextureType_SHININESS,
-                                                                      TextureType::Shininess);
-            textures.insert(textures.end(), shininessMaps.begin(), shininessMaps.end());
+        return geometry;
+    }
+
+    void Model::LoadMaterials(const aiScene* scene) {
+        m_MaterialIndices.reserve(scene->mNumMaterials);
+
+        std::vector<std::filesystem::path> texturePaths;
+        for (UInt32 i = 0; i < scene->mNumMaterials; i++) {
+            for (const aiTextureType type : {aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_SHININESS}) {
+                if (scene->mMaterials[i]->GetTextureCount(type) > 0) {
+                    aiString path;
+                    scene->mMaterials[i]->GetTexture(type, 0, &path);
+                    texturePaths.push_back(std::filesystem::path(m_Directory) / path.C_Str());
+                }
+            }
+        }
+        m_Materials.DecodeTextures(texturePaths, m_Jobs);
+
+        for (UInt32 i = 0; i < scene->mNumMaterials; i++) {
+            const aiMaterial* material = scene->mMaterials[i];
+
+            m_MaterialIndices.push_back(m_Materials.AddMaterial(LoadMaterialTexture(material, aiTextureType_DIFFUSE),
+                                                                LoadMaterialTexture(material, aiTextureType_SPECULAR),
+                                                                LoadMaterialTexture(material, aiTextureType_SHININESS)));
+        }
+    }
+
+    TextureRef Model::LoadMaterialTexture(const aiMaterial* material, const aiTextureType type) {
+        // A material only has one texture of each kind, additional layers aren't supported by the shaders.
+        if (material->GetTextureCount(type) == 0) {
+            return TextureRef{};
         }
 
-        return Mesh{vertices, indices, textures};
+        aiString path;
+        material->GetTexture(type, 0, &path);
+
+        return m_Materials.AddTexture(std::filesystem::path(m_Directory) / path.C_Str());
     }
 
-    std::vector<Texture> Model::LoadMaterialTextures(aiMaterial* mat, aiTextureType type, TextureType textureType) {
-        std::vector<Texture> textures;
+    bool Model::LoadGlb(const std::filesystem::path& path) {
+        GlbFile file;
+        if (!file.Open(path)) {
+            std::cerr << "Falling back to Assimp for " << path << '\n';
+            return false;
+        }
+        m_Directory = path.parent_path().string();
 
-        for (UInt32 i = 0; i < mat->GetTextureCount(type); i++) {
-            aiString str;
-            mat->GetTexture(type, i, &str);
-            bool skip = false;
+        const cgltf_data& data = file.GetData();
+        std::vector<GltfPrimitive> primitives;
+        // The primitives of mesh i are [firstPrimitives[i], firstPrimitives[i + 1]).
+        std::vector<UInt32> firstPrimitives(data.meshes_count + 1);
+        for (UInt64 i = 0; i < data.meshes_count; i++) {
+            firstPrimitives[i] = static_cast<UInt32>(primitives.size());
+            for (UInt64 j = 0; j < data.meshes[i].primitives_count; j++) {
+                primitives.emplace_back().Primitive = &data.meshes[i].primitives[j];
+            }
+        }
+        firstPrimitives[data.meshes_count] = static_cast<UInt32>(primitives.size());
+
+        // Same scheduling as the Assimp path, only the CPU copies for the queries are read on the workers.
+        JobCounter prepared, uploaded;
+
+        m_Jobs.Schedule([&]() {
+            LoadGltfMaterials(file, path);
+        }, &prepared);
+        m_Jobs.Schedule([&]() {
+            m_Jobs.ParallelFor(0, primitives.size(), 1, [&](const UInt64 first, const UInt64 last) {
+                for (UInt64 i = first; i < last; i++) {
+                    ReadGltfPrimitive(file, primitives[i], m_Settings.CpuData);
+                }
+            });
+        }, &prepared);
+        m_Jobs.Schedule([&]() {
+            UploadGltfBuffers(file);
 
-            for (UInt64 j = 0; j < m_LoadedTextures.size(); j++) {
-                if (std::strcmp(m_LoadedTextures[j].Path.data(), str.C_Str()) == 0) {
-                    textures.push_back(m_LoadedTextures[j]);
-                    skip = true;
-                    break;
+            // Without a default scene, every root node is drawn.
+            const cgltf_scene* scene = data.scene ? data.scene : (data.scenes_count > 0 ? &data.scenes[0] : nullptr);
+            if (scene) {
+                for (UInt64 i = 0; i < scene->nodes_count; i++) {
+                    ProcessGltfNode(data, *scene->nodes[i], m_RootNode, primitives, firstPrimitives);
+                }
+            } else {
+                for (UInt64 i = 0; i < data.nodes_count; i++) {
+                    if (!data.nodes[i].parent) {
+                        ProcessGltfNode(data, data.nodes[i], m_RootNode, primitives, firstPrimitives);
+                    }
                 }
             }
 
-            if (!skip) {
-                Texture texture;
-                texture.Id = LoadTextureFromFile(str.C_Str(), m_Directory);
-                texture.Type = textureType;
-                texture.Path = str.C_Str();
-                textures.push_back(texture);
-                m_LoadedTextures.push_back(texture);
+            m_Materials.Build();
+        }, &uploaded, &prepared, JobAffinity::MainThread);
+
+        m_Jobs.Wait(uploaded);
+
+        m_ImportStats.reserve(primitives.size());
+        for (const GltfPrimitive& primitive : primitives) {
+            m_ImportStats.push_back(primitive.Stats);
+        }
+
+        return true;
+    }
+
+    void Model::LoadGltfMaterials(const GlbFile& file, const std::filesystem::path& path) {
+        const cgltf_data& data = file.GetData();
+        m_MaterialIndices.reserve(data.materials_count);
+
+        // Only the base color maps to the materials of the shaders, as their diffuse texture.
+        for (UInt64 i = 0; i < data.materials_count; i++) {
+            const cgltf_material& material = data.materials[i];
+            const cgltf_texture* texture = material.has_pbr_metallic_roughness
+                                               ? material.pbr_metallic_roughness.base_color_texture.texture
+                                               : nullptr;
+
+            const TextureRef diffuse = texture && texture->image ? LoadGltfTexture(file, *texture->image, path)
+                                                                 : TextureRef{};
+            m_MaterialIndices.push_back(m_Materials.AddMaterial(diffuse, TextureRef{}, TextureRef{}));
+        }
+    }
+
+    TextureRef Model::LoadGltfTexture(const GlbFile& file, const cgltf_image& image,
+                                      const std::filesystem::path& path) {
+        // The glTF UVs are uploaded as they are, with their top-left origin, so the rows are put back in file order.
+        if (image.buffer_view) {
+            const std::string name = path.string() + "#image" + std::to_string(&image - file.GetData().images);
+            return m_Materials.AddEmbeddedTexture(name, file.GetBufferView(*image.buffer_view), true);
+        }
+
+        if (!image.uri || std::string_view(image.uri).starts_with("data:")) {
+            std::cerr << "Unsupported glTF image in " << path << '\n';
+            return TextureRef{};
+        }
+
+        const std::filesystem::path imagePath = (std::filesystem::path(m_Directory) / image.uri).lexically_normal();
+        MappedFile imageFile;
+        if (!imageFile.Open(imagePath)) {
+            std::cerr << "Failed to load texture at path: " << imagePath << '\n';
+            return TextureRef{};
+        }
+
+        return m_Materials.AddEmbeddedTexture(imagePath.string(), imageFile.GetData(), true);
+    }
+
+    void Model::UploadGltfBuffers(const GlbFile& file) {
+        const cgltf_data& data = file.GetData();
+        m_GltfBuffers.assign(data.buffer_views_count, 0);
+
+        const auto upload = [&](const cgltf_accessor& accessor) {
+            GLuint& buffer = m_GltfBuffers[accessor.buffer_view - data.buffer_views];
+            if (buffer != 0) {
+                return;
+            }
+
+            // Straight from the mapped file, the driver copies the view without any conversion on our side.
+            const std::span<const UInt8> bytes = file.GetBufferView(*accessor.buffer_view);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes.size()), bytes.data(), GL_STATIC_DRAW);
+        };
+
+        // No vertex array is bound, the element array binding stays untouched.
+        glBindVertexArray(0);
+        for (UInt64 i = 0; i < data.meshes_count; i++) {
+            for (UInt64 j = 0; j < data.meshes[i].primitives_count; j++) {
+                const cgltf_primitive& primitive = data.meshes[i].primitives[j];
+                upload(*primitive.indices);
+
+                for (UInt64 k = 0; k < primitive.attributes_count; k++) {
+                    upload(*primitive.attributes[k].data);
+                }
+            }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    MeshBufferLayout Model::GetGltfLayout(const cgltf_data& data, const cgltf_primitive& primitive) const {
+        MeshBufferLayout layout;
+
+        for (UInt64 i = 0; i < primitive.attributes_count; i++) {
+            const cgltf_attribute& attribute = primitive.attributes[i];
+            const cgltf_accessor& accessor = *attribute.data;
+
+            UInt32 location;
+            if (attribute.type == cgltf_attribute_type_position) {
+                location = 0;
+                layout.VertexCount = static_cast<UInt32>(accessor.count);
+            } else if (attribute.type == cgltf_attribute_type_normal) {
+                location = 1;
+            } else if (attribute.type == cgltf_attribute_type_texcoord && attribute.index == 0) {
+                location = 2;
+            } else {
+                continue;
+            }
+
+            VertexAttributeLayout& target = layout.Attributes[location];
+            target.Buffer = m_GltfBuffers[accessor.buffer_view - data.buffer_views];
+            target.Components = static_cast<GLint>(cgltf_num_components(accessor.type));
+            target.Type = GetGltfComponentType(accessor.component_type);
+            target.Normalized = accessor.normalized;
+            target.Stride = static_cast<GLsizei>(accessor.buffer_view->stride);
+            target.Offset = accessor.offset;
+
+            layout.GpuBytes += accessor.count * cgltf_num_components(accessor.type) *
+                               cgltf_component_size(accessor.component_type);
+        }
+
+        const cgltf_accessor& indices = *primitive.indices;
+        layout.IndexBuffer = m_GltfBuffers[indices.buffer_view - data.buffer_views];
+        layout.IndexType = GetGltfComponentType(indices.component_type);
+        layout.IndexOffset = indices.offset;
+        layout.IndexCount = static_cast<UInt32>(indices.count);
+        layout.GpuBytes += indices.count * cgltf_component_size(indices.component_type);
+
+        return layout;
+    }
+
+    void Model::ProcessGltfNode(const cgltf_data& data, const cgltf_node& node, const NodeId parent,
+                                std::vector<GltfPrimitive>& primitives, const std::span<const UInt32> firstPrimitives) {
+        // Column-major, like glm.
+        glm::mat4 localTransform;
+        cgltf_node_transform_local(&node, glm::value_ptr(localTransform));
+        const NodeId nodeId = m_SceneGraph.AddNode(parent, localTransform);
+
+        if (node.mesh) {
+            const UInt64 meshIndex = node.mesh - data.meshes;
+            for (UInt32 i = firstPrimitives[meshIndex]; i < firstPrimitives[meshIndex + 1]; i++) {
+                GltfPrimitive& primitive = primitives[i];
+                const cgltf_material* material = primitive.Primitive->material;
+                const UInt32 materialIndex = material ? m_MaterialIndices[material - data.materials]
+                                                      : g_InvalidMaterial;
+                const MeshBufferLayout layout = GetGltfLayout(data, *primitive.Primitive);
+
+                // The GL buffers are shared by the instances, only the CPU copies are duplicated.
+                if (primitive.Used) {
+                    std::vector<glm::vec3> positions = primitive.Positions;
+                    std::vector<UInt32> indices = primitive.Indices;
+                    m_Meshes.emplace_back(layout, std::move(positions), std::move(indices), primitive.Bounds,
+                                          materialIndex, m_Settings.CpuData);
+                } else {
+                    m_Meshes.emplace_back(layout, std::move(primitive.Positions), std::move(primitive.Indices),
+                                          primitive.Bounds, materialIndex, m_Settings.CpuData);
+                    primitive.Stats.BytesBefore = primitive.Stats.BytesAfter = layout.GpuBytes;
+                    primitive.Used = true;
+                }
+                m_MeshNodes.push_back(nodeId);
+            }
+        }
+
+        for (UInt64 i = 0; i < node.children_count; i++) {
+            ProcessGltfNode(data, *node.children[i], nodeId, primitives, firstPrimitives);
+        }
+    }
+
+    void Model::ReadGltfPrimitive(const GlbFile& file, GltfPrimitive& primitive, const MeshCpuData cpuData) {
+        const cgltf_accessor* position = nullptr;
+        for (UInt64 i = 0; i < primitive.Primitive->attributes_count && !position; i++) {
+            if (primitive.Primitive->attributes[i].type == cgltf_attribute_type_position) {
+                position = primitive.Primitive->attributes[i].data;
+            }
+        }
+        const cgltf_accessor& indices = *primitive.Primitive->indices;
+
+        // The bounds are stored in the file, the positions are only read when the queries need them.
+        const bool hasBounds = position->has_min && position->has_max;
+        if (hasBounds) {
+            primitive.Bounds.Extend(glm::vec3(position->min[0], position->min[1], position->min[2]));
+            primitive.Bounds.Extend(glm::vec3(position->max[0], position->max[1], position->max[2]));
+        }
+
+        if (cpuData != MeshCpuData::None || !hasBounds) {
+            std::vector<glm::vec3>& positions = primitive.Positions;
+            positions.resize(position->count);
+
+            const UInt8* source = file.GetAccessorData(*position);
+            if (position->stride == sizeof(glm::vec3)) {
+                std::memcpy(positions.data(), source, positions.size() * sizeof(glm::vec3));
+            } else {
+                for (UInt64 i = 0; i < positions.size(); i++) {
+                    std::memcpy(&positions[i], source + i * position->stride, sizeof(glm::vec3));
+                }
+            }
+
+            if (!hasBounds) {
+                for (const glm::vec3& vertex : positions) {
+                    primitive.Bounds.Extend(vertex);
+                }
+            }
+        }
+
+        if (cpuData != MeshCpuData::None) {
+            std::vector<UInt32>& cpuIndices = primitive.Indices;
+            cpuIndices.resize(indices.count);
+
+            const UInt8* source = file.GetAccessorData(indices);
+            for (UInt64 i = 0; i < cpuIndices.size(); i++) {
+                const UInt8* element = source + i * indices.stride;
+                switch (indices.component_type) {
+                case cgltf_component_type_r_8u:
+                    {
+                        cpuIndices[i] = *element;
+                        break;
+                    }
+                case cgltf_component_type_r_16u:
+                    {
+                        UInt16 index;
+                        std::memcpy(&index, element, sizeof(index));
+                        cpuIndices[i] = index;
+                        break;
+                    }
+                default:
+                    {
+                        std::memcpy(&cpuIndices[i], element, sizeof(UInt32));
+                        break;
+                    }
+                }
             }
         }
 
-        return textures;
+        MeshImportStats& stats = primitive.Stats;
+        stats.VerticesBefore = stats.VerticesAfter = static_cast<UInt32>(position->count);
+        stats.IndexCount = static_cast<UInt32>(indices.count);
     }
 }
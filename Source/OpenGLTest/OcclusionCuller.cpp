@@ -0,0 +1,235 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/OcclusionCuller.hpp>
+
+#include <algorithm>
+
+namespace OGLTest {
+    namespace {
+        // Boxes closer than this to the camera are always drawn, their faces could be clipped by the near plane.
+        constexpr Float32 g_NearMargin = 0.1f;
+
+        bool ContainsCamera(const BoundingBox& box, const glm::vec3& cameraPosition) {
+            const glm::vec3 margin(g_NearMargin);
+            const glm::vec3 min = box.Min - margin;
+            const glm::vec3 max = box.Max + margin;
+
+            return cameraPosition.x >= min.x && cameraPosition.y >= min.y && cameraPosition.z >= min.z &&
+                   cameraPosition.x <= max.x && cameraPosition.y <= max.y && cameraPosition.z <= max.z;
+        }
+    }
+
+    OcclusionCuller::OcclusionCuller(const OcclusionMode mode)
+        : m_Mode(mode), m_QueryTarget(GL_ANY_SAMPLES_PASSED),
+          m_BoxShader("Resources/Shaders/occlusion.vert", "Resources/Shaders/occlusion.frag") {
+        // The conservative variant may report false positives but is cheaper to evaluate (GL 4.3 / ES 3 compatibility).
+#ifdef GL_ANY_SAMPLES_PASSED_CONSERVATIVE
+        if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3)) {
+            m_QueryTarget = GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+        }
+#endif
+
+        SetupBox();
+    }
+
+    OcclusionCuller::~OcclusionCuller() {
+        for (const auto& state : m_MeshStates) {
+            if (state.Query != 0) {
+                glDeleteQueries(1, &state.Query);
+            }
+        }
+
+        glDeleteVertexArrays(1, &m_BoxVAO);
+        glDeleteBuffers(1, &m_BoxVBO);
+        glDeleteBuffers(1, &m_BoxEBO);
+    }
+
+    void OcclusionCuller::Draw(Model& model, Shader& shader, const glm::mat4& projection, const glm::mat4& view,
+                               const glm::vec3& cameraPosition) {
+        const glm::mat4 viewProjection = projection * view;
+
+        m_Stats = OcclusionStats{};
+        m_MeshStates.resize(model.GetMeshCount());
+
+        m_Candidates.clear();
+        model.QueryFrustum(Frustum::FromMatrix(viewProjection), m_Candidates);
+        m_Stats.Candidates = static_cast<UInt32>(m_Candidates.size());
+
+        switch (m_Mode) {
+        case OcclusionMode::Disabled:
+            {
+                shader.Use();
+                for (const UInt32 meshIndex : m_Candidates) {
+                    model.DrawMesh(shader, meshIndex);
+                }
+                break;
+            }
+        case OcclusionMode::Hardware:
+            {
+                DrawHardware(model, shader, viewProjection, cameraPosition);
+                break;
+            }
+        case OcclusionMode::Software:
+            {
+                DrawSoftware(model, shader, viewProjection, cameraPosition);
+                break;
+            }
+        }
+    }
+
+    void OcclusionCuller::DrawHardware(Model& model, Shader& shader, const glm::mat4& viewProjection,
+                                       const glm::vec3& cameraPosition) {
+        // 1. Collect last frame's results without waiting, a pending query keeps the previous visibility.
+        for (const UInt32 meshIndex : m_Candidates) {
+            MeshState& state = m_MeshStates[meshIndex];
+
+            if (ContainsCamera(model.GetMeshWorldBounds(meshIndex), cameraPosition)) {
+                state.Visible = true;
+                continue;
+            }
+
+            if (!state.Pending) {
+                continue;
+            }
+
+            GLint available = 0;
+            glGetQueryObjectiv(state.Query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint anySamplesPassed = 0;
+                glGetQueryObjectuiv(state.Query, GL_QUERY_RESULT, &anySamplesPassed);
+                state.Visible = anySamplesPassed != 0;
+                state.Pending = false;
+            }
+        }
+
+        // 2. Draw what was visible last frame, it fills the depth buffer with the likely occluders.
+        shader.Use();
+        for (const UInt32 meshIndex : m_Candidates) {
+            if (m_MeshStates[meshIndex].Visible) {
+                model.DrawMesh(shader, meshIndex);
+            }
+        }
+
+        // 3. Test every bounding box against that depth buffer, without touching the color or depth attachments.
+        m_BoxShader.Use();
+        m_BoxShader.Set("viewProj", viewProjection);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        glBindVertexArray(m_BoxVAO);
+
+        for (const UInt32 meshIndex : m_Candidates) {
+            MeshState& state = m_MeshStates[meshIndex];
+            const BoundingBox& bounds = model.GetMeshWorldBounds(meshIndex);
+
+            if (state.Pending || ContainsCamera(bounds, cameraPosition)) {
+                continue;
+            }
+
+            if (state.Query == 0) {
+                glGenQueries(1, &state.Query);
+            }
+
+            m_BoxShader.Set("boxMin", bounds.Min);
+            m_BoxShader.Set("boxMax", bounds.Max);
+
+            glBeginQuery(m_QueryTarget, state.Query);
+            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, nullptr);
+            glEndQuery(m_QueryTarget);
+
+            state.Pending = true;
+            m_Stats.Tested++;
+        }
+
+        glBindVertexArray(0);
+        glDepthMask(GL_TRUE);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+        // 4. Meshes hidden last frame may have become visible. With conditional rendering the GPU decides from the
+        // query issued above (or draws anyway if it isn't done), so nothing pops in and the CPU never waits.
+        shader.Use();
+        for (const UInt32 meshIndex : m_Candidates) {
+            const MeshState& state = m_MeshStates[meshIndex];
+
+            if (state.Visible) {
+                continue;
+            }
+
+            m_Stats.Occluded++;
+
+            if (m_UseConditionalRender && state.Query != 0) {
+                glBeginConditionalRender(state.Query, GL_QUERY_NO_WAIT);
+                model.DrawMesh(shader, meshIndex);
+                glEndConditionalRender();
+            }
+        }
+    }
+
+    void OcclusionCuller::DrawSoftware(Model& model, Shader& shader, const glm::mat4& viewProjection,
+                                       const glm::vec3& cameraPosition) {
+        // Front to back, so the nearest meshes are rasterized before the ones they may hide are tested.
+        std::sort(m_Candidates.begin(), m_Candidates.end(), [&](const UInt32 lhs, const UInt32 rhs) {
+            const glm::vec3 lhsOffset = model.GetMeshWorldBounds(lhs).GetCenter() - cameraPosition;
+            const glm::vec3 rhsOffset = model.GetMeshWorldBounds(rhs).GetCenter() - cameraPosition;
+            return glm::dot(lhsOffset, lhsOffset) < glm::dot(rhsOffset, rhsOffset);
+        });
+
+        m_SoftwareBuffer.Clear();
+        shader.Use();
+
+        for (const UInt32 meshIndex : m_Candidates) {
+            m_Stats.Tested++;
+
+            if (!m_SoftwareBuffer.IsVisible(model.GetMeshWorldBounds(meshIndex), viewProjection)) {
+                m_MeshStates[meshIndex].Visible = false;
+                m_Stats.Occluded++;
+                continue;
+            }
+
+            m_MeshStates[meshIndex].Visible = true;
+            model.DrawMesh(shader, meshIndex);
+            model.GetMesh(meshIndex).RasterizeOccluder(m_SoftwareBuffer,
+                                                       viewProjection * model.GetMeshTransform(meshIndex));
+        }
+    }
+
+    void OcclusionCuller::SetupBox() {
+        // Unit cube, stretched over each bounding box by the vertex shader.
+        constexpr Float32 corners[] = {
+            0.0f, 0.0f, 0.0f,
+            1.0f, 0.0f, 0.0f,
+            0.0f, 1.0f, 0.0f,
+            1.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 1.0f,
+            1.0f, 0.0f, 1.0f,
+            0.0f, 1.0f, 1.0f,
+            1.0f, 1.0f, 1.0f,
+        };
+
+        constexpr UInt8 indices[] = {
+            0, 2, 1, 1, 2, 3, // -Z
+            4, 5, 6, 5, 7, 6, // +Z
+            0, 4, 2, 2, 4, 6, // -X
+            1, 3, 5, 3, 7, 5, // +X
+            0, 1, 4, 1, 5, 4, // -Y
+            2, 6, 3, 3, 6, 7, // +Y
+        };
+
+        glGenVertexArrays(1, &m_BoxVAO);
+        glGenBuffers(1, &m_BoxVBO);
+        glGenBuffers(1, &m_BoxEBO);
+
+        glBindVertexArray(m_BoxVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_BoxVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_BoxEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(Float32), (void*)0);
+
+        glBindVertexArray(0);
+    }
+}
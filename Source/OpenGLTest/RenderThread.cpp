@@ -0,0 +1,148 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/RenderThread.hpp>
+
+namespace OGLTest {
+    namespace {
+        Float64 ToMilliseconds(const FrameClock::duration duration) {
+            return std::chrono::duration<Float64, std::milli>(duration).count();
+        }
+    }
+
+    RenderThread::RenderThread(GLFWwindow* window, ExecuteFunction execute, const bool threaded)
+        : m_Window(window), m_Execute(std::move(execute)), m_Threaded(threaded) {
+        if (m_Threaded) {
+            // A context can only be current on one thread at a time.
+            glfwMakeContextCurrent(nullptr);
+            m_Thread = std::thread(&RenderThread::ThreadMain, this);
+        }
+    }
+
+    RenderThread::~RenderThread() {
+        Stop();
+    }
+
+    FrameSnapshot& RenderThread::BeginFrame() {
+        const FrameClock::time_point start = FrameClock::now();
+
+        if (m_Threaded) {
+            std::unique_lock lock(m_Mutex);
+            m_SlotChanged.wait(lock, [&]() {
+                return m_SlotStates[m_WriteIndex] == SlotState::Free;
+            });
+            m_SlotStates[m_WriteIndex] = SlotState::Recording;
+        }
+
+        m_WaitTime = FrameClock::now() - start;
+
+        FrameSnapshot& snapshot = m_Snapshots[m_WriteIndex];
+        snapshot.Commands.Clear();
+
+        return snapshot;
+    }
+
+    void RenderThread::Submit() {
+        const FrameSnapshot& snapshot = m_Snapshots[m_WriteIndex];
+        const Float64 mainCpuMs = ToMilliseconds(FrameClock::now() - snapshot.FrameStart - m_WaitTime);
+
+        {
+            std::lock_guard lock(m_Mutex);
+            m_MainCpuMs += mainCpuMs;
+            m_SubmittedFrames++;
+
+            if (m_Threaded) {
+                m_SlotStates[m_WriteIndex] = SlotState::Submitted;
+            }
+        }
+
+        if (!m_Threaded) {
+            Present(snapshot);
+            return;
+        }
+
+        m_SlotChanged.notify_all();
+        m_WriteIndex ^= 1;
+    }
+
+    void RenderThread::Stop() {
+        if (!m_Threaded) {
+            return;
+        }
+
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_SlotChanged.notify_all();
+        m_Thread.join();
+
+        glfwMakeContextCurrent(m_Window);
+        m_Threaded = false;
+        m_SlotStates = {SlotState::Free, SlotState::Free};
+    }
+
+    FrameTimings RenderThread::ConsumeTimings() {
+        std::lock_guard lock(m_Mutex);
+
+        FrameTimings timings;
+        timings.FrameCount = m_PresentedFrames;
+        if (m_SubmittedFrames > 0) {
+            timings.MainCpuMs = static_cast<Float32>(m_MainCpuMs / m_SubmittedFrames);
+        }
+        if (m_PresentedFrames > 0) {
+            timings.RenderCpuMs = static_cast<Float32>(m_RenderCpuMs / m_PresentedFrames);
+            timings.InputLatencyMs = static_cast<Float32>(m_InputLatencyMs / m_PresentedFrames);
+        }
+
+        m_MainCpuMs = m_RenderCpuMs = m_InputLatencyMs = 0.0;
+        m_SubmittedFrames = m_PresentedFrames = 0;
+
+        return timings;
+    }
+
+    void RenderThread::ThreadMain() {
+        glfwMakeContextCurrent(m_Window);
+
+        while (true) {
+            {
+                std::unique_lock lock(m_Mutex);
+                m_SlotChanged.wait(lock, [&]() {
+                    return m_Stop || m_SlotStates[m_ReadIndex] == SlotState::Submitted;
+                });
+
+                if (m_Stop) {
+                    break;
+                }
+
+                m_SlotStates[m_ReadIndex] = SlotState::Executing;
+            }
+
+            Present(m_Snapshots[m_ReadIndex]);
+
+            {
+                std::lock_guard lock(m_Mutex);
+                m_SlotStates[m_ReadIndex] = SlotState::Free;
+            }
+            m_SlotChanged.notify_all();
+            m_ReadIndex ^= 1;
+        }
+
+        glfwMakeContextCurrent(nullptr);
+    }
+
+    void RenderThread::Present(const FrameSnapshot& snapshot) {
+        const FrameClock::time_point start = FrameClock::now();
+        m_Execute(snapshot);
+        const FrameClock::time_point executed = FrameClock::now();
+
+        glfwSwapBuffers(m_Window);
+        const FrameClock::time_point presented = FrameClock::now();
+
+        std::lock_guard lock(m_Mutex);
+        m_RenderCpuMs += ToMilliseconds(executed - start);
+        m_InputLatencyMs += ToMilliseconds(presented - snapshot.InputTime);
+        m_PresentedFrames++;
+    }
+}
@@ -0,0 +1,103 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/SceneGraph.hpp>
+
+#include <algorithm>
+
+namespace OGLTest {
+    NodeId SceneGraph::AddNode(const NodeId parent, const glm::mat4& localTransform) {
+        const auto node = static_cast<NodeId>(m_Parents.size());
+
+        m_Parents.push_back(parent);
+        m_Depths.push_back(parent == g_InvalidNode ? 0 : m_Depths[parent] + 1);
+        m_LocalTransforms.push_back(localTransform);
+        m_WorldTransforms.push_back(localTransform);
+        m_Dirty.push_back(1);
+
+        m_LevelsValid = false;
+        m_AnyDirty = true;
+
+        return node;
+    }
+
+    void SceneGraph::Clear() {
+        m_Parents.clear();
+        m_Depths.clear();
+        m_LocalTransforms.clear();
+        m_WorldTransforms.clear();
+        m_Dirty.clear();
+        m_LevelNodes.clear();
+        m_LevelOffsets.clear();
+        m_LevelsValid = false;
+        m_AnyDirty = false;
+    }
+
+    bool SceneGraph::UpdateWorldTransforms() {
+        if (!m_AnyDirty) {
+            return false;
+        }
+
+        if (m_ParallelFor && GetNodeCount() >= g_ParallelUpdateThreshold) {
+            UpdateParallel();
+        } else {
+            // Parents come before their children, so a forward pass sees every parent already up to date.
+            for (NodeId node = 0; node < GetNodeCount(); node++) {
+                UpdateNode(node);
+            }
+        }
+
+        std::fill(m_Dirty.begin(), m_Dirty.end(), static_cast<UInt8>(0));
+        m_AnyDirty = false;
+
+        return true;
+    }
+
+    void SceneGraph::UpdateParallel() {
+        if (!m_LevelsValid) {
+            BuildLevels();
+        }
+
+        // Nodes of the same depth never depend on each other, each level is a parallel loop. Levels smaller than the
+        // grain size run inline.
+        const std::function<void(UInt64, UInt64)> updateNodes = [this](const UInt64 first, const UInt64 last) {
+            for (UInt64 i = first; i < last; i++) {
+                UpdateNode(m_LevelNodes[i]);
+            }
+        };
+
+        for (UInt64 level = 0; level + 1 < m_LevelOffsets.size(); level++) {
+            const UInt64 begin = m_LevelOffsets[level];
+            const UInt64 end = m_LevelOffsets[level + 1];
+            if (end - begin <= g_ParallelUpdateGrainSize) {
+                updateNodes(begin, end);
+                continue;
+            }
+
+            m_ParallelFor(begin, end, g_ParallelUpdateGrainSize, updateNodes);
+        }
+    }
+
+    void SceneGraph::BuildLevels() {
+        const UInt32 maxDepth = m_Depths.empty() ? 0 : *std::max_element(m_Depths.begin(), m_Depths.end());
+
+        // Counting sort of the nodes by depth, which keeps the relative order inside a level.
+        m_LevelOffsets.assign(maxDepth + 2, 0);
+        for (const UInt32 depth : m_Depths) {
+            m_LevelOffsets[depth + 1]++;
+        }
+
+        for (UInt64 level = 1; level < m_LevelOffsets.size(); level++) {
+            m_LevelOffsets[level] += m_LevelOffsets[level - 1];
+        }
+
+        m_LevelNodes.resize(m_Parents.size());
+        std::vector<UInt32> cursor(m_LevelOffsets.begin(), m_LevelOffsets.end() - 1);
+        for (NodeId node = 0; node < GetNodeCount(); node++) {
+            m_LevelNodes[cursor[m_Depths[node]]++] = node;
+        }
+
+        m_LevelsValid = true;
+    }
+}
@@ -0,0 +1,167 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/SceneRenderer.hpp>
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+namespace OGLTest {
+    SceneRenderer::SceneRenderer(Shader& shader, Model& model, OcclusionCuller& occlusionCuller,
+                                 StreamingManager& streaming, ShadowRenderer& shadows, DynamicResolution& resolution)
+        : m_Shader(shader), m_Model(model), m_OcclusionCuller(occlusionCuller), m_Streaming(streaming),
+          m_Shadows(shadows), m_Resolution(resolution),
+          m_FrameDataBuffer(GL_UNIFORM_BUFFER, g_FrameDataRegionSize) {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        if (alignment > 0) {
+            m_UniformAlignment = static_cast<UInt64>(alignment);
+        }
+
+        m_Shader.BindUniformBlock("FrameData", g_FrameDataBinding);
+        m_Model.GetMaterials().ConfigureShader(m_Shader);
+        m_Shadows.ConfigureShader(m_Shader);
+    }
+
+    void SceneRenderer::Execute(const FrameSnapshot& snapshot) {
+        m_FrameDataBuffer.BeginFrame();
+        m_FrameDataDirty = true;
+
+        for (const RenderCommand& command : snapshot.Commands.GetCommands()) {
+            std::visit([this](const auto& typedCommand) {
+                Execute(typedCommand);
+            }, command);
+        }
+
+        m_FrameDataBuffer.EndFrame();
+
+        std::lock_guard lock(m_StatsMutex);
+        m_Stats.Occlusion = m_OcclusionCuller.GetStats();
+        m_Stats.Residency = m_Streaming.GetStats();
+        m_Stats.Shadows = m_Shadows.GetStats();
+        m_Stats.Resolution = m_Resolution.GetStats();
+        m_Stats.LastPick = m_LastPick;
+        m_Stats.PickCount = m_PickCount;
+    }
+
+    SceneStats SceneRenderer::GetStats() const {
+        std::lock_guard lock(m_StatsMutex);
+        return m_Stats;
+    }
+
+    void SceneRenderer::Execute(const ViewportCommand& command) {
+        // The scene is drawn into the scaled target until ResolveSceneCommand.
+        m_Resolution.BeginFrame(command.Width, command.Height);
+    }
+
+    void SceneRenderer::Execute(const ClearCommand& command) {
+        glClearColor(command.Color.x, command.Color.y, command.Color.z, command.Color.w);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    void SceneRenderer::Execute(const CameraCommand& command) {
+        m_Camera = command;
+
+        m_FrameData.Projection = command.Projection;
+        m_FrameData.View = command.View;
+        m_FrameData.ViewPosition = glm::vec4(command.Position, 1.0f);
+        m_FrameDataDirty = true;
+    }
+
+    void SceneRenderer::Execute(const PointLightCommand& command) {
+        m_FrameData.LightPosition = glm::vec4(command.Position, 1.0f);
+        m_FrameData.LightAmbient = glm::vec4(command.Ambient, 0.0f);
+        m_FrameData.LightDiffuse = glm::vec4(command.Diffuse, 0.0f);
+        m_FrameData.LightSpecular = glm::vec4(command.Specular, 0.0f);
+        m_FrameData.LightAttenuation = glm::vec4(command.Constant, command.Linear, command.Quadratic, 0.0f);
+        m_FrameDataDirty = true;
+
+        m_Shadows.SetPointLight(command.Position, ComputeLightRange(command.Constant, command.Linear,
+                                                                    command.Quadratic));
+    }
+
+    void SceneRenderer::Execute(const DirectionalLightCommand& command) {
+        m_FrameData.SunDirection = glm::vec4(glm::normalize(command.Direction), 0.0f);
+        m_FrameData.SunColor = glm::vec4(command.Color, 0.0f);
+        m_FrameDataDirty = true;
+
+        m_Shadows.SetDirectionalLight(command.Direction);
+    }
+
+    void SceneRenderer::Execute(const RenderShadowsCommand& command) {
+        // The cached maps only hold the static casters, they are out of date once one of them moved.
+        if (m_Model.Update()) {
+            m_Shadows.InvalidateStatic();
+        }
+
+        // The residency changes are those of the last streaming update.
+        const ResidencyStats& residency = m_Streaming.GetStats();
+        if (command.IncludeStreaming && residency.UploadsThisFrame + residency.EvictionsThisFrame > 0) {
+            m_Shadows.InvalidateStatic();
+        }
+
+        m_Shadows.Render(m_Model, command.IncludeStreaming ? &m_Streaming : nullptr, m_Camera.Projection,
+                         m_Camera.View);
+        m_Shadows.Bind();
+        m_Resolution.BindSceneTarget();
+
+        m_FrameData.SunDirection.w = static_cast<Float32>(m_Shadows.GetActiveCascadeCount());
+        m_FrameData.Shadows = m_Shadows.GetUniforms();
+        m_FrameDataDirty = true;
+    }
+
+    void SceneRenderer::Execute(const DrawModelCommand& command) {
+        // The per-mesh model matrices come from the scene graph, which is only updated here and in the shadow pass.
+        if (m_Model.Update()) {
+            m_Shadows.InvalidateStatic();
+        }
+        m_Model.BindMaterials();
+        UploadFrameData();
+
+        m_OcclusionCuller.SetMode(command.Occlusion);
+        m_OcclusionCuller.Draw(m_Model, m_Shader, m_Camera.Projection, m_Camera.View, m_Camera.Position);
+    }
+
+    void SceneRenderer::Execute(const PickCommand& command) {
+        // Published with the frame's stats, the main thread reports it.
+        m_LastPick = m_Model.Raycast(command.WorldRay);
+        m_PickCount++;
+    }
+
+    void SceneRenderer::Execute(const DrawStreamingCommand& command) {
+        OGLTEST_UNUSED(command);
+
+        m_Streaming.Update(m_Camera.Position);
+        UploadFrameData();
+
+        m_Shader.Use();
+        m_Streaming.Draw(m_Shader, Frustum::FromMatrix(m_Camera.Projection * m_Camera.View));
+    }
+
+    void SceneRenderer::Execute(const ResolveSceneCommand& command) {
+        OGLTEST_UNUSED(command);
+
+        m_Resolution.Resolve();
+    }
+
+    void SceneRenderer::UploadFrameData() {
+        if (!m_FrameDataDirty) {
+            return;
+        }
+
+        const StreamAllocation allocation = m_FrameDataBuffer.Allocate(sizeof(FrameData), m_UniformAlignment);
+        if (!allocation.IsValid()) {
+            std::cerr << "Out of frame data space, keeping the previous values." << '\n';
+            return;
+        }
+
+        std::memcpy(allocation.Data, &m_FrameData, sizeof(FrameData));
+        m_FrameDataBuffer.Flush();
+
+        glBindBufferRange(GL_UNIFORM_BUFFER, g_FrameDataBinding, m_FrameDataBuffer.GetBuffer(),
+                          static_cast<GLintptr>(allocation.Offset), static_cast<GLsizeiptr>(allocation.Size));
+        m_FrameDataDirty = false;
+    }
+}
@@ -8,6 +8,7 @@
 
 #include <fstream>
 #include <sstream>
+#include <utility>
 
 namespace OGLTest {
     Shader::Shader(const std::filesystem::path& vertexPath, const std::filesystem::path& fragmentPath) {
@@ -87,6 +88,63 @@ namespace OGLTest {
         // Delete the shaders as they're linked and no longer necessary.
         glDeleteShader(vertex);
         glDeleteShader(fragment);
+
+        // Cache the active uniform locations so Set doesn't query the driver on every draw.
+        Int32 uniformCount = 0;
+        Int32 maxNameLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+        std::string nameBuffer(static_cast<std::size_t>(maxNameLength), '\0');
+        for (Int32 i = 0; i < uniformCount; i++) {
+            GLsizei length = 0;
+            Int32 size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, static_cast<UInt32>(i), maxNameLength, &length, &size, &type, nameBuffer.data());
+
+            // Uniform block members are active but have no location.
+            const std::string name = nameBuffer.substr(0, static_cast<std::size_t>(length));
+            const Int32 location = glGetUniformLocation(ID, name.c_str());
+            if (location < 0) {
+                continue;
+            }
+            m_UniformLocations.emplace(name, location);
+
+            // Arrays are reported once as "name[0]", the other elements are looked up by index.
+            if (!name.ends_with("[0]")) {
+                continue;
+            }
+            const std::string baseName = name.substr(0, name.size() - 3);
+            m_UniformLocations.emplace(baseName, location);
+            for (Int32 element = 1; element < size; element++) {
+                const std::string elementName = baseName + "[" + std::to_string(element) + "]";
+                m_UniformLocations.emplace(elementName, glGetUniformLocation(ID, elementName.c_str()));
+            }
+        }
+    }
+
+    Shader::~Shader() {
+        if (ID != 0) {
+            glDeleteProgram(ID);
+        }
+    }
+
+    Shader::Shader(Shader&& other) noexcept
+        : ID(std::exchange(other.ID, 0)), m_UniformLocations(std::move(other.m_UniformLocations)) {}
+
+    Shader& Shader::operator=(Shader&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+
+        if (ID != 0) {
+            glDeleteProgram(ID);
+        }
+
+        ID = std::exchange(other.ID, 0);
+        m_UniformLocations = std::move(other.m_UniformLocations);
+
+        return *this;
     }
 
     void Shader::Use() const {
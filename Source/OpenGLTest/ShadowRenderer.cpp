@@ -0,0 +1,374 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/ShadowRenderer.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace OGLTest {
+    namespace {
+        constexpr Float32 g_PointShadowNear = 0.05f;
+
+        // Looking direction and up vector of each cube map face, in the GL face order.
+        const std::array<std::pair<glm::vec3, glm::vec3>, 6> g_CubeFaces{{
+            {{1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},
+            {{-1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},
+            {{0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+            {{0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}},
+            {{0.0f, 0.0f, 1.0f}, {0.0f, -1.0f, 0.0f}},
+            {{0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}}
+        }};
+
+        void SetDepthParameters(const GLenum target, const bool comparison) {
+            // The shadow textures are sampled with hardware PCF, the caches are only copied.
+            const GLint filter = comparison ? GL_LINEAR : GL_NEAREST;
+            glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filter);
+            glTexParameteri(target, GL_TEXTURE_MAG_FILTER, filter);
+
+            if (target == GL_TEXTURE_CUBE_MAP) {
+                glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            } else {
+                // Outside of a cascade is lit.
+                constexpr Float32 border[] = {1.0f, 1.0f, 1.0f, 1.0f};
+                glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+                glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+                glTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, border);
+            }
+
+            if (comparison) {
+                glTexParameteri(target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+                glTexParameteri(target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+            }
+        }
+
+        GLuint CreateDepthArray(const UInt32 resolution, const UInt32 layers, const bool comparison) {
+            GLuint texture;
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, static_cast<GLsizei>(resolution),
+                         static_cast<GLsizei>(resolution), static_cast<GLsizei>(layers), 0, GL_DEPTH_COMPONENT,
+                         GL_FLOAT, nullptr);
+            SetDepthParameters(GL_TEXTURE_2D_ARRAY, comparison);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+            return texture;
+        }
+
+        GLuint CreateDepthCube(const UInt32 resolution, const bool comparison) {
+            GLuint texture;
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+            for (UInt32 face = 0; face < 6; face++) {
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT24,
+                             static_cast<GLsizei>(resolution), static_cast<GLsizei>(resolution), 0,
+                             GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+            }
+            SetDepthParameters(GL_TEXTURE_CUBE_MAP, comparison);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+            return texture;
+        }
+
+        Float32 Snap(const Float32 value, const Float32 step) {
+            return std::floor(value / step) * step;
+        }
+    }
+
+    ShadowRenderer::ShadowRenderer(const ShadowSettings& settings)
+        : m_Settings(settings), m_DepthShader("Resources/Shaders/shadow.vert", "Resources/Shaders/shadow.frag") {
+        m_Settings.CascadeCount = std::min(m_Settings.CascadeCount, g_MaxCascades);
+
+        const UInt32 layerCount = std::max(m_Settings.CascadeCount, 1u);
+        m_CascadeCache = CreateDepthArray(m_Settings.CascadeResolution, layerCount, false);
+        m_CascadeTexture = CreateDepthArray(m_Settings.CascadeResolution, layerCount, true);
+        m_CubeCache = CreateDepthCube(m_Settings.CubeResolution, false);
+        m_CubeTexture = CreateDepthCube(m_Settings.CubeResolution, true);
+
+        // Depth only, the draw and read buffers are part of the framebuffer state so they are set once.
+        glGenFramebuffers(1, &m_ReadFramebuffer);
+        glGenFramebuffers(1, &m_DrawFramebuffer);
+        for (const GLuint framebuffer : {m_ReadFramebuffer, m_DrawFramebuffer}) {
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+        }
+
+        for (UInt32 i = 0; i < g_MaxCascades; i++) {
+            m_Maps[i].Layer = i;
+        }
+        GetCubeMap().IsCube = true;
+        GetCubeMap().FaceCount = 6;
+
+        // Until its first refresh, a map doesn't shadow anything.
+        glBindFramebuffer(GL_FRAMEBUFFER, m_DrawFramebuffer);
+        for (const auto& map : m_Maps) {
+            if (!map.IsCube && map.Layer >= layerCount) {
+                continue;
+            }
+
+            for (UInt32 face = 0; face < map.FaceCount; face++) {
+                for (const bool cache : {true, false}) {
+                    AttachFace(GL_FRAMEBUFFER, map, face, cache);
+                    glClear(GL_DEPTH_BUFFER_BIT);
+                }
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ShadowRenderer::~ShadowRenderer() {
+        glDeleteFramebuffers(1, &m_ReadFramebuffer);
+        glDeleteFramebuffers(1, &m_DrawFramebuffer);
+
+        const GLuint textures[] = {m_CascadeCache, m_CascadeTexture, m_CubeCache, m_CubeTexture};
+        glDeleteTextures(4, textures);
+    }
+
+    void ShadowRenderer::ConfigureShader(const Shader& shader) const {
+        shader.Use();
+        shader.Set("cascadeShadowMap", static_cast<Int32>(g_CascadeShadowUnit));
+        shader.Set("pointShadowMap", static_cast<Int32>(g_PointShadowUnit));
+    }
+
+    void ShadowRenderer::Render(Model& model, StreamingManager* streaming, const glm::mat4& projection,
+                                const glm::mat4& view) {
+        m_Frame++;
+        m_Stats = ShadowStats{};
+
+        UpdateCascades(projection, view);
+        UpdatePointLight();
+
+        // Oldest caches first, so a map waiting for the budget is refreshed within a few frames.
+        m_Refreshes.clear();
+        for (UInt32 i = 0; i < m_Maps.size(); i++) {
+            if (m_Maps[i].NeedsRefresh()) {
+                m_Refreshes.push_back(i);
+            }
+        }
+
+        std::sort(m_Refreshes.begin(), m_Refreshes.end(), [&](const UInt32 lhs, const UInt32 rhs) {
+            return m_Maps[lhs].LastRefreshFrame < m_Maps[rhs].LastRefreshFrame;
+        });
+
+        if (m_Refreshes.size() > m_Settings.MaxRefreshesPerFrame) {
+            m_Stats.PendingRefreshes = static_cast<UInt32>(m_Refreshes.size()) - m_Settings.MaxRefreshesPerFrame;
+            m_Refreshes.resize(m_Settings.MaxRefreshesPerFrame);
+        }
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_ReadFramebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_DrawFramebuffer);
+        // Slope scaled bias against shadow acne.
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(2.0f, 4.0f);
+        m_DepthShader.Use();
+
+        for (UInt32 i = 0; i < m_Maps.size(); i++) {
+            ShadowMap& map = m_Maps[i];
+            if (!map.Enabled) {
+                continue;
+            }
+
+            const auto resolution = static_cast<GLint>(GetResolution(map));
+            glViewport(0, 0, resolution, resolution);
+
+            const bool refresh = std::find(m_Refreshes.begin(), m_Refreshes.end(), i) != m_Refreshes.end();
+            if (refresh) {
+                map.CachedMatrices = map.WantedMatrices;
+                map.Invalidated = false;
+                map.LastRefreshFrame = m_Frame;
+                // The shading rebuilds the depth with the far plane the cube map was rendered with.
+                if (map.IsCube) {
+                    m_CachedPointLight = glm::vec4(m_PointLightPosition,
+                                                   std::min(m_PointLightRange, m_Settings.ShadowDistance));
+                }
+
+                for (UInt32 face = 0; face < map.FaceCount; face++) {
+                    AttachFace(GL_DRAW_FRAMEBUFFER, map, face, true);
+                    glClear(GL_DEPTH_BUFFER_BIT);
+                    DrawCasters(model, streaming, map.CachedMatrices[face], false);
+                }
+
+                m_Stats.StaticRefreshes++;
+            }
+
+            bool hasDynamicCasters = false;
+            for (UInt32 face = 0; face < map.FaceCount && !hasDynamicCasters; face++) {
+                hasDynamicCasters = model.HasDynamicMeshesIn(Frustum::FromMatrix(map.CachedMatrices[face]));
+            }
+
+            // The copy also erases the dynamic casters of the previous frame.
+            if (refresh || hasDynamicCasters || map.HadDynamicCasters) {
+                for (UInt32 face = 0; face < map.FaceCount; face++) {
+                    AttachFace(GL_READ_FRAMEBUFFER, map, face, true);
+                    AttachFace(GL_DRAW_FRAMEBUFFER, map, face, false);
+                    glBlitFramebuffer(0, 0, resolution, resolution, 0, 0, resolution, resolution,
+                                      GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+                    if (hasDynamicCasters) {
+                        DrawCasters(model, nullptr, map.CachedMatrices[face], true);
+                    }
+                }
+
+                m_Stats.DynamicComposites += hasDynamicCasters ? 1 : 0;
+            }
+            map.HadDynamicCasters = hasDynamicCasters;
+        }
+
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // Shading uses the matrices the maps were rendered with, which lag behind while a refresh is pending.
+        for (UInt32 i = 0; i < g_MaxCascades; i++) {
+            m_Uniforms.CascadeMatrices[i] = m_Maps[i].CachedMatrices[0];
+        }
+
+        const bool pointShadows = GetCubeMap().Enabled;
+        m_Uniforms.PointShadowPosition = glm::vec4(glm::vec3(m_CachedPointLight), pointShadows ? 1.0f : 0.0f);
+        m_Uniforms.PointShadowRange = glm::vec4(g_PointShadowNear, m_CachedPointLight.w, 0.0f, 0.0f);
+    }
+
+    void ShadowRenderer::Bind() const {
+        glActiveTexture(GL_TEXTURE0 + g_CascadeShadowUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_CascadeTexture);
+        glActiveTexture(GL_TEXTURE0 + g_PointShadowUnit);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, m_CubeTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void ShadowRenderer::UpdateCascades(const glm::mat4& projection, const glm::mat4& view) {
+        const UInt32 cascadeCount = GetActiveCascadeCount();
+        for (UInt32 i = 0; i < g_MaxCascades; i++) {
+            m_Maps[i].Enabled = i < cascadeCount;
+        }
+
+        if (cascadeCount == 0) {
+            return;
+        }
+
+        // Near and far planes of the camera, from a glm::perspective matrix.
+        const Float32 cameraNear = projection[3][2] / (projection[2][2] - 1.0f);
+        const Float32 cameraFar = projection[3][2] / (projection[2][2] + 1.0f);
+        const Float32 shadowFar = std::min(cameraFar, m_Settings.ShadowDistance);
+
+        // The corners of a slice lie on the rays between the near and far corners of the view frustum.
+        const glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+        std::array<glm::vec3, 4> nearCorners, farCorners;
+        for (UInt32 corner = 0; corner < 4; corner++) {
+            const Float32 x = corner & 1 ? 1.0f : -1.0f;
+            const Float32 y = corner & 2 ? 1.0f : -1.0f;
+
+            const glm::vec4 nearCorner = inverseViewProjection * glm::vec4(x, y, -1.0f, 1.0f);
+            const glm::vec4 farCorner = inverseViewProjection * glm::vec4(x, y, 1.0f, 1.0f);
+            nearCorners[corner] = glm::vec3(nearCorner) / nearCorner.w;
+            farCorners[corner] = glm::vec3(farCorner) / farCorner.w;
+        }
+
+        const glm::vec3 up = std::abs(m_LightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f)
+                                                                   : glm::vec3(0.0f, 1.0f, 0.0f);
+        const glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), m_LightDirection, up);
+        const glm::mat4 inverseLightRotation = glm::inverse(lightRotation);
+
+        Float32 sliceNear = cameraNear;
+        for (UInt32 i = 0; i < cascadeCount; i++) {
+            const Float32 fraction = static_cast<Float32>(i + 1) / static_cast<Float32>(cascadeCount);
+            const Float32 logSplit = cameraNear * std::pow(shadowFar / cameraNear, fraction);
+            const Float32 uniformSplit = cameraNear + (shadowFar - cameraNear) * fraction;
+            const Float32 sliceFar = m_Settings.CascadeSplitLambda * logSplit +
+                                     (1.0f - m_Settings.CascadeSplitLambda) * uniformSplit;
+            m_Uniforms.CascadeSplits[static_cast<Int32>(i)] = sliceFar;
+
+            // Bounding sphere of the slice, its size doesn't change when the camera rotates.
+            std::array<glm::vec3, 8> corners;
+            glm::vec3 center(0.0f);
+            for (UInt32 corner = 0; corner < 4; corner++) {
+                const glm::vec3 ray = farCorners[corner] - nearCorners[corner];
+                corners[corner * 2] = nearCorners[corner] + ray * ((sliceNear - cameraNear) / (cameraFar - cameraNear));
+                corners[corner * 2 + 1] = nearCorners[corner] + ray * ((sliceFar - cameraNear) / (cameraFar - cameraNear));
+                center += corners[corner * 2] + corners[corner * 2 + 1];
+            }
+            center *= 1.0f / 8.0f;
+
+            Float32 radius = 0.0f;
+            for (const glm::vec3& corner : corners) {
+                radius = std::max(radius, glm::length(corner - center));
+            }
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            // Move the cascade by whole steps in light space, padded by a step so the slice stays covered.
+            const Float32 step = 2.0f * radius * m_Settings.CascadeSnapFraction;
+            glm::vec3 lightCenter(lightRotation * glm::vec4(center, 1.0f));
+            lightCenter = glm::vec3(Snap(lightCenter.x, step), Snap(lightCenter.y, step), Snap(lightCenter.z, step));
+            center = glm::vec3(inverseLightRotation * glm::vec4(lightCenter, 1.0f));
+
+            const Float32 extent = radius + step;
+            const Float32 depth = 2.0f * extent + m_Settings.CasterDistance;
+            const glm::mat4 lightView = glm::lookAt(center - m_LightDirection * (extent + m_Settings.CasterDistance),
+                                                    center, up);
+            const glm::mat4 lightProjection = glm::ortho(-extent, extent, -extent, extent, 0.0f, depth);
+            m_Maps[i].WantedMatrices[0] = lightProjection * lightView;
+
+            sliceNear = sliceFar;
+        }
+    }
+
+    void ShadowRenderer::UpdatePointLight() {
+        ShadowMap& map = GetCubeMap();
+        map.Enabled = m_PointLightRange > g_PointShadowNear;
+        if (!map.Enabled) {
+            return;
+        }
+
+        const Float32 range = std::min(m_PointLightRange, m_Settings.ShadowDistance);
+        const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, g_PointShadowNear, range);
+        for (UInt32 face = 0; face < 6; face++) {
+            const auto& [direction, up] = g_CubeFaces[face];
+            map.WantedMatrices[face] = projection * glm::lookAt(m_PointLightPosition, m_PointLightPosition + direction,
+                                                                up);
+        }
+    }
+
+    void ShadowRenderer::AttachFace(const GLenum target, const ShadowMap& map, const UInt32 face,
+                                    const bool cache) const {
+        if (map.IsCube) {
+            glFramebufferTexture2D(target, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                                   cache ? m_CubeCache : m_CubeTexture, 0);
+        } else {
+            glFramebufferTextureLayer(target, GL_DEPTH_ATTACHMENT, cache ? m_CascadeCache : m_CascadeTexture, 0,
+                                      static_cast<GLint>(map.Layer));
+        }
+    }
+
+    void ShadowRenderer::DrawCasters(Model& model, StreamingManager* streaming, const glm::mat4& viewProjection,
+                                     const bool dynamic) {
+        const Frustum frustum = Frustum::FromMatrix(viewProjection);
+        m_DepthShader.Set("lightViewProj", viewProjection);
+
+        model.DrawShadowCasters(m_DepthShader, frustum, dynamic);
+        // The streamed chunks never move.
+        if (!dynamic && streaming) {
+            streaming->Draw(m_DepthShader, frustum);
+        }
+    }
+
+    Float32 ComputeLightRange(const Float32 constant, const Float32 linear, const Float32 quadratic) {
+        constexpr Float32 threshold = 256.0f;
+
+        if (quadratic > 0.0f) {
+            return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * (constant - threshold))) /
+                   (2.0f * quadratic);
+        }
+
+        if (linear > 0.0f) {
+            return (threshold - constant) / linear;
+        }
+
+        return g_Infinity;
+    }
+}
@@ -0,0 +1,238 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/SoftwareOcclusionBuffer.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define OGLTEST_OCCLUSION_SSE
+    #include <emmintrin.h>
+#endif
+
+namespace OGLTest {
+    namespace {
+        // Triangles this close to the eye plane are dropped, skipping an occluder only makes the test more conservative.
+        constexpr Float32 g_MinClipW = 1e-5f;
+    }
+
+    SoftwareOcclusionBuffer::SoftwareOcclusionBuffer(const UInt32 width, const UInt32 height)
+        : m_Width((width + 3) & ~3u), m_Height(height), m_Depth(static_cast<UInt64>(m_Width) * height, 1.0f) {
+    }
+
+    void SoftwareOcclusionBuffer::Clear() {
+        std::fill(m_Depth.begin(), m_Depth.end(), 1.0f);
+    }
+
+    void SoftwareOcclusionBuffer::RasterizeIndexed(const glm::mat4& modelViewProjection, const glm::vec3* positions,
+                                                   const UInt32 stride, const UInt32 vertexCount,
+                                                   const std::span<const UInt32> indices) {
+        // Transform every vertex once, they are shared by several triangles.
+        m_TransformedVertices.resize(vertexCount);
+        const auto* bytes = reinterpret_cast<const UInt8*>(positions);
+        for (UInt32 i = 0; i < vertexCount; i++) {
+            const glm::vec3& position = *reinterpret_cast<const glm::vec3*>(bytes + static_cast<UInt64>(i) * stride);
+            m_TransformedVertices[i] = modelViewProjection * glm::vec4(position, 1.0f);
+        }
+
+        for (UInt64 i = 0; i + 2 < indices.size(); i += 3) {
+            RasterizeTriangle(m_TransformedVertices[indices[i]], m_TransformedVertices[indices[i + 1]],
+                              m_TransformedVertices[indices[i + 2]]);
+        }
+    }
+
+    void SoftwareOcclusionBuffer::RasterizeTriangle(const glm::vec4& clip0, const glm::vec4& clip1,
+                                                    const glm::vec4& clip2) {
+        // A vertex in front of the near plane (z < -w) would get a depth below 0 and hide everything behind the
+        // triangle, so the part in front is cut off. One plane turns a triangle into at most a quad.
+        const glm::vec4 triangle[3] = {clip0, clip1, clip2};
+        glm::vec4 polygon[4];
+        UInt32 vertexCount = 0;
+
+        for (UInt32 i = 0; i < 3; i++) {
+            const glm::vec4& current = triangle[i];
+            const glm::vec4& next = triangle[(i + 1) % 3];
+            const Float32 currentDistance = current.z + current.w;
+            const Float32 nextDistance = next.z + next.w;
+
+            if (currentDistance >= 0.0f) {
+                polygon[vertexCount++] = current;
+            }
+
+            if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+                const Float32 t = currentDistance / (currentDistance - nextDistance);
+                polygon[vertexCount++] = current + (next - current) * t;
+            }
+        }
+
+        for (UInt32 i = 1; i + 1 < vertexCount; i++) {
+            RasterizeClippedTriangle(polygon[0], polygon[i], polygon[i + 1]);
+        }
+    }
+
+    void SoftwareOcclusionBuffer::RasterizeClippedTriangle(const glm::vec4& clip0, const glm::vec4& clip1,
+                                                           const glm::vec4& clip2) {
+        if (clip0.w <= g_MinClipW || clip1.w <= g_MinClipW || clip2.w <= g_MinClipW) {
+            return;
+        }
+
+        const auto width = static_cast<Float32>(m_Width);
+        const auto height = static_cast<Float32>(m_Height);
+
+        // To screen space, z remapped to [0, 1]. The vertices cut on the near plane may round slightly below 0.
+        glm::vec3 v[3];
+        const glm::vec4* clips[3] = {&clip0, &clip1, &clip2};
+        for (Int32 i = 0; i < 3; i++) {
+            const Float32 inverseW = 1.0f / clips[i]->w;
+            v[i] = glm::vec3((clips[i]->x * inverseW * 0.5f + 0.5f) * width,
+                             (clips[i]->y * inverseW * 0.5f + 0.5f) * height,
+                             std::max(0.0f, clips[i]->z * inverseW * 0.5f + 0.5f));
+        }
+
+        Float32 area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+        if (std::abs(area) < 1e-8f) {
+            return;
+        }
+
+        // Occluders are two-sided, make the winding counter-clockwise so inside means all edge functions >= 0.
+        if (area < 0.0f) {
+            std::swap(v[1], v[2]);
+            area = -area;
+        }
+
+        const Int32 minX = std::max(0, static_cast<Int32>(std::floor(std::min({v[0].x, v[1].x, v[2].x})))) & ~3;
+        const Int32 maxX = std::min(static_cast<Int32>(m_Width) - 1,
+                                    static_cast<Int32>(std::floor(std::max({v[0].x, v[1].x, v[2].x}))));
+        const Int32 minY = std::max(0, static_cast<Int32>(std::floor(std::min({v[0].y, v[1].y, v[2].y}))));
+        const Int32 maxY = std::min(static_cast<Int32>(m_Height) - 1,
+                                    static_cast<Int32>(std::floor(std::max({v[0].y, v[1].y, v[2].y}))));
+
+        if (minX > maxX || minY > maxY) {
+            return;
+        }
+
+        // Edge functions as planes e(x, y) = a * x + b * y + c, edge i being the one opposite to vertex i.
+        Float32 a[3];
+        Float32 b[3];
+        Float32 c[3];
+        for (Int32 i = 0; i < 3; i++) {
+            const glm::vec3& from = v[(i + 1) % 3];
+            const glm::vec3& to = v[(i + 2) % 3];
+            a[i] = from.y - to.y;
+            b[i] = to.x - from.x;
+            c[i] = -(a[i] * from.x + b[i] * from.y);
+        }
+
+        // Depth interpolated linearly in screen space with the normalized edge functions as barycentrics.
+        const Float32 inverseArea = 1.0f / area;
+        const Float32 zA = (v[0].z * a[0] + v[1].z * a[1] + v[2].z * a[2]) * inverseArea;
+        const Float32 zB = (v[0].z * b[0] + v[1].z * b[1] + v[2].z * b[2]) * inverseArea;
+        const Float32 zC = (v[0].z * c[0] + v[1].z * c[1] + v[2].z * c[2]) * inverseArea;
+
+        for (Int32 y = minY; y <= maxY; y++) {
+            const Float32 pixelY = static_cast<Float32>(y) + 0.5f;
+            Float32* row = m_Depth.data() + static_cast<UInt64>(y) * m_Width;
+
+#ifdef OGLTEST_OCCLUSION_SSE
+            const __m128 rowE0 = _mm_set1_ps(b[0] * pixelY + c[0]);
+            const __m128 rowE1 = _mm_set1_ps(b[1] * pixelY + c[1]);
+            const __m128 rowE2 = _mm_set1_ps(b[2] * pixelY + c[2]);
+            const __m128 rowZ = _mm_set1_ps(zB * pixelY + zC);
+            const __m128 zero = _mm_setzero_ps();
+
+            for (Int32 x = minX; x <= maxX; x += 4) {
+                const auto baseX = static_cast<Float32>(x);
+                const __m128 pixelX = _mm_set_ps(baseX + 3.5f, baseX + 2.5f, baseX + 1.5f, baseX + 0.5f);
+
+                const __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), pixelX), rowE0);
+                const __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), pixelX), rowE1);
+                const __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), pixelX), rowE2);
+                const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                                 _mm_cmpge_ps(e2, zero));
+
+                if (_mm_movemask_ps(inside) == 0) {
+                    continue;
+                }
+
+                const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(zA), pixelX), rowZ);
+                const __m128 depth = _mm_loadu_ps(row + x);
+                const __m128 nearest = _mm_min_ps(depth, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, depth)));
+            }
+#else
+            for (Int32 x = minX; x <= maxX; x++) {
+                const Float32 pixelX = static_cast<Float32>(x) + 0.5f;
+
+                if (a[0] * pixelX + b[0] * pixelY + c[0] < 0.0f ||
+                    a[1] * pixelX + b[1] * pixelY + c[1] < 0.0f ||
+                    a[2] * pixelX + b[2] * pixelY + c[2] < 0.0f) {
+                    continue;
+                }
+
+                row[x] = std::min(row[x], zA * pixelX + zB * pixelY + zC);
+            }
+#endif
+        }
+    }
+
+    bool SoftwareOcclusionBuffer::IsVisible(const BoundingBox& box, const glm::mat4& viewProjection) const {
+        const auto width = static_cast<Float32>(m_Width);
+        const auto height = static_cast<Float32>(m_Height);
+
+        BoundingBox screenBox;
+        for (Int32 corner = 0; corner < 8; corner++) {
+            const glm::vec3 position((corner & 1) ? box.Max.x : box.Min.x, (corner & 2) ? box.Max.y : box.Min.y,
+                                     (corner & 4) ? box.Max.z : box.Min.z);
+            const glm::vec4 clip = viewProjection * glm::vec4(position, 1.0f);
+
+            // The box crosses the eye plane, the camera is (almost) inside it.
+            if (clip.w <= g_MinClipW) {
+                return true;
+            }
+
+            const Float32 inverseW = 1.0f / clip.w;
+            screenBox.Extend(glm::vec3((clip.x * inverseW * 0.5f + 0.5f) * width,
+                                       (clip.y * inverseW * 0.5f + 0.5f) * height,
+                                       clip.z * inverseW * 0.5f + 0.5f));
+        }
+
+        if (screenBox.Max.x < 0.0f || screenBox.Max.y < 0.0f || screenBox.Min.x >= width ||
+            screenBox.Min.y >= height) {
+            return false;
+        }
+
+        if (screenBox.Min.z <= 0.0f) {
+            return true;
+        }
+
+        // The box is visible if its nearest depth is in front of any pixel of its screen rectangle.
+        const Int32 minX = std::max(0, static_cast<Int32>(std::floor(screenBox.Min.x))) & ~3;
+        const Int32 maxX = std::min(static_cast<Int32>(m_Width) - 1, static_cast<Int32>(std::floor(screenBox.Max.x)));
+        const Int32 minY = std::max(0, static_cast<Int32>(std::floor(screenBox.Min.y)));
+        const Int32 maxY = std::min(static_cast<Int32>(m_Height) - 1, static_cast<Int32>(std::floor(screenBox.Max.y)));
+        const Float32 nearestDepth = screenBox.Min.z;
+
+        for (Int32 y = minY; y <= maxY; y++) {
+            const Float32* row = m_Depth.data() + static_cast<UInt64>(y) * m_Width;
+
+#ifdef OGLTEST_OCCLUSION_SSE
+            const __m128 boxDepth = _mm_set1_ps(nearestDepth);
+            for (Int32 x = minX; x <= maxX; x += 4) {
+                if (_mm_movemask_ps(_mm_cmplt_ps(boxDepth, _mm_loadu_ps(row + x))) != 0) {
+                    return true;
+                }
+            }
+#else
+            for (Int32 x = minX; x <= maxX; x++) {
+                if (nearestDepth < row[x]) {
+                    return true;
+                }
+            }
+#endif
+        }
+
+        return false;
+    }
+}
@@ -0,0 +1,145 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/StreamBuffer.hpp>
+
+#include <OpenGLTest/GLCapture.hpp>
+
+#include <chrono>
+
+namespace OGLTest {
+    namespace {
+        // Only used to report progress while waiting, the wait itself is unbounded.
+        constexpr GLuint64 g_FenceTimeout = 1'000'000; // 1 ms
+    }
+
+    StreamBuffer::StreamBuffer(const GLenum target, const UInt64 regionSize, const bool allowPersistentMapping)
+        : m_Target(target), m_RegionSize(regionSize) {
+        const UInt64 bufferSize = m_RegionSize * g_StreamBufferRegionCount;
+
+        // The copy target is used for the uploads so the bindings of m_Target (and of the bound VAO) stay untouched.
+        glGenBuffers(1, &m_Buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+
+        // Buffer storage is core since GL 4.4, the glad loader used here only knows the 3.3 core profile.
+        // The writes through a persistent mapping bypass the GL calls and couldn't be captured.
+#ifdef GL_MAP_PERSISTENT_BIT
+        if (allowPersistentMapping && !GLCapture::IsRecording() &&
+            (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4))) {
+            constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+            glBufferStorage(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(bufferSize), nullptr, flags);
+            m_Mapped = static_cast<UInt8*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, static_cast<GLsizeiptr>(bufferSize), flags));
+            m_Persistent = m_Mapped != nullptr;
+
+            if (!m_Persistent) {
+                // Immutable storage can't be respecified, start over with a new buffer.
+                std::cerr << "Couldn't map the stream buffer persistently, falling back to glBufferSubData." << '\n';
+                glDeleteBuffers(1, &m_Buffer);
+                glGenBuffers(1, &m_Buffer);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+            }
+        }
+#else
+        OGLTEST_UNUSED(allowPersistentMapping);
+#endif
+
+        if (!m_Persistent) {
+            glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(bufferSize), nullptr, GL_STREAM_DRAW);
+            m_Staging.resize(m_RegionSize);
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    StreamBuffer::~StreamBuffer() {
+        for (const GLsync fence : m_Fences) {
+            if (fence) {
+                glDeleteSync(fence);
+            }
+        }
+
+        if (m_Persistent) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+
+        glDeleteBuffers(1, &m_Buffer);
+    }
+
+    void StreamBuffer::BeginFrame() {
+        m_Region = (m_Region + 1) % g_StreamBufferRegionCount;
+        m_Head = 0;
+        m_FlushedHead = 0;
+
+        GLsync& fence = m_Fences[m_Region];
+        if (!fence) {
+            return;
+        }
+
+        // Without the flush bit, the fence may never reach the GPU and the wait would never end.
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceTimeout);
+            } while (result == GL_TIMEOUT_EXPIRED);
+
+            m_Stats.FenceWaits++;
+            m_Stats.FenceWaitMs +=
+                std::chrono::duration<Float64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        if (result == GL_WAIT_FAILED) {
+            std::cerr << "Waiting for a stream buffer fence failed." << '\n';
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    void StreamBuffer::EndFrame() {
+        Flush();
+
+        m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    StreamAllocation StreamBuffer::Allocate(const UInt64 size, const UInt64 alignment) {
+        // Offsets are aligned in the whole buffer, the region start may not be a multiple of the alignment.
+        const UInt64 regionStart = GetRegionStart();
+        const UInt64 alignedOffset = (regionStart + m_Head + alignment - 1) / alignment * alignment;
+        const UInt64 head = alignedOffset - regionStart;
+
+        if (head + size > m_RegionSize) {
+            m_Stats.FailedAllocations++;
+            return StreamAllocation{};
+        }
+
+        m_Head = head + size;
+        m_Stats.AllocatedBytes += size;
+
+        StreamAllocation allocation;
+        allocation.Data = m_Persistent ? m_Mapped + alignedOffset : m_Staging.data() + head;
+        allocation.Offset = alignedOffset;
+        allocation.Size = size;
+
+        return allocation;
+    }
+
+    void StreamBuffer::Flush() {
+        // Coherent mappings are visible to the GPU without anything to do.
+        if (m_Persistent || m_FlushedHead == m_Head) {
+            return;
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(GetRegionStart() + m_FlushedHead),
+                        static_cast<GLsizeiptr>(m_Head - m_FlushedHead), m_Staging.data() + m_FlushedHead);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        m_FlushedHead = m_Head;
+    }
+}
@@ -0,0 +1,341 @@
+// Copyright (C) 2024 Jean "Pixfri" Letessier 
+// This file is part of OpenGL Test.
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <OpenGLTest/StreamingManager.hpp>
+
+#include <algorithm>
+
+namespace OGLTest {
+    namespace {
+        Float32 DistanceToBox(const BoundingBox& box, const glm::vec3& point) {
+            const glm::vec3 closest = glm::clamp(point, box.Min, box.Max);
+            return glm::length(point - closest);
+        }
+    }
+
+    StreamingManager::StreamingManager(JobSystem& jobs, const StreamingSettings& settings)
+        : m_Jobs(jobs), m_Settings(settings) {
+    }
+
+    StreamingManager::~StreamingManager() {
+        Close();
+    }
+
+    bool StreamingManager::Open(const std::filesystem::path& path) {
+        Close();
+
+        std::vector<ChunkDesc> descs;
+        if (!ReadChunkTable(path, descs)) {
+            return false;
+        }
+
+        m_Path = path;
+        m_Chunks.resize(descs.size());
+        for (UInt64 i = 0; i < descs.size(); i++) {
+            m_Chunks[i].Desc = descs[i];
+        }
+
+        m_Stop = false;
+        for (UInt32 i = 0; i < std::max(1u, m_Settings.IoThreadCount); i++) {
+            m_IoThreads.emplace_back(&StreamingManager::IoThreadMain, this);
+        }
+
+        return true;
+    }
+
+    void StreamingManager::Close() {
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_RequestAvailable.notify_all();
+
+        for (auto& thread : m_IoThreads) {
+            thread.join();
+        }
+        m_IoThreads.clear();
+
+        while (!m_ResidentChunks.empty()) {
+            Evict(m_ResidentChunks.back());
+        }
+
+        m_Chunks.clear();
+        m_Requests.clear();
+        m_Completed.clear();
+        m_PendingUploads.clear();
+        m_CpuBytes = 0;
+        m_GpuBytes = 0;
+        m_Stats = ResidencyStats{};
+    }
+
+    void StreamingManager::Update(const glm::vec3& cameraPosition) {
+        m_Frame++;
+        m_Stats.UploadsThisFrame = 0;
+        m_Stats.EvictionsThisFrame = 0;
+
+        // 1. Prioritize by distance and rebuild the request queue, nearest chunk last so the I/O threads pop it first.
+        // The distances don't need the lock, the I/O threads never read them.
+        m_Jobs.ParallelFor(0, m_Chunks.size(), 1024, [&](const UInt64 first, const UInt64 last) {
+            for (UInt64 i = first; i < last; i++) {
+                Chunk& chunk = m_Chunks[i];
+                chunk.Priority = DistanceToBox(chunk.Desc.Bounds, cameraPosition);
+
+                if (chunk.Priority <= m_Settings.LoadRadius) {
+                    chunk.LastUsedFrame = m_Frame;
+                }
+            }
+        });
+
+        {
+            std::lock_guard lock(m_Mutex);
+
+            m_Requests.clear();
+            for (UInt32 i = 0; i < m_Chunks.size(); i++) {
+                Chunk& chunk = m_Chunks[i];
+                const bool wanted = chunk.LastUsedFrame == m_Frame;
+
+                if (chunk.State == ChunkState::Unloaded || chunk.State == ChunkState::Queued) {
+                    chunk.State = wanted ? ChunkState::Queued : ChunkState::Unloaded;
+                    if (wanted) {
+                        m_Requests.push_back(i);
+                    }
+                }
+            }
+
+            std::sort(m_Requests.begin(), m_Requests.end(), [&](const UInt32 lhs, const UInt32 rhs) {
+                return m_Chunks[lhs].Priority > m_Chunks[rhs].Priority;
+            });
+
+            m_PendingUploads.insert(m_PendingUploads.end(), m_Completed.begin(), m_Completed.end());
+            m_Completed.clear();
+        }
+        m_RequestAvailable.notify_all();
+
+        // 2. Upload the nearest finished reads. Reads that aren't wanted anymore are dropped, the wanted ones that
+        // don't fit this frame keep their data until there is room, instead of being read again.
+        std::sort(m_PendingUploads.begin(), m_PendingUploads.end(), [&](const UInt32 lhs, const UInt32 rhs) {
+            return m_Chunks[lhs].Priority > m_Chunks[rhs].Priority;
+        });
+
+        UInt64 releasedCpuBytes = 0;
+        bool gpuFull = false;
+        // The kept reads are packed at the end, in the same order, the nearest one last.
+        UInt64 keptBegin = m_PendingUploads.size();
+        for (UInt64 i = m_PendingUploads.size(); i-- > 0;) {
+            const UInt32 chunkIndex = m_PendingUploads[i];
+            Chunk& chunk = m_Chunks[chunkIndex];
+            const UInt64 size = chunk.Desc.GetDataSize();
+
+            if (chunk.LastUsedFrame == m_Frame) {
+                if (gpuFull || m_Stats.UploadsThisFrame >= m_Settings.MaxUploadsPerFrame) {
+                    m_PendingUploads[--keptBegin] = chunkIndex;
+                    continue;
+                }
+
+                // Nothing else can be evicted this frame, the remaining reads wait for the next ones.
+                if (!MakeGpuRoom(size)) {
+                    gpuFull = true;
+                    m_PendingUploads[--keptBegin] = chunkIndex;
+                    continue;
+                }
+
+                Upload(chunkIndex);
+                m_Stats.UploadsThisFrame++;
+            }
+
+            std::lock_guard lock(m_Mutex);
+            chunk.Data.reset();
+            if (chunk.State == ChunkState::Loaded) {
+                chunk.State = ChunkState::Unloaded;
+            }
+            releasedCpuBytes += size;
+        }
+        m_PendingUploads.erase(m_PendingUploads.begin(), m_PendingUploads.begin() + static_cast<Int64>(keptBegin));
+
+        // 3. The released CPU memory lets the I/O threads start new reads.
+        {
+            std::lock_guard lock(m_Mutex);
+            m_CpuBytes -= releasedCpuBytes;
+
+            m_Stats.TotalChunks = static_cast<UInt32>(m_Chunks.size());
+            m_Stats.RequestedChunks = 0;
+            m_Stats.QueuedChunks = static_cast<UInt32>(m_Requests.size());
+            m_Stats.LoadingChunks = 0;
+            m_Stats.ResidentChunks = static_cast<UInt32>(m_ResidentChunks.size());
+
+            for (const auto& chunk : m_Chunks) {
+                m_Stats.RequestedChunks += chunk.LastUsedFrame == m_Frame ? 1 : 0;
+                m_Stats.LoadingChunks += chunk.State == ChunkState::Loading || chunk.State == ChunkState::Loaded ? 1 : 0;
+            }
+
+            m_Stats.CpuBytes = m_CpuBytes;
+            m_Stats.GpuBytes = m_GpuBytes;
+        }
+
+        if (releasedCpuBytes > 0) {
+            m_RequestAvailable.notify_all();
+        }
+    }
+
+    void StreamingManager::Draw(Shader& shader, const Frustum& frustum) {
+        shader.Set("model", glm::mat4(1.0f));
+        // Chunks aren't textured.
+        shader.Set("materialIndex", static_cast<Int32>(g_InvalidMaterial));
+
+        // The frustum tests are split between the jobs, the draws stay on this thread.
+        m_VisibleChunks.resize(m_ResidentChunks.size());
+        m_Jobs.ParallelFor(0, m_ResidentChunks.size(), 256, [&](const UInt64 first, const UInt64 last) {
+            for (UInt64 i = first; i < last; i++) {
+                m_VisibleChunks[i] = frustum.Intersects(m_Chunks[m_ResidentChunks[i]].Desc.Bounds) ? 1 : 0;
+            }
+        });
+
+        for (UInt64 i = 0; i < m_ResidentChunks.size(); i++) {
+            if (!m_VisibleChunks[i]) {
+                continue;
+            }
+
+            Chunk& chunk = m_Chunks[m_ResidentChunks[i]];
+
+            chunk.LastUsedFrame = m_Frame;
+
+            glBindVertexArray(chunk.VAO);
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(chunk.Desc.IndexCount), GL_UNSIGNED_INT, 0);
+        }
+
+        glBindVertexArray(0);
+    }
+
+    void StreamingManager::IoThreadMain() {
+        // Each thread has its own handle so reads can overlap.
+        std::ifstream file(m_Path, std::ios::binary);
+
+        while (true) {
+            UInt32 chunkIndex;
+            {
+                std::unique_lock lock(m_Mutex);
+                m_RequestAvailable.wait(lock, [&]() {
+                    if (m_Stop) {
+                        return true;
+                    }
+
+                    if (m_Requests.empty()) {
+                        return false;
+                    }
+
+                    // A chunk bigger than the whole budget can still be loaded on its own.
+                    const UInt64 size = m_Chunks[m_Requests.back()].Desc.GetDataSize();
+                    return m_CpuBytes == 0 || m_CpuBytes + size <= m_Settings.CpuBudget;
+                });
+
+                if (m_Stop) {
+                    return;
+                }
+
+                chunkIndex = m_Requests.back();
+                m_Requests.pop_back();
+
+                // The memory is reserved before reading so concurrent reads can't overshoot the budget.
+                m_Chunks[chunkIndex].State = ChunkState::Loading;
+                m_CpuBytes += m_Chunks[chunkIndex].Desc.GetDataSize();
+            }
+
+            auto data = std::make_unique<ChunkData>();
+            const bool success = ReadChunkData(file, m_Chunks[chunkIndex].Desc, *data);
+
+            std::lock_guard lock(m_Mutex);
+            Chunk& chunk = m_Chunks[chunkIndex];
+
+            if (success) {
+                chunk.Data = std::move(data);
+                chunk.State = ChunkState::Loaded;
+                m_Completed.push_back(chunkIndex);
+            } else {
+                std::cerr << "Failed to read chunk " << chunkIndex << " from: " << m_Path << '\n';
+                chunk.State = ChunkState::Unloaded;
+                m_CpuBytes -= chunk.Desc.GetDataSize();
+            }
+        }
+    }
+
+    void StreamingManager::Upload(const UInt32 chunkIndex) {
+        Chunk& chunk = m_Chunks[chunkIndex];
+
+        glGenVertexArrays(1, &chunk.VAO);
+        glGenBuffers(1, &chunk.VBO);
+        glGenBuffers(1, &chunk.EBO);
+
+        glBindVertexArray(chunk.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.VBO);
+        glBufferData(GL_ARRAY_BUFFER, chunk.Data->Vertices.size() * sizeof(Vertex), chunk.Data->Vertices.data(),
+                     GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, chunk.Data->Indices.size() * sizeof(UInt32), chunk.Data->Indices.data(),
+                     GL_STATIC_DRAW);
+
+        // Same layout as Mesh
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, UVs));
+
+        glBindVertexArray(0);
+
+        m_GpuBytes += chunk.Desc.GetDataSize();
+        m_ResidentChunks.push_back(chunkIndex);
+
+        std::lock_guard lock(m_Mutex);
+        chunk.State = ChunkState::Resident;
+    }
+
+    void StreamingManager::Evict(const UInt32 chunkIndex) {
+        Chunk& chunk = m_Chunks[chunkIndex];
+
+        glDeleteVertexArrays(1, &chunk.VAO);
+        glDeleteBuffers(1, &chunk.VBO);
+        glDeleteBuffers(1, &chunk.EBO);
+        chunk.VAO = chunk.VBO = chunk.EBO = 0;
+
+        m_GpuBytes -= chunk.Desc.GetDataSize();
+        m_Stats.EvictionsThisFrame++;
+        std::erase(m_ResidentChunks, chunkIndex);
+
+        std::lock_guard lock(m_Mutex);
+        chunk.State = ChunkState::Unloaded;
+    }
+
+    bool StreamingManager::MakeGpuRoom(const UInt64 size) {
+        if (m_GpuBytes + size <= m_Settings.GpuBudget) {
+            return true;
+        }
+
+        std::vector<UInt32> candidates;
+        for (const UInt32 chunkIndex : m_ResidentChunks) {
+            if (m_Chunks[chunkIndex].LastUsedFrame < m_Frame) {
+                candidates.push_back(chunkIndex);
+            }
+        }
+
+        // Least recently used first, the furthest one among equally old chunks.
+        std::sort(candidates.begin(), candidates.end(), [&](const UInt32 lhs, const UInt32 rhs) {
+            if (m_Chunks[lhs].LastUsedFrame != m_Chunks[rhs].LastUsedFrame) {
+                return m_Chunks[lhs].LastUsedFrame < m_Chunks[rhs].LastUsedFrame;
+            }
+            return m_Chunks[lhs].Priority > m_Chunks[rhs].Priority;
+        });
+
+        for (const UInt32 chunkIndex : candidates) {
+            if (m_GpuBytes + size <= m_Settings.GpuBudget) {
+                break;
+            }
+
+            Evict(chunkIndex);
+        }
+
+        return m_GpuBytes + size <= m_Settings.GpuBudget;
+    }
+}
@@ -5,8 +5,17 @@
 #include "OpenGLTest/pch.hpp"
 
 #include <OpenGLTest/Shader.hpp>
+#include <OpenGLTest/Benchmarks.hpp>
 #include <OpenGLTest/Camera.hpp>
+#include <OpenGLTest/DynamicResolution.hpp>
+#include <OpenGLTest/GLCapture.hpp>
+#include <OpenGLTest/JobSystem.hpp>
 #include <OpenGLTest/Model.hpp>
+#include <OpenGLTest/OcclusionCuller.hpp>
+#include <OpenGLTest/RenderThread.hpp>
+#include <OpenGLTest/SceneRenderer.hpp>
+#include <OpenGLTest/ShadowRenderer.hpp>
+#include <OpenGLTest/StreamingManager.hpp>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -17,23 +26,171 @@
 
 #include <stb/stb_image.h>
 
+#include <algorithm>
 #include <cmath>
 #include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
 
 #define WINDOW_WIDTH 1920
 #define WINDOW_HEIGHT 1080
 
-OGLTest::Camera g_Camera(glm::vec3(0.0f, 0.0f, 3.0f));
-OGLTest::Float32 g_LastX = WINDOW_WIDTH / 2.0f;
-OGLTest::Float32 g_LastY = WINDOW_HEIGHT / 2.0f;
-bool g_FirstMouse = true;
+// Accumulated by the GLFW callbacks during glfwPollEvents and consumed once per frame by the main loop.
+struct InputState {
+    OGLTest::Float32 LastX = WINDOW_WIDTH / 2.0f;
+    OGLTest::Float32 LastY = WINDOW_HEIGHT / 2.0f;
+    bool FirstMouse = true;
+
+    OGLTest::Float32 MouseOffsetX = 0.0f;
+    OGLTest::Float32 MouseOffsetY = 0.0f;
+    OGLTest::Float32 ScrollOffset = 0.0f;
+    // Set by a left click, the cursor is captured so the pick goes through the center of the view.
+    bool PickRequested = false;
+
+    OGLTest::Int32 Width = WINDOW_WIDTH;
+    OGLTest::Int32 Height = WINDOW_HEIGHT;
+};
+
+void ProcessInput(GLFWwindow* window, OGLTest::Float32 deltaTime, OGLTest::Camera& camera,
+                  OGLTest::OcclusionMode& occlusionMode);
+
+int main(int argc, char** argv) {
+    // --generate-chunks <file> [grid size]: writes a synthetic streaming scene and exits.
+    // --chunk-model <model> <file> [cell size]: splits a model into a chunk file in a hidden window and exits, the
+    //                                           chunks are 16 units wide by default.
+    // --stream <file>: streams a chunk file around the camera in addition to the model.
+    // --test-streaming: streams a synthetic chunk file along a camera path in a hidden window, checks the budgets and
+    //                   the residency counts, and exits with a non-zero code on failure.
+    // --single-thread: records and executes the frames on the main thread, to compare with the render thread.
+    // --benchmark-stream-buffer: measures the dynamic upload paths in a hidden window and exits.
+    // --benchmark-jobs: measures the job system scaling over the worker counts and exits.
+    // --test-jobs: checks the job system dependencies, stealing, main thread affinity and contention, and exits with
+    //              a non-zero code on failure.
+    // --weld <off|bitwise|epsilon>: how the imported vertices are merged, bitwise by default.
+    // --import-report: prints the size of each imported mesh before and after welding.
+    // --no-import-arena: allocates the import temporaries from the heap, to compare with the arena.
+    // --fixed-resolution: renders the scene at the window size instead of scaling it to the GPU time budget.
+    // --frame-budget <ms>: GPU time budget of a frame for the dynamic resolution, 16 ms by default.
+    // --upscale <bilinear|sharpen>: filter of the upscale to the window, sharpen by default.
+    // --model <file>: model to load instead of the backpack.
+    // --no-native-gltf: imports the .glb files through Assimp too, to compare with the native loader.
+    // --benchmark-gltf <file>: measures the native and Assimp loading of a .glb file in a hidden window and exits.
+    // --benchmark-bvh: measures the BVH build time and ray throughput over the model and a synthetic mesh of about
+    //                  1M triangles in a hidden window, and exits.
+    // --capture <file> [frames]: records the GL calls of the loading and of the first frames (1 by default) to a
+    //                            capture file for GLReplay.
+    std::string streamPath;
+    std::string modelPath = "Resources/Models/backpack/backpack.obj";
+    std::string benchmarkGltfPath;
+    std::string capturePath;
+    std::string chunkModelPath;
+    std::string chunkOutputPath;
+    OGLTest::Float32 chunkCellSize = 16.0f;
+    OGLTest::UInt32 captureFrames = 1;
+    OGLTest::ModelImportSettings importSettings;
+    OGLTest::DynamicResolutionSettings resolutionSettings;
+    bool importReport = false;
+    bool threadedRendering = true;
+    bool benchmarkStreamBuffer = false;
+    bool testStreaming = false;
+    bool benchmarkBvh = false;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view argument = argv[i];
+
+        if (argument == "--generate-chunks" && i + 1 < argc) {
+            const OGLTest::UInt32 gridSize = i + 2 < argc ? static_cast<OGLTest::UInt32>(std::atoi(argv[i + 2])) : 64;
+            return OGLTest::WriteSyntheticChunkFile(argv[i + 1], gridSize, 64) ? 0 : -4;
+        }
+
+        if (argument == "--chunk-model" && i + 2 < argc) {
+            chunkModelPath = argv[++i];
+            chunkOutputPath = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                chunkCellSize = static_cast<OGLTest::Float32>(std::atof(argv[++i]));
+            }
+        }
+
+        if (argument == "--stream" && i + 1 < argc) {
+            streamPath = argv[++i];
+        }
+
+        if (argument == "--test-streaming") {
+            testStreaming = true;
+        }
+
+        if (argument == "--single-thread") {
+            threadedRendering = false;
+        }
+
+        if (argument == "--benchmark-stream-buffer") {
+            benchmarkStreamBuffer = true;
+        }
+
+        if (argument == "--weld" && i + 1 < argc) {
+            const std::string_view mode = argv[++i];
+            importSettings.Welding = mode == "off" ? OGLTest::VertexWelding::Disabled
+                      : mode == "epsilon" ? OGLTest::VertexWelding::Epsilon
+                      : OGLTest::VertexWelding::Bitwise;
+        }
+
+        if (argument == "--no-import-arena") {
+            importSettings.UseImportArena = false;
+        }
+
+        if (argument == "--fixed-resolution") {
+            resolutionSettings.Enabled = false;
+        }
+
+        if (argument == "--frame-budget" && i + 1 < argc) {
+            resolutionSettings.TargetFrameMs = static_cast<OGLTest::Float32>(std::atof(argv[++i]));
+        }
+
+        if (argument == "--upscale" && i + 1 < argc) {
+            const std::string_view filter = argv[++i];
+            resolutionSettings.Filter = filter == "bilinear" ? OGLTest::UpscaleFilter::Bilinear
+                                                             : OGLTest::UpscaleFilter::Sharpen;
+        }
+
+        if (argument == "--model" && i + 1 < argc) {
+            modelPath = argv[++i];
+        }
+
+        if (argument == "--no-native-gltf") {
+            importSettings.UseNativeGltf = false;
+        }
+
+        if (argument == "--benchmark-gltf" && i + 1 < argc) {
+            benchmarkGltfPath = argv[++i];
+        }
+
+        if (argument == "--benchmark-bvh") {
+            benchmarkBvh = true;
+        }
+
+        if (argument == "--capture" && i + 1 < argc) {
+            capturePath = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                captureFrames = static_cast<OGLTest::UInt32>(std::max(std::atoi(argv[++i]), 1));
+            }
+        }
+
+        if (argument == "--import-report") {
+            importReport = true;
+        }
+
+        if (argument == "--benchmark-jobs") {
+            return OGLTest::BenchmarkJobs() ? 0 : -5;
+        }
 
-std::chrono::high_resolution_clock::time_point g_CurrentTime;
-OGLTest::Float32 g_DeltaTime = 0.016f;
+        if (argument == "--test-jobs") {
+            return OGLTest::TestJobs() ? 0 : -5;
+        }
+    }
 
-void ProcessInput(GLFWwindow* window, OGLTest::Float32 deltaTime);
+    // Created on the main thread, which runs the main thread jobs (the GL uploads while loading).
+    OGLTest::JobSystem jobs;
 
-int main() {
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW." << '\n';
         return -1;
@@ -43,6 +200,9 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_SCALE_TO_MONITOR, GLFW_FALSE);
+    const bool hiddenWindow = benchmarkStreamBuffer || !benchmarkGltfPath.empty() || !chunkModelPath.empty() ||
+                              testStreaming || benchmarkBvh;
+    glfwWindowHint(GLFW_VISIBLE, hiddenWindow ? GLFW_FALSE : GLFW_TRUE);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
@@ -69,88 +229,269 @@ int main() {
         return -3;
     }
 
-    glfwSetWindowSizeCallback(window, [](GLFWwindow* win, int width, int height) {
-        OGLTEST_UNUSED(win);
-        glViewport(0, 0, width, height);
+    if (benchmarkStreamBuffer) {
+        OGLTest::BenchmarkStreamBuffers();
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
+
+    if (!benchmarkGltfPath.empty()) {
+        OGLTest::BenchmarkGltf(benchmarkGltfPath, jobs);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
+
+    if (benchmarkBvh) {
+        OGLTest::BenchmarkBvh(modelPath, jobs);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
+
+    if (!chunkModelPath.empty()) {
+        const bool written = OGLTest::ChunkModel(chunkModelPath, chunkOutputPath, chunkCellSize, jobs);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return written ? 0 : -4;
+    }
+
+    if (testStreaming) {
+        const bool passed = OGLTest::TestStreaming(jobs);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return passed ? 0 : -5;
+    }
+
+    // The callbacks run on the main thread, they only record the input, the GL calls happen on the render thread.
+    InputState input;
+    glfwSetWindowUserPointer(window, &input);
+
+    // In pixels, the scene target and the viewport follow the framebuffer rather than the window coordinates.
+    glfwGetFramebufferSize(window, &input.Width, &input.Height);
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow* win, int width, int height) {
+        InputState& state = *static_cast<InputState*>(glfwGetWindowUserPointer(win));
+        state.Width = width;
+        state.Height = height;
     });
 
     glfwSetCursorPosCallback(window, [](GLFWwindow* win, OGLTest::Float64 xPos, OGLTest::Float64 yPos) -> void {
-        OGLTEST_UNUSED(win);
+        InputState& state = *static_cast<InputState*>(glfwGetWindowUserPointer(win));
 
-        if (g_FirstMouse) {
-            g_LastX = static_cast<OGLTest::Float32>(xPos);
-            g_LastY = static_cast<OGLTest::Float32>(yPos);
-            g_FirstMouse = false;
+        if (state.FirstMouse) {
+            state.LastX = static_cast<OGLTest::Float32>(xPos);
+            state.LastY = static_cast<OGLTest::Float32>(yPos);
+            state.FirstMouse = false;
         }
 
-        OGLTest::Float32 xOffset = static_cast<OGLTest::Float32>(xPos) - g_LastX;
-        OGLTest::Float32 yOffset = g_LastY - static_cast<OGLTest::Float32>(yPos);
+        state.MouseOffsetX += static_cast<OGLTest::Float32>(xPos) - state.LastX;
+        state.MouseOffsetY += state.LastY - static_cast<OGLTest::Float32>(yPos);
 
-        g_LastX = static_cast<OGLTest::Float32>(xPos);
-        g_LastY = static_cast<OGLTest::Float32>(yPos);
+        state.LastX = static_cast<OGLTest::Float32>(xPos);
+        state.LastY = static_cast<OGLTest::Float32>(yPos);
+    });
 
-        g_Camera.ProcessMouseMovement(xOffset, yOffset);
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* win, int button, int action, int mods) -> void {
+        OGLTEST_UNUSED(mods);
+
+        InputState& state = *static_cast<InputState*>(glfwGetWindowUserPointer(win));
+        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+            state.PickRequested = true;
+        }
     });
 
     glfwSetScrollCallback(window, [](GLFWwindow* win, OGLTest::Float64 xOffset, OGLTest::Float64 yOffset) -> void {
-        OGLTEST_UNUSED(win);
         OGLTEST_UNUSED(xOffset);
 
-        g_Camera.ProcessMouseScroll(static_cast<OGLTest::Float32>(yOffset));
+        InputState& state = *static_cast<InputState*>(glfwGetWindowUserPointer(win));
+        state.ScrollOffset += static_cast<OGLTest::Float32>(yOffset);
     });
 
+    // Counts the GL calls of each frame, and records them with --capture.
+    OGLTest::GLCapture glCapture;
+    if (!capturePath.empty()) {
+        if (glCapture.StartRecording(capturePath, static_cast<OGLTest::UInt32>(input.Width),
+                                     static_cast<OGLTest::UInt32>(input.Height), captureFrames)) {
+            std::cout << "Capturing the loading and " << captureFrames << " frame(s) to " << capturePath << '\n';
+        }
+    }
+
     glEnable(GL_DEPTH_TEST);
 
     stbi_set_flip_vertically_on_load(true);
 
-    OGLTest::Shader shader{"Resources/Shaders/common.vert", "Resources/Shaders/pointlight.frag"};
+    // The bindless variant reads the texture handles from a storage buffer instead of a fixed set of texture units.
+    OGLTest::Shader shader{"Resources/Shaders/common.vert", OGLTest::MaterialLibrary::IsBindlessSupported()
+                                                                ? "Resources/Shaders/pointlight_bindless.frag"
+                                                                : "Resources/Shaders/pointlight.frag"};
+
+    OGLTest::Model model{modelPath, jobs, importSettings};
+    glm::mat4 modelMat = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
+    modelMat = glm::scale(modelMat, glm::vec3(1.0f, 1.0f, 1.0f));
+    model.SetTransform(modelMat);
+
+    const OGLTest::MemoryUsage modelMemory = model.GetMemoryUsage();
+    std::cout << "Model memory: " << (modelMemory.CpuBytes >> 10) << " KiB CPU, " << (modelMemory.GpuBytes >> 10)
+              << " KiB GPU" << '\n';
+
+    OGLTest::MeshImportStats importTotal;
+    for (OGLTest::UInt32 i = 0; i < model.GetImportStats().size(); i++) {
+        const OGLTest::MeshImportStats& stats = model.GetImportStats()[i];
+        if (importReport) {
+            std::cout << "Mesh " << i << ": " << stats.VerticesBefore << " -> " << stats.VerticesAfter << " vertices, "
+                      << stats.IndexCount << " indices, " << (stats.BytesBefore >> 10) << " -> "
+                      << (stats.BytesAfter >> 10) << " KiB" << '\n';
+        }
 
-    OGLTest::Model model{"Resources/Models/backpack/backpack.obj"};
+        importTotal.VerticesBefore += stats.VerticesBefore;
+        importTotal.VerticesAfter += stats.VerticesAfter;
+        importTotal.IndexCount += stats.IndexCount;
+        importTotal.BytesBefore += stats.BytesBefore;
+        importTotal.BytesAfter += stats.BytesAfter;
+    }
+    std::cout << "Welded vertices: " << importTotal.VerticesBefore << " -> " << importTotal.VerticesAfter
+              << ", geometry " << (importTotal.BytesBefore >> 10) << " -> " << (importTotal.BytesAfter >> 10) << " KiB"
+              << '\n';
 
-    g_CurrentTime = std::chrono::high_resolution_clock::now();
+    const OGLTest::AllocationStats scratch = model.GetImportScratchAllocations();
+    std::cout << "Import temporaries (" << (importSettings.UseImportArena ? "arena" : "heap") << "): "
+              << scratch.Allocations << " allocations, " << (scratch.PeakBytes >> 10) << " KiB peak" << '\n';
 
-    while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+    OGLTest::OcclusionCuller occlusionCuller;
+    OGLTest::OcclusionMode occlusionMode = occlusionCuller.GetMode();
 
-        auto oldTime = g_CurrentTime;
-        g_CurrentTime = std::chrono::high_resolution_clock::now();
-
-        std::chrono::duration<double, std::milli> timeSpan = (g_CurrentTime - oldTime);
-        g_DeltaTime = static_cast<OGLTest::Float32>(timeSpan.count() / 1000.0);
+    OGLTest::StreamingManager streaming{jobs};
+    if (!streamPath.empty()) {
+        streaming.Open(streamPath);
+    }
 
-        ProcessInput(window, g_DeltaTime);
+    OGLTest::ShadowRenderer shadows;
+    OGLTest::DynamicResolution resolution{resolutionSettings};
 
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // From here on, every GL call goes through the command lists executed by the scene renderer.
+    OGLTest::SceneRenderer sceneRenderer{shader, model, occlusionCuller, streaming, shadows, resolution};
+    // Everything until here is the loading of the capture.
+    glCapture.EndFrame();
 
-        shader.Use();
-        
-        glm::mat4 projection = glm::perspective(glm::radians(g_Camera.Fov),
-                                                static_cast<float>(WINDOW_WIDTH) / static_cast<float>(WINDOW_HEIGHT),
-                                                0.1f, 100.0f);        
-        glm::mat4 view = g_Camera.GetViewMatrix();
-        shader.Set("proj", projection);
-        shader.Set("view", view);
+    OGLTest::RenderThread renderThread{window, [&](const OGLTest::FrameSnapshot& snapshot) {
+        sceneRenderer.Execute(snapshot);
+        glCapture.EndFrame();
+    }, threadedRendering};
 
-        // render the loaded model
-        glm::mat4 modelMat = glm::mat4(1.0f);
-        modelMat = glm::translate(modelMat, glm::vec3(0.0f, 0.0f, 0.0f)); 
-        modelMat = glm::scale(modelMat, glm::vec3(1.0f, 1.0f, 1.0f));
-        shader.Set("model", modelMat);
+    OGLTest::Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+    OGLTest::UInt64 frameIndex = 0;
+    OGLTest::Float32 statsTimer = 0.0f;
+    OGLTest::FrameClock::time_point lastFrameStart = OGLTest::FrameClock::now();
 
-        shader.Set("light.position", -0.5f, 1.0f, 5.0f);
-        shader.Set("light.ambient", 0.05f, 0.025f, 0.025f);
-        shader.Set("light.diffuse", 0.75f, 0.5f, 0.25f);
-        shader.Set("light.specular", 1.5f, 1.5f, 1.5f);
-        shader.Set("light.constant", 1.0f);
-        shader.Set("light.linear", 0.09f);
-        shader.Set("light.quadratic", 0.032f);
-        
-        model.Draw(shader);
+    while (!glfwWindowShouldClose(window)) {
+        const OGLTest::FrameClock::time_point frameStart = OGLTest::FrameClock::now();
+        const OGLTest::Float32 deltaTime = std::chrono::duration<OGLTest::Float32>(frameStart - lastFrameStart).count();
+        lastFrameStart = frameStart;
 
-        glfwSwapBuffers(window);
+        glfwPollEvents();
+        jobs.RunMainThreadJobs();
+
+        camera.ProcessMouseMovement(input.MouseOffsetX, input.MouseOffsetY);
+        camera.ProcessMouseScroll(input.ScrollOffset);
+        input.MouseOffsetX = input.MouseOffsetY = input.ScrollOffset = 0.0f;
+
+        ProcessInput(window, deltaTime, camera, occlusionMode);
+        const OGLTest::FrameClock::time_point inputTime = OGLTest::FrameClock::now();
+
+        // The scaled scene keeps the aspect ratio of the window.
+        const OGLTest::Float32 aspect = static_cast<OGLTest::Float32>(std::max(input.Width, 1)) /
+                                        static_cast<OGLTest::Float32>(std::max(input.Height, 1));
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Fov), aspect, 0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        // record the frame, the render thread may still be executing the previous one
+        OGLTest::FrameSnapshot& frame = renderThread.BeginFrame();
+        frame.FrameIndex = frameIndex++;
+        frame.FrameStart = frameStart;
+        frame.InputTime = inputTime;
+        frame.DeltaTime = deltaTime;
+
+        OGLTest::RenderCommandList& commands = frame.Commands;
+        commands.Push(OGLTest::ViewportCommand{input.Width, input.Height});
+        commands.Push(OGLTest::ClearCommand{glm::vec4(0.1f, 0.1f, 0.1f, 1.0f)});
+        commands.Push(OGLTest::CameraCommand{projection, view, camera.Position});
+        commands.Push(OGLTest::PointLightCommand{glm::vec3(-0.5f, 1.0f, 5.0f), glm::vec3(0.05f, 0.025f, 0.025f),
+                                                 glm::vec3(0.75f, 0.5f, 0.25f), glm::vec3(1.5f, 1.5f, 1.5f),
+                                                 1.0f, 0.09f, 0.032f});
+        commands.Push(OGLTest::DirectionalLightCommand{glm::vec3(-0.3f, -1.0f, -0.4f), glm::vec3(0.3f, 0.28f, 0.25f)});
+        commands.Push(OGLTest::RenderShadowsCommand{!streamPath.empty()});
+        commands.Push(OGLTest::DrawModelCommand{occlusionMode});
+        if (input.PickRequested) {
+            const auto width = static_cast<OGLTest::Float32>(std::max(input.Width, 1));
+            const auto height = static_cast<OGLTest::Float32>(std::max(input.Height, 1));
+            commands.Push(OGLTest::PickCommand{camera.ScreenPointToRay(width * 0.5f, height * 0.5f, width, height)});
+            input.PickRequested = false;
+        }
+        if (!streamPath.empty()) {
+            commands.Push(OGLTest::DrawStreamingCommand{});
+        }
+        commands.Push(OGLTest::ResolveSceneCommand{});
+
+        renderThread.Submit();
+
+        // report the culling results and frame timings a couple of times per second
+        statsTimer += deltaTime;
+        if (statsTimer >= 0.5f) {
+            statsTimer = 0.0f;
+
+            const OGLTest::SceneStats sceneStats = sceneRenderer.GetStats();
+            const OGLTest::OcclusionStats& stats = sceneStats.Occlusion;
+            std::string title = "OpenGL Test - in frustum: " + std::to_string(stats.Candidates) +
+                                ", tested: " + std::to_string(stats.Tested) +
+                                ", occluded: " + std::to_string(stats.Occluded);
+
+            if (!streamPath.empty()) {
+                const OGLTest::ResidencyStats& residency = sceneStats.Residency;
+                title += " | chunks resident: " + std::to_string(residency.ResidentChunks) + "/" +
+                         std::to_string(residency.TotalChunks) + ", loading: " +
+                         std::to_string(residency.LoadingChunks) + ", queued: " +
+                         std::to_string(residency.QueuedChunks) + ", CPU: " +
+                         std::to_string(residency.CpuBytes >> 20) + " MiB, GPU: " +
+                         std::to_string(residency.GpuBytes >> 20) + " MiB";
+            }
+
+            const OGLTest::FrameTimings timings = renderThread.ConsumeTimings();
+            title += std::string(renderThread.IsThreaded() ? " | threaded" : " | single thread") +
+                     " - main: " + std::to_string(timings.MainCpuMs) + " ms, render: " +
+                     std::to_string(timings.RenderCpuMs) + " ms, input to present: " +
+                     std::to_string(timings.InputLatencyMs) + " ms";
+
+            const OGLTest::ShadowStats& shadowStats = sceneStats.Shadows;
+            title += " | shadow refreshes: " + std::to_string(shadowStats.StaticRefreshes) + ", pending: " +
+                     std::to_string(shadowStats.PendingRefreshes) + ", dynamic: " +
+                     std::to_string(shadowStats.DynamicComposites);
+
+            const OGLTest::ResolutionStats& resolutionStats = sceneStats.Resolution;
+            title += " | render scale: " + std::to_string(resolutionStats.Scale) + " (" +
+                     std::to_string(resolutionStats.RenderWidth) + "x" + std::to_string(resolutionStats.RenderHeight) +
+                     "), GPU: " + std::to_string(resolutionStats.GpuFrameMs) + " ms";
+
+            const OGLTest::RayHit& pick = sceneStats.LastPick;
+            if (sceneStats.PickCount > 0) {
+                title += pick.HasHit() ? " | picked mesh " + std::to_string(pick.MeshIndex) + ", triangle " +
+                                             std::to_string(pick.TriangleIndex) + " at " +
+                                             std::to_string(pick.Distance) + " units"
+                                       : std::string(" | picked nothing");
+            }
+
+            const OGLTest::GLCallStats callStats = glCapture.GetFrameStats();
+            title += " | GL calls: " + std::to_string(callStats.Calls) + ", draws: " +
+                     std::to_string(callStats.DrawCalls) + ", binds: " + std::to_string(callStats.Binds) +
+                     ", uploaded: " + std::to_string(callStats.UploadedBytes >> 10) + " KiB";
+
+            glfwSetWindowTitle(window, title.c_str());
+        }
     }
 
+    // the GL resources are destroyed on the main thread
+    renderThread.Stop();
+
     glfwDestroyWindow(window);
 
     glfwTerminate();
@@ -158,21 +499,32 @@ int main() {
     return 0;
 }
 
-void ProcessInput(GLFWwindow* window, const OGLTest::Float32 deltaTime) {
+void ProcessInput(GLFWwindow* window, const OGLTest::Float32 deltaTime, OGLTest::Camera& camera,
+                  OGLTest::OcclusionMode& occlusionMode) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
     }
 
+    if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS) {
+        occlusionMode = OGLTest::OcclusionMode::Hardware;
+    }
+    if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS) {
+        occlusionMode = OGLTest::OcclusionMode::Software;
+    }
+    if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS) {
+        occlusionMode = OGLTest::OcclusionMode::Disabled;
+    }
+
     if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS) {
-        g_Camera.ProcessKeyboard(OGLTest::CameraMovement::Forward, deltaTime);
+        camera.ProcessKeyboard(OGLTest::CameraMovement::Forward, deltaTime);
     }
     if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) {
-        g_Camera.ProcessKeyboard(OGLTest::CameraMovement::Backward, deltaTime);
+        camera.ProcessKeyboard(OGLTest::CameraMovement::Backward, deltaTime);
     }
     if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS) {
-        g_Camera.ProcessKeyboard(OGLTest::CameraMovement::Left, deltaTime);
+        camera.ProcessKeyboard(OGLTest::CameraMovement::Left, deltaTime);
     }
     if (glfwGetKey(window, GLFW_KEY_SEMICOLON) == GLFW_PRESS) {
-        g_Camera.ProcessKeyboard(OGLTest::CameraMovement::Right, deltaTime);
+        camera.ProcessKeyboard(OGLTest::CameraMovement::Right, deltaTime);
     }
 }
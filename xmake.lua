@@ -10,7 +10,7 @@ else
   add_defines("OGLTEST_DEBUG")
 end
 
-add_requires("glad", "glfw", "glm", "stb", "assimp")
+add_requires("glad", "glfw", "glm", "stb", "assimp", "cgltf")
 
 set_encodings("utf-8")
 set_exceptions("cxx")
@@ -40,7 +40,7 @@ target("OpenGLTest")
     
     add_includedirs("Include/", {public = true})
     
-    for _, ext in ipairs({".vert", ".frag", ".png", ".mtl", ".obj", ".jpg"}) do
+    for _, ext in ipairs({".vert", ".frag", ".png", ".mtl", ".obj", ".jpg", ".glb"}) do
       add_extrafiles("Resources/**" .. ext)
     end
 
@@ -48,4 +48,22 @@ target("OpenGLTest")
       set_pcxxheader("Include/OpenGLTest/pch.hpp")
     end
       
-    add_packages("glad", "glfw", "glm", "stb", "assimp")
+    add_packages("glad", "glfw", "glm", "stb", "assimp", "cgltf")
+
+-- Replays the captures of --capture without a window, through EGL.
+if is_plat("linux") then
+  target("GLReplay")
+      set_kind("binary")
+
+      add_files("Source/GLReplay/**.cpp")
+      add_files("Source/OpenGLTest/GLCapture.cpp", "Source/OpenGLTest/GLCaptureReader.cpp", "Source/OpenGLTest/MappedFile.cpp")
+
+      add_includedirs("Include/")
+
+      if has_config("use_pch") then
+        set_pcxxheader("Include/OpenGLTest/pch.hpp")
+      end
+
+      add_packages("glad")
+      add_syslinks("EGL")
+end